@@ -7,13 +7,16 @@
 # Set the path to where the source tree is stored
 INCLUDEPATH += c:/coding/LayOut
 
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET = LayOut
 TEMPLATE = app
 
+# Colour lookup tables are generated at compile time
+CONFIG += c++14
+
 # Icons
 RC_ICONS = res/icon48x48.ico   # Windows
 ICON     = res/icon48x48.icns  # Mac
@@ -23,8 +26,16 @@ SOURCES += main.cpp\
         import/romloader.cpp \
         roadedit/roadpathwidget.cpp \
         leveldata.cpp \
+        levelchanges.cpp \
         generatexml.cpp \
+        projectsnapshot.cpp \
+        projectfile.cpp \
+        savetask.cpp \
+        romtask.cpp \
+        journal.cpp \
         export/exportcannonball.cpp \
+        export/exportsnapshot.cpp \
+        export/exporttask.cpp \
         import/importoutrun.cpp \
         sprites/spritelist.cpp \
         sprites/spritesection.cpp \
@@ -33,16 +44,27 @@ SOURCES += main.cpp\
         preview/oroad.cpp \
         preview/hwroad.cpp \
         preview/renders16.cpp \
+        preview/previewrenderer.cpp \
+        preview/previewcache.cpp \
+        preview/spritebudget.cpp \
+        preview/overdrawprofiler.cpp \
+        preview/roadkernels.cpp \
         preview/osprite.cpp \
         preview/osprites.cpp \
         preview/olevelobjs.cpp \
+        preview/spriterom.cpp \
+        preview/spritepatterns.cpp \
         preview/hwsprites.cpp \
         height/heightwidget.cpp \
+        height/heightprofile.cpp \
+        height/heightprofilewidget.cpp \
         height/heightsection.cpp \
         import/importdialog.cpp \
         levelpalettewidget/levelpalettewidget.cpp \
         previewpalette.cpp \
         utils.cpp \
+        thumbnailcache.cpp \
+        s16colour.cpp \
         levels/levels.cpp \
         roadedit/roadpathscene.cpp \
         settings/settingsdialog.cpp \
@@ -53,8 +75,16 @@ HEADERS += mainwindow.h \
         stdint.hpp \
         roadedit/roadpathwidget.hpp \
         leveldata.hpp \
+        levelchanges.hpp \
         generatexml.hpp \
+        projectsnapshot.hpp \
+        projectfile.hpp \
+        savetask.hpp \
+        romtask.hpp \
+        journal.hpp \
         export/exportcannonball.hpp \
+        export/exportsnapshot.hpp \
+        export/exporttask.hpp \
         import/importbase.hpp \
         export/exportbase.hpp \
         import/importoutrun.hpp \
@@ -66,22 +96,34 @@ HEADERS += mainwindow.h \
         preview/hwroad.hpp \
         globals.hpp \
         preview/renders16.hpp \
+        preview/previewrenderer.hpp \
+        preview/previewcache.hpp \
+        preview/spritebudget.hpp \
+        preview/overdrawprofiler.hpp \
+        preview/roadkernels.hpp \
         preview/ozoom_lookup.hpp \
         preview/oentry.hpp \
         preview/osprites.hpp \
         preview/olevelobjs.hpp \
+        preview/spriterom.hpp \
+        preview/spritepatterns.hpp \
         preview/hwsprites.hpp \
         controlpoint.hpp \
         sprites/spriteformat.hpp \
         import/outrunlabels.hpp \
         height/heightwidget.hpp \
+        height/heightprofile.hpp \
+        height/heightprofilewidget.hpp \
         height/heightsection.hpp \
         height/heightlabels.hpp \
         import/importdialog.hpp \
         levelpalettewidget/levelpalettewidget.hpp \
         previewpalette.hpp \
         utils.hpp \
+        thumbnailcache.hpp \
+        s16colour.hpp \
         levels/levels.hpp \
+        levels/levelconstants.hpp \
         height/heightformat.hpp \
         roadedit/roadpathscene.hpp \
         settings/settingsdialog.hpp \
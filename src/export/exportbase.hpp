@@ -8,20 +8,36 @@
 #ifndef EXPORTBASE_HPP
 #define EXPORTBASE_HPP
 
-#include <QList>
+#include <QString>
 
-class QString;
-class Levels;
-struct HeightSegment;
-struct SpriteSectionEntry;
+struct ExportSnapshot;
+
+// Receives progress from an exporter.
+class ExportProgress
+{
+public:
+    virtual ~ExportProgress() {}
+
+    // Return false to cancel the export
+    virtual bool report(int done, int total) = 0;
+};
 
 class ExportBase
 {
 public:
-    virtual void write(QString& filename,
-                       Levels *levels,
-                       QList<HeightSegment> heightMaps,
-                       QList<SpriteSectionEntry> spriteMaps) = 0;
+    virtual ~ExportBase() {}
+
+    // Write the snapshot to a file. Safe to call from a worker thread.
+    // Returns false on failure or cancellation, in which case the file is left untouched.
+    virtual bool write(const QString& filename,
+                       const ExportSnapshot& snapshot,
+                       ExportProgress* progress = NULL) = 0;
+
+    // Reason for the last failure
+    QString getError() const { return error; }
+
+protected:
+    QString error;
 };
 
 #endif // EXPORTBASE_HPP
@@ -6,15 +6,15 @@
 ***************************************************************************/
 
 #include <iostream>
-#include <QFile>
+#include <QSaveFile>
 #include <QDataStream>
-#include <QMessageBox>
 #include <QtCore/qmath.h> // Sqrt
 
 #include "exportcannonball.hpp"
+#include "exportsnapshot.hpp"
 #include "../leveldata.hpp"
 #include "../stdint.hpp"
-#include "../levels/levels.hpp"
+#include "../levels/levelconstants.hpp"
 #include "../sprites/spriteformat.hpp"
 
 // MACROS: Helper Macros to output specfic data size
@@ -24,31 +24,42 @@
 #define outu16(x) out << (uint16_t) x; pos += sizeof(uint16_t)
 #define outu32(x) out << (uint32_t) x; pos += sizeof(uint32_t)
 
+// Progress steps: CPU 1 and CPU 0 data for each level, end sections, split and shared data
+const static int STEPS = (LEVELS * 2) + 1 + (LevelConstants::MAP_SLOTS - LEVELS) + 2 + 3;
+
 ExportCannonball::ExportCannonball()
 {
+    progress  = NULL;
+    stepsDone = 0;
 }
 
 ExportCannonball::~ExportCannonball(){}
 
 
-void ExportCannonball::write(QString& filename,
-                             Levels* levels,
-                             QList<HeightSegment> heightMaps,
-                             QList<SpriteSectionEntry> spriteMaps)
+// The file is written to a temporary location, and only replaces the original once complete.
+bool ExportCannonball::write(const QString& filename,
+                             const ExportSnapshot& snapshot,
+                             ExportProgress* progress)
 {
-    QFile file(filename);
+    this->progress  = progress;
+    this->stepsDone = 0;
+    error.clear();
+
+    QSaveFile file(filename);
 
     if (!file.open(QIODevice::WriteOnly))
     {
-        QMessageBox::warning(0, "Read only", "The file is in read only mode");
-        return;
+        error = "The file is in read only mode";
+        return false;
     }
 
     pos = 0;
     QDataStream out(&file);
     out.setByteOrder(QDataStream::BigEndian);
 
-    LevelData* splitLevel = levels->getSplit();
+    const ExportLevel& splitLevel               = snapshot.split;
+    const QList<HeightSegment>& heightMaps      = snapshot.heightMaps;
+    const QList<SpriteSectionEntry>& spriteMaps = snapshot.spriteMaps;
 
     // --------------------------------------------------------------------------------------------
     // Write Version Header & Settings
@@ -57,13 +68,13 @@ void ExportCannonball::write(QString& filename,
     const static bool VERBOSE = false;
 
     outu32(EXPORT_VERSION); // Header Version
-    outu8((levels->displayStartLine() ? 1 : 0));
+    outu8((snapshot.startLine ? 1 : 0));
 
     // --------------------------------------------------------------------------------------------
     // Write Master Header
     // --------------------------------------------------------------------------------------------
 
-    const static uint32_t HEADER = pos + ((Levels::MAP_SLOTS + 8) * sizeof(uint32_t));
+    const static uint32_t HEADER = pos + ((LevelConstants::MAP_SLOTS + 8) * sizeof(uint32_t));
 
     // [1] CPU 1 Path Data Offset (Only need the value for the start)
     int offset = HEADER;
@@ -76,7 +87,7 @@ void ExportCannonball::write(QString& filename,
     {
         if (VERBOSE) std::cout << std::hex << "Level Header: " << i << "," << offset << std::endl;
         outu32(offset);
-        offset += getLevelLength(levels->getMappedLevelP(i));
+        offset += getLevelLength(snapshot.mapped.at(i));
     }
 
     // End Sections CPU 1
@@ -84,11 +95,11 @@ void ExportCannonball::write(QString& filename,
     outu32(offset);
     offset += (LevelData::END_LENGTH_CPU1 * sizeof(uint32_t)); // End sections share the same road path
     // End Sections CPU 0
-    for (int i = LEVELS; i < Levels::MAP_SLOTS; i++)
+    for (int i = LEVELS; i < LevelConstants::MAP_SLOTS; i++)
     {
         if (VERBOSE) std::cout << std::hex << "End Section Header: " << i << "," << offset << std::endl;
         outu32(offset);
-        offset += getEndSectionLength(levels->getMappedLevelP(i));
+        offset += getEndSectionLength(snapshot.mapped.at(i));
     }
 
     // Split CPU 1
@@ -128,7 +139,8 @@ void ExportCannonball::write(QString& filename,
     if (VERBOSE) std::cout << std::hex << "Path Data Start: " << pos << std::endl;
     for (int i = 0; i < LEVELS; i++)
     {
-        writeCPU1Path(out, levels->getMappedLevelP(i), LevelData::LEVEL_LENGTH_CPU1);
+        writeCPU1Path(out, snapshot.mapped.at(i), LevelData::LEVEL_LENGTH_CPU1);
+        if (!step()) return cancel(file);
     }
 
     // --------------------------------------------------------------------------------------------
@@ -142,12 +154,12 @@ void ExportCannonball::write(QString& filename,
     for (int i = 0; i < LEVELS; i++)
     {
         if (VERBOSE) std::cout << std::hex << "Level Data Start: " << i << "," << pos << std::endl;
-        LevelData* level = levels->getMappedLevelP(i);
+        const ExportLevel& level = snapshot.mapped.at(i);
 
         // First step is to write level header
         const int DATA_START   = LEVEL_HEADER + pos;
-        const int CURVE_LENGTH = DATA_START + 38 + (3 * sizeof(uint16_t) * level->points->size()) + END_MARKER;
-        const int WIDTH_LENGTH = CURVE_LENGTH    + (4 * sizeof(uint16_t) * (level->widthP.size() + level->heightP.size())) + END_MARKER;
+        const int CURVE_LENGTH = DATA_START + 38 + (3 * sizeof(uint16_t) * level.points.size()) + END_MARKER;
+        const int WIDTH_LENGTH = CURVE_LENGTH    + (4 * sizeof(uint16_t) * (level.widthP.size() + level.heightP.size())) + END_MARKER;
 
         outu32(DATA_START);      // Sky Palette Entries
         outu32(DATA_START + 2);  // Road Stripe Centre Palette Entries
@@ -160,8 +172,8 @@ void ExportCannonball::write(QString& filename,
         outu32(WIDTH_LENGTH);    // Sprite Data
 
         // Write Level Palette Data
-        uint32_t* pal = level->pal->road[level->roadPal];
-        outu16(level->skyPal);
+        const uint32_t* pal = snapshot.pal.road[level.roadPal];
+        outu16(level.skyPal);
         outu32(pal[LevelPalette::CENTRE1]);
         outu32(pal[LevelPalette::CENTRE2]);
         outu32(pal[LevelPalette::STRIPE1]);
@@ -170,12 +182,13 @@ void ExportCannonball::write(QString& filename,
         outu32(pal[LevelPalette::SIDE2]);
         outu32(pal[LevelPalette::ROAD1]);
         outu32(pal[LevelPalette::ROAD2]);
-        outu16(level->gndPal);
-        outu16(level->gndPal);
+        outu16(level.gndPal);
+        outu16(level.gndPal);
 
         writeCurveData(out, level);
         writeWidthHeightData(out, level);
         writeSpriteData(out, level);
+        if (!step()) return cancel(file);
     }
 
     // --------------------------------------------------------------------------------------------
@@ -184,22 +197,23 @@ void ExportCannonball::write(QString& filename,
     // --------------------------------------------------------------------------------------------
 
     if (VERBOSE) std::cout << std::hex << "End Section CPU 1: " << pos << std::endl;
-    writeCPU1Path(out, levels->getMappedLevelP(LEVELS), LevelData::END_LENGTH_CPU1);
+    writeCPU1Path(out, snapshot.mapped.at(LEVELS), LevelData::END_LENGTH_CPU1);
+    if (!step()) return cancel(file);
 
     // --------------------------------------------------------------------------------------------
     // CPU 0 End Section Data: Write Path Info For All Sections
     // --------------------------------------------------------------------------------------------
     {
-        for (int i = LEVELS; i < Levels::MAP_SLOTS; i++)
+        for (int i = LEVELS; i < LevelConstants::MAP_SLOTS; i++)
         {
-            LevelData* level = levels->getMappedLevelP(i);
+            const ExportLevel& level = snapshot.mapped.at(i);
             if (VERBOSE) std::cout << std::hex << "End Section Start: " << i << "," << pos << std::endl;
             const static int LEVEL_HEADER = 3 * sizeof(uint32_t);
             const static int END_MARKER   = sizeof(uint16_t);
 
             const int DATA_START   = LEVEL_HEADER + pos;
-            const int CURVE_LENGTH = DATA_START   + (3 * sizeof(uint16_t) * level->points->size()) + END_MARKER;
-            const int WIDTH_LENGTH = CURVE_LENGTH + (4 * sizeof(uint16_t) * (level->widthP.size() + level->heightP.size())) + END_MARKER;
+            const int CURVE_LENGTH = DATA_START   + (3 * sizeof(uint16_t) * level.points.size()) + END_MARKER;
+            const int WIDTH_LENGTH = CURVE_LENGTH + (4 * sizeof(uint16_t) * (level.widthP.size() + level.heightP.size())) + END_MARKER;
 
             outu32(DATA_START);   // Curve Data
             outu32(CURVE_LENGTH); // Width/Height Data
@@ -208,6 +222,7 @@ void ExportCannonball::write(QString& filename,
             writeCurveData(out, level, true); // Note we invert the curve data for end sections to match the original game
             writeWidthHeightData(out, level);
             writeSpriteData(out, level);
+            if (!step()) return cancel(file);
         }
     }
 
@@ -216,6 +231,7 @@ void ExportCannonball::write(QString& filename,
     // --------------------------------------------------------------------------------------------
     if (VERBOSE) std::cout << std::hex << "Split CPU 1: " << pos << std::endl;
     writeCPU1Path(out, splitLevel, LevelData::SPLIT_LENGTH_CPU1);
+    if (!step()) return cancel(file);
 
     // --------------------------------------------------------------------------------------------
     // Split CPU 0
@@ -226,7 +242,7 @@ void ExportCannonball::write(QString& filename,
         const static int END_MARKER   = sizeof(uint16_t);
 
         const int DATA_START   = LEVEL_HEADER + pos;
-        const int CURVE_LENGTH = DATA_START   + (3 * sizeof(uint16_t) * splitLevel->points->size()) + END_MARKER;
+        const int CURVE_LENGTH = DATA_START   + (3 * sizeof(uint16_t) * splitLevel.points.size()) + END_MARKER;
         const int WIDTH_LENGTH = CURVE_LENGTH + (2 * sizeof(uint32_t)) + END_MARKER;
 
         outu32(DATA_START);   // Curve Data
@@ -238,6 +254,7 @@ void ExportCannonball::write(QString& filename,
         outu32(0);
         outu16(0x7FFF);
         writeSpriteData(out, splitLevel);
+        if (!step()) return cancel(file);
     }
 
 
@@ -245,6 +262,9 @@ void ExportCannonball::write(QString& filename,
     // Write Shared Mapping Data
     // --------------------------------------------------------------------------------------------
 
+    // Palettes are shared by all levels
+    const LevelPalette* sharedPal = &snapshot.pal;
+
     // Sky Palette Entries
     if (VERBOSE) std::cout << std::hex << "Sky Data Start: " << pos << std::endl;
 
@@ -262,7 +282,7 @@ void ExportCannonball::write(QString& filename,
         //std::cout << "write sky palette at: " << (pos ) << std::endl;
         for (int i = 0; i < LevelPalette::SKY_LENGTH; i++)
         {
-            outu32(levelData->pal->sky[pal][i]);
+            outu32(sharedPal->sky[pal][i]);
         }
     }
 
@@ -281,85 +301,104 @@ void ExportCannonball::write(QString& filename,
     {
         for (int i = 0; i < LevelPalette::GND_LENGTH; i++)
         {
-            outu32(levelData->pal->gnd[pal][i]);
+            outu32(sharedPal->gnd[pal][i]);
         }
     }
 
+    if (!step()) return cancel(file);
+
     if (VERBOSE) std::cout << std::hex << "Sprite Map Start: " << pos << std::endl;
     writeSpriteMaps(out, spriteMaps);
+    if (!step()) return cancel(file);
 
     if (VERBOSE) std::cout << std::hex << "Height Map Start: " << pos << std::endl;
     writeHeightMaps(out, heightMaps);
+    if (!step()) return cancel(file);
+
+    if (!file.commit())
+    {
+        error = "Unable to write " + filename;
+        return false;
+    }
 
-    file.close();
+    return true;
 }
 
-void ExportCannonball::writeCPU1Path(QDataStream& out, LevelData* level, const int length)
+// Report progress. Returns false if the export has been cancelled.
+bool ExportCannonball::step()
 {
-    const int finalX = level->path[level->end_pos-1].x();
-    const int finalY = level->path[level->end_pos-1].y();
+    stepsDone++;
+    return progress == NULL || progress->report(stepsDone, STEPS);
+}
 
-    // Fill horizon / remainder area of level with dummy data
-    for (int j = level->end_pos; j < length; j++)
-    {
-        level->path[j].setX(finalX);
-        level->path[j].setY(finalY);
-    }
+// Abandon the export, leaving any existing file in place
+bool ExportCannonball::cancel(QSaveFile& file)
+{
+    file.cancelWriting();
+    error = "Export cancelled";
+    return false;
+}
+
+// The snapshot path has already been padded with the final position for the horizon
+void ExportCannonball::writeCPU1Path(QDataStream& out, const ExportLevel& level, const int length)
+{
+    const QPoint final = level.path.isEmpty() ? QPoint() : level.path.last();
 
     for (int j = 0; j < length; j++)
     {
-        out16(level->path[j].x());
-        out16(level->path[j].y());
+        const QPoint p = j < level.path.size() ? level.path.at(j) : final;
+        out16(p.x());
+        out16(p.y());
     }
 }
 
-int ExportCannonball::getLevelLength(LevelData *level)
+int ExportCannonball::getLevelLength(const ExportLevel& level)
 {
     const static int LEVEL_HEADER = 9 * sizeof(uint32_t);
     const static int END_MARKER   = sizeof(uint16_t);
 
     int length = LEVEL_HEADER;
     length += (8 * sizeof(uint32_t)) + (3 * sizeof(uint16_t));                                      // Length of palettes
-    length += (3 * sizeof(uint16_t) * level->points->size()) + END_MARKER;                           // Length of curves
-    length += (4 * sizeof(uint16_t) * (level->widthP.size()  + level->heightP.size())) + END_MARKER; // Length of width/heights
-    length += (2 * sizeof(uint16_t) * level->spriteP.size()) + END_MARKER;                           // Length of sprites
+    length += (3 * sizeof(uint16_t) * level.points.size()) + END_MARKER;                           // Length of curves
+    length += (4 * sizeof(uint16_t) * (level.widthP.size()  + level.heightP.size())) + END_MARKER; // Length of width/heights
+    length += (2 * sizeof(uint16_t) * level.spriteP.size()) + END_MARKER;                           // Length of sprites
 
     return length;
 }
 
-int ExportCannonball::getEndSectionLength(LevelData *level)
+int ExportCannonball::getEndSectionLength(const ExportLevel& level)
 {
     const static int LEVEL_HEADER = 3 * sizeof(uint32_t);
     const static int END_MARKER   = sizeof(uint16_t);
 
     int length = LEVEL_HEADER;
-    length += (3 * sizeof(uint16_t) * level->points->size()) + END_MARKER;                           // Length of curves
-    length += (4 * sizeof(uint16_t) * (level->widthP.size()  + level->heightP.size())) + END_MARKER; // Length of width/heights
-    length += (2 * sizeof(uint16_t) * level->spriteP.size()) + END_MARKER;                           // Length of sprites
+    length += (3 * sizeof(uint16_t) * level.points.size()) + END_MARKER;                           // Length of curves
+    length += (4 * sizeof(uint16_t) * (level.widthP.size()  + level.heightP.size())) + END_MARKER; // Length of width/heights
+    length += (2 * sizeof(uint16_t) * level.spriteP.size()) + END_MARKER;                           // Length of sprites
 
     return length;
 }
 
-int ExportCannonball::getSplitLength(LevelData *level)
+int ExportCannonball::getSplitLength(const ExportLevel& level)
 {
     const static int LEVEL_HEADER = 3 * sizeof(uint32_t);
     const static int END_MARKER   = sizeof(uint16_t);
 
     int length = LEVEL_HEADER;
-    length += (3 * sizeof(uint16_t) * level->points->size()) + END_MARKER; // Length of curves
+    length += (3 * sizeof(uint16_t) * level.points.size()) + END_MARKER; // Length of curves
     length += (2 * sizeof(uint32_t))                         + END_MARKER; // Length of width/heights
-    length += (2 * sizeof(uint16_t) * level->spriteP.size()) + END_MARKER; // Length of sprites
+    length += (2 * sizeof(uint16_t) * level.spriteP.size()) + END_MARKER; // Length of sprites
 
     return length;
 }
 
-void ExportCannonball::writeCurveData(QDataStream& out, LevelData* level, bool invertCurve)
+void ExportCannonball::writeCurveData(QDataStream& out, const ExportLevel& level, bool invertCurve)
 {
-    foreach (PathPoint pp, (*level->points))
+    foreach (PathPoint pp, level.points)
     {
         // Curve Info: Average Distance Between Points On Curve
-        const QPoint p1 = level->path[pp.pos];
-        const QPoint p2 = level->path[pp.pos+1];
+        const QPoint p1 = level.path.value(pp.pos);
+        const QPoint p2 = level.path.value(pp.pos+1);
         const int xdiff = p2.x() - p1.x();
         const int ydiff = p2.y() - p1.y();
 
@@ -383,16 +422,16 @@ void ExportCannonball::writeCurveData(QDataStream& out, LevelData* level, bool i
     outu16(0xFFFF);
 }
 
-void ExportCannonball::writeWidthHeightData(QDataStream& out, LevelData* level)
+void ExportCannonball::writeWidthHeightData(QDataStream& out, const ExportLevel& level)
 {
     QList<ControlPoint> combined;
 
-    foreach (ControlPoint cp, level->widthP)
+    foreach (ControlPoint cp, level.widthP)
     {
         cp.type = 1; // width type
         insertAtPos(&combined, cp);
     }
-    foreach (ControlPoint cp, level->heightP)
+    foreach (ControlPoint cp, level.heightP)
     {
         cp.type = 0; // height type
         insertAtPos(&combined, cp);
@@ -411,9 +450,9 @@ void ExportCannonball::writeWidthHeightData(QDataStream& out, LevelData* level)
     outu16(0x7FFF);
 }
 
-void ExportCannonball::writeSpriteData(QDataStream& out, LevelData* level)
+void ExportCannonball::writeSpriteData(QDataStream& out, const ExportLevel& level)
 {
-    foreach (ControlPoint cp, level->spriteP)
+    foreach (ControlPoint cp, level.spriteP)
     {
         out16(cp.pos);
         outu8(cp.value1); // No of sprite in segment
@@ -437,7 +476,7 @@ void ExportCannonball::insertAtPos(QList<ControlPoint>* list, ControlPoint cp)
     list->insert(insert_pos, cp);
 }
 
-void ExportCannonball::writeHeightMaps(QDataStream &out, QList<HeightSegment> heightMaps)
+void ExportCannonball::writeHeightMaps(QDataStream &out, const QList<HeightSegment>& heightMaps)
 {
     // Start of actual data
     uint32_t heightMapData = pos + (heightMaps.size() * sizeof(uint32_t));
@@ -484,7 +523,7 @@ void ExportCannonball::writeHeightMaps(QDataStream &out, QList<HeightSegment> he
     }
 }
 
-void ExportCannonball::writeSpriteMaps(QDataStream &out, QList<SpriteSectionEntry> spriteMaps)
+void ExportCannonball::writeSpriteMaps(QDataStream &out, const QList<SpriteSectionEntry>& spriteMaps)
 {
     // Start of actual data
     uint32_t spriteMapData = pos + (spriteMaps.size() * sizeof(uint32_t));
@@ -516,7 +555,7 @@ void ExportCannonball::writeSpriteMaps(QDataStream &out, QList<SpriteSectionEntr
     }
 }
 
-int ExportCannonball::getSpriteMapLength(QList<SpriteSectionEntry> spriteMaps)
+int ExportCannonball::getSpriteMapLength(const QList<SpriteSectionEntry>& spriteMaps)
 {
     int length = spriteMaps.size() * sizeof(uint32_t);
     foreach (SpriteSectionEntry seg, spriteMaps)
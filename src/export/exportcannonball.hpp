@@ -11,8 +11,12 @@
 #include <QList>
 #include "exportbase.hpp"
 
-class LevelData;
+class QDataStream;
+class QSaveFile;
+struct ExportLevel;
 struct ControlPoint;
+struct HeightSegment;
+struct SpriteSectionEntry;
 
 class ExportCannonball : public ExportBase
 {
@@ -20,10 +24,9 @@ public:
     ExportCannonball();
     virtual ~ExportCannonball();
 
-    void write(QString& filename,
-               Levels *levels,
-               QList<HeightSegment> heightMaps,
-               QList<SpriteSectionEntry> spriteMaps);
+    bool write(const QString& filename,
+               const ExportSnapshot& snapshot,
+               ExportProgress* progress = NULL);
 
 private:
     // Exporter Version Number. Bump this when the header changes to avoid incompatibilities
@@ -32,17 +35,23 @@ private:
     // Position in stream
     int pos;
 
-    void writeCPU1Path(QDataStream& out, LevelData* level, const int length);
-    int getLevelLength(LevelData* level);
-    int getEndSectionLength(LevelData* level);
-    int getSplitLength(LevelData* level);
-    void writeCurveData(QDataStream& out, LevelData* level, bool invertCurve = false);
-    void writeWidthHeightData(QDataStream& out, LevelData* level);
+    // Progress through the export
+    ExportProgress* progress;
+    int stepsDone;
+
+    bool step();
+    bool cancel(QSaveFile& file);
+    void writeCPU1Path(QDataStream& out, const ExportLevel& level, const int length);
+    int getLevelLength(const ExportLevel& level);
+    int getEndSectionLength(const ExportLevel& level);
+    int getSplitLength(const ExportLevel& level);
+    void writeCurveData(QDataStream& out, const ExportLevel& level, bool invertCurve = false);
+    void writeWidthHeightData(QDataStream& out, const ExportLevel& level);
     void insertAtPos(QList<ControlPoint>* list, ControlPoint cp);
-    void writeSpriteData(QDataStream& out, LevelData* level);
-    void writeHeightMaps(QDataStream& out, QList<HeightSegment> heightMaps);
-    void writeSpriteMaps(QDataStream& out, QList<SpriteSectionEntry> spriteMaps);
-    int getSpriteMapLength(QList<SpriteSectionEntry> spriteMaps);
+    void writeSpriteData(QDataStream& out, const ExportLevel& level);
+    void writeHeightMaps(QDataStream& out, const QList<HeightSegment>& heightMaps);
+    void writeSpriteMaps(QDataStream& out, const QList<SpriteSectionEntry>& spriteMaps);
+    int getSpriteMapLength(const QList<SpriteSectionEntry>& spriteMaps);
 };
 
 #endif // EXPORTCANNONBALL_HPP
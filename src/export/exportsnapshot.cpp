@@ -0,0 +1,76 @@
+/***************************************************************************
+    Export Snapshot.
+
+    A frozen copy of everything an exporter needs. Built from a project
+    snapshot, so the export can run in the background whilst the project is
+    edited, or without the editor at all.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include "exportsnapshot.hpp"
+#include "../projectsnapshot.hpp"
+#include "../levels/levelconstants.hpp"
+
+ExportLevel::ExportLevel(const LevelData* level)
+{
+    points  = *level->points;
+    end_pos = level->end_pos;
+    widthP  = level->widthP;
+    spriteP = level->spriteP;
+    heightP = level->heightP;
+    skyPal  = level->skyPal;
+    gndPal  = level->gndPal;
+    roadPal = level->roadPal;
+
+    // Copy the full path buffer, including the area used for the horizon
+    const int size = level->length + LevelData::CPU1_EXTRA_LENGTH;
+    path.resize(size);
+
+    for (int i = 0; i < size; i++)
+        path[i] = level->path[i];
+
+    // Fill horizon / remainder area of level with the final position
+    if (end_pos > 0 && end_pos < size)
+    {
+        const QPoint final = path[end_pos - 1];
+
+        for (int i = end_pos; i < size; i++)
+            path[i] = final;
+    }
+}
+
+// The path is generated from the path points, as the editor does
+ExportLevel::ExportLevel(const ProjectLevel& level)
+{
+    LevelData data(NULL, level.type);
+    *data.points = level.points;
+    data.widthP  = level.widthP;
+    data.spriteP = level.spriteP;
+    data.heightP = level.heightP;
+    data.skyPal  = level.skyPal;
+    data.gndPal  = level.gndPal;
+    data.roadPal = level.roadPal;
+    data.updatePathData();
+
+    *this = ExportLevel(&data);
+}
+
+ExportSnapshot::ExportSnapshot(const ProjectSnapshot& project)
+{
+    startLine = project.startLine;
+
+    for (int i = 0; i < LevelConstants::MAP_SLOTS; i++)
+        mapped.push_back(ExportLevel(project.levels.at(project.mapping.at(i))));
+
+    foreach (const ProjectLevel& level, project.levels)
+    {
+        if (level.type == LevelConstants::SPLIT)
+            split = ExportLevel(level);
+    }
+
+    pal        = project.pal;
+    heightMaps = project.heightMaps;
+    spriteMaps = project.spriteMaps;
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+    Export Snapshot.
+
+    A frozen copy of everything an exporter needs. Built from a project
+    snapshot, so the export can run in the background whilst the project is
+    edited, or without the editor at all.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifndef EXPORTSNAPSHOT_HPP
+#define EXPORTSNAPSHOT_HPP
+
+#include <QList>
+#include <QVector>
+#include <QPoint>
+
+#include "../controlpoint.hpp"
+#include "../leveldata.hpp"
+#include "../levels/levelpalette.hpp"
+#include "../height/heightformat.hpp"
+#include "../sprites/spriteformat.hpp"
+
+struct ProjectSnapshot;
+struct ProjectLevel;
+
+// Copy of a single level
+struct ExportLevel
+{
+    QList<PathPoint> points;
+    QVector<QPoint> path;       // Road path. Padded with the final position beyond end_pos.
+    int end_pos;
+    QList<ControlPoint> widthP;
+    QList<ControlPoint> spriteP;
+    QList<ControlPoint> heightP;
+    uint16_t skyPal;
+    uint16_t gndPal;
+    uint16_t roadPal;
+
+    ExportLevel() : end_pos(0), skyPal(0), gndPal(0), roadPal(0) {}
+    explicit ExportLevel(const LevelData* level);
+    explicit ExportLevel(const ProjectLevel& level);
+};
+
+struct ExportSnapshot
+{
+    bool startLine;                          // Display start line
+    QList<ExportLevel> mapped;               // Level in each map slot
+    ExportLevel split;
+    LevelPalette pal;                        // Palettes shared by all levels
+    QList<HeightSegment> heightMaps;
+    QList<SpriteSectionEntry> spriteMaps;
+
+    // Levels are mapped from the project, and their paths generated
+    explicit ExportSnapshot(const ProjectSnapshot& project);
+};
+
+#endif // EXPORTSNAPSHOT_HPP
@@ -0,0 +1,75 @@
+/***************************************************************************
+    Export Task.
+
+    Runs an export in the background. The project is copied when the task
+    is created, so it can continue to be edited whilst the file is written.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <QtConcurrent>
+#include "exportsnapshot.hpp"
+#include "exporttask.hpp"
+
+ExportTask::ExportTask(QObject* parent,
+                       ExportBase* exporter,
+                       const QString& filename,
+                       Levels* levels,
+                       HeightSection* heightSection,
+                       SpriteSection* spriteSection) :
+    QObject(parent),
+    project(levels, heightSection, spriteSection)
+{
+    this->exporter = exporter;
+    this->filename = filename;
+
+    connect(&watcher, SIGNAL(finished()), this, SLOT(done()));
+}
+
+ExportTask::~ExportTask()
+{
+    cancel();
+    wait();
+    delete exporter;
+}
+
+void ExportTask::start()
+{
+    cancelled.storeRelease(0);
+    watcher.setFuture(QtConcurrent::run(this, &ExportTask::run));
+}
+
+void ExportTask::wait()
+{
+    watcher.waitForFinished();
+}
+
+bool ExportTask::isRunning() const
+{
+    return watcher.isRunning();
+}
+
+void ExportTask::cancel()
+{
+    cancelled.storeRelease(1);
+}
+
+// Level paths are generated from the project here, off the GUI thread
+bool ExportTask::run()
+{
+    const ExportSnapshot snapshot(project);
+    return exporter->write(filename, snapshot, this);
+}
+
+// Progress is delivered to the GUI thread as a queued signal
+bool ExportTask::report(int done, int total)
+{
+    emit progress(done, total);
+    return cancelled.loadAcquire() == 0;
+}
+
+void ExportTask::done()
+{
+    emit finished(watcher.result());
+}
@@ -0,0 +1,65 @@
+/***************************************************************************
+    Export Task.
+
+    Runs an export in the background. The project is copied when the task
+    is created, so it can continue to be edited whilst the file is written.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifndef EXPORTTASK_HPP
+#define EXPORTTASK_HPP
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+
+#include "exportbase.hpp"
+#include "../projectsnapshot.hpp"
+
+class ExportTask : public QObject, public ExportProgress
+{
+    Q_OBJECT
+
+public:
+    // Takes ownership of the exporter
+    ExportTask(QObject* parent,
+               ExportBase* exporter,
+               const QString& filename,
+               Levels* levels,
+               HeightSection* heightSection,
+               SpriteSection* spriteSection);
+    ~ExportTask();
+
+    void start();
+    void wait();
+    bool isRunning() const;
+    QString getFilename() const { return filename; }
+    QString getError() const    { return exporter->getError(); }
+
+    // Called from the worker thread
+    bool report(int done, int total);
+
+signals:
+    void progress(int done, int total);
+    void finished(bool success);
+
+public slots:
+    void cancel();
+
+private slots:
+    void done();
+
+private:
+    ExportBase* exporter;
+    QString filename;
+    const ProjectSnapshot project;
+
+    QAtomicInt cancelled;
+    QFutureWatcher<bool> watcher;
+
+    bool run();
+};
+
+#endif // EXPORTTASK_HPP
@@ -3,6 +3,9 @@
 
     Features:
     - Load & Save Project to XML File.
+    - Projects are saved from a snapshot, so can be written on any thread.
+      The file is written to a temporary file which then replaces it.
+    - The file format itself is handled by ProjectFile.
 
     References:
     http://www.developer.nokia.com/Community/Wiki/Generate_XML_programatically_in_Qt
@@ -17,13 +20,10 @@
 #include <QList>
 #include "stdint.hpp"
 
-class QXmlStreamAttributes;
-class QXmlStreamReader;
-class QXmlStreamWriter;
 class QString;
+struct ProjectSnapshot;
 
 class Levels;
-class LevelData;
 class HeightSection;
 struct HeightSegment;
 class SpriteSection;
@@ -38,31 +38,13 @@ public:
     void saveProject(QString& filename);
 
 private:
-    // Internal LayOut Save Format
-    const static int SAVE_VERSION = 1;
-
     Levels* levels;
     HeightSection* heightSection;
     SpriteSection* spriteSection;
     QList<HeightSegment>* heightSections;
     QList<SpriteSectionEntry>* spriteSections;
 
-    void readSettings(QXmlStreamReader& stream);
-    void readLevelMappingData(QXmlStreamReader& stream);
-    void readLevelList(QXmlStreamReader& stream);
-    void readPathData(QXmlStreamReader& stream);
-    void readWidthData(QXmlStreamReader& stream);
-    void readHeightData(QXmlStreamReader& stream);
-    void readHeightMapData(QXmlStreamReader& stream);
-    void readSceneryData(QXmlStreamReader& stream);
-    void readSceneryPatternData(QXmlStreamReader& stream);
-    void readSharedPalettes(QXmlStreamReader& stream);
-
-    void writeLevel(QXmlStreamWriter& stream, int index);
-    void writePalette(QXmlStreamWriter& stream, const QString& name, uint32_t *data, const int pals, const int length);
-
-    int getAttInt(QXmlStreamAttributes &att, QString s);
-    QString getAttString(QXmlStreamAttributes &att, QString s);
+    void applyProject(const ProjectSnapshot& project);
 };
 
 #endif // GENERATEXML_H
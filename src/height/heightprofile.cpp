@@ -0,0 +1,305 @@
+/***************************************************************************
+    Height Profile.
+
+    Evaluates the height sections of a level at every road position in a
+    single pass, rather than one position at a time as the preview does.
+
+    Each height point covers the road until the next height point. Only the
+    spans whose position, length or pattern have changed are evaluated
+    again when the level is edited.
+
+    Heights are relative to the start of each section, as in the game.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <algorithm>
+#include <iostream>
+
+#include "../globals.hpp"
+#include "../leveldata.hpp"
+#include "heightprofile.hpp"
+
+// Length of each segment (see PreviewRenderer::updateRoadHeight)
+const static double POS_LENGTH = 10 * 12;
+
+HeightProfile::HeightProfile()
+{
+    level     = NULL;
+    sections  = NULL;
+    minHeight = 0;
+    maxHeight = 0;
+}
+
+void HeightProfile::setLevel(const LevelData* level, const QList<HeightSegment>* sections)
+{
+    this->level    = level;
+    this->sections = sections;
+    invalidate();
+}
+
+// The data of a height pattern has changed
+void HeightProfile::invalidatePattern(int index)
+{
+    for (int i = 0; i < spans.size(); i++)
+    {
+        if (index < 0 || spans[i].pattern == index)
+            spans[i].valid = false;
+    }
+}
+
+void HeightProfile::invalidate()
+{
+    spans.clear();
+}
+
+// Bring the profile up to date with the level.
+// Returns true if it has changed.
+bool HeightProfile::update()
+{
+    if (level == NULL || sections == NULL)
+        return false;
+
+    bool changed = false;
+    const int length = level->end_pos;
+
+    if (heights.size() != length)
+    {
+        heights.resize(length);
+        horizons.resize(length);
+        heights.fill(0);
+        spans.clear();
+        changed = true;
+    }
+
+    // Road before the first height point is flat
+    const int first = level->heightP.isEmpty() ? length : qBound(0, level->heightP.first().pos, length);
+    std::fill(heights.begin(), heights.begin() + first, 0);
+
+    QVector<Span> current;
+    current.reserve(level->heightP.size());
+
+    // Previous spans are matched by position, so inserting a height point only evaluates its neighbours
+    int old = 0;
+
+    for (int i = 0; i < level->heightP.size(); i++)
+    {
+        Span span;
+        span.pos     = qBound(0, level->heightP.at(i).pos, length);
+        span.end     = i + 1 < level->heightP.size() ? qBound(span.pos, level->heightP.at(i + 1).pos, length) : length;
+        span.pattern = level->heightP.at(i).value1;
+        span.valid   = true;
+
+        while (old < spans.size() && spans[old].pos < span.pos)
+            old++;
+
+        const bool unchanged = old < spans.size() &&
+                               spans[old].valid &&
+                               spans[old].pos == span.pos &&
+                               spans[old].end == span.end &&
+                               spans[old].pattern == span.pattern;
+
+        if (!unchanged)
+        {
+            evaluate(span);
+            changed = true;
+        }
+
+        current.push_back(span);
+    }
+
+    if (spans.size() != current.size())
+        changed = true;
+
+    spans = current;
+
+    if (!changed)
+        return false;
+
+    evaluateHorizon();
+
+    minHeight = 0;
+    maxHeight = 0;
+    foreach (int16_t h, heights)
+    {
+        minHeight = qMin(minHeight, h);
+        maxHeight = qMax(maxHeight, h);
+    }
+
+    if (DEBUG)
+        std::cout << "HeightProfile: " << spans.size() << " spans, range " << minHeight << " to " << maxHeight << std::endl;
+
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Evaluation. Each section writes its height from the start of its span, and is flat once it ends.
+// ------------------------------------------------------------------------------------------------
+
+void HeightProfile::evaluate(const Span& span)
+{
+    int16_t* out = heights.data() + span.pos;
+    const int length = span.end - span.pos;
+
+    std::fill(out, out + length, 0);
+
+    if (span.pattern < 0 || span.pattern >= sections->size())
+        return;
+
+    const HeightSegment& seg = sections->at(span.pattern);
+
+    if (seg.step <= 0)
+        return;
+
+    switch (seg.type)
+    {
+        case 0:
+            evaluateHeightMap(seg, out, length);
+            break;
+
+        case 1:
+        case 2:
+            evaluateHold(seg, out, length);
+            break;
+
+        case 3:
+            evaluateMixedHold(seg, out, length);
+            break;
+
+        // Horizon changes leave the road flat
+        case 4:
+            break;
+    }
+}
+
+// Type 0: Each entry is the change in height from the last, and entries vary in length
+// depending on whether the road is rising or falling.
+void HeightProfile::evaluateHeightMap(const HeightSegment& seg, int16_t* out, int length)
+{
+    if (seg.data.size() < 2)
+        return;
+
+    int entry    = -1;
+    double start = 0;   // Position the entry starts
+    double end   = 0;   // Position the entry ends
+    int heightA  = 0;   // Height at the start of the entry
+    int heightB  = seg.data.at(0);
+
+    for (int pos = 0; pos < length; pos++)
+    {
+        // Advance to the entry containing this position
+        while (pos >= end)
+        {
+            if (++entry >= seg.data.size() - 1)
+                return;
+
+            const int16_t v = seg.data.at(entry);
+            double segLength;
+
+            if (v == 0)     segLength = POS_LENGTH / seg.step;
+            else if (v < 0) segLength = POS_LENGTH / (seg.step * qMax(seg.value1, 1));
+            else            segLength = POS_LENGTH / (seg.step * qMax(seg.value2, 1));
+
+            heightA = heightB;
+            heightB = heightA + seg.data.at(entry + 1);
+            start   = end;
+            end    += HEIGHT_LENGTH / segLength;
+        }
+
+        out[pos] = heightA + ((heightB - heightA) * (pos - start)) / (end - start);
+    }
+}
+
+// Types 1 and 2: Rise to the first height, hold it for a delay and then move to the second.
+void HeightProfile::evaluateHold(const HeightSegment& seg, int16_t* out, int length)
+{
+    if (seg.data.size() < 2)
+        return;
+
+    const int y1 = seg.data.at(0);
+    const int y2 = seg.data.at(1);
+
+    // As with the preview, the length of the delay is an approximation
+    const double segLength   = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
+    const double delayLength = seg.value1 / (POS_LENGTH / seg.step);
+    const double segLength2  = segLength + delayLength;
+    const double segLength3  = segLength2 + segLength;
+
+    for (int pos = 0; pos < length && pos < segLength3; pos++)
+    {
+        if (pos < segLength)
+            out[pos] = (y1 * pos) / segLength;
+        else if (pos < segLength2)
+            out[pos] = y1;
+        else
+            out[pos] = y1 + ((y2 - y1) * (pos - segLength2)) / segLength;
+    }
+}
+
+// Type 3: Six entries of fixed length, a hold on the seventh, then a return to the start height.
+void HeightProfile::evaluateMixedHold(const HeightSegment& seg, int16_t* out, int length)
+{
+    const static int ENTRIES = 6;
+
+    if (seg.data.size() <= ENTRIES)
+        return;
+
+    const double segLength   = HEIGHT_LENGTH / (POS_LENGTH / 4); // step is hard-coded to 4
+    const double delayLength = seg.value1 / (POS_LENGTH / seg.step);
+    const double endLength   = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
+    const double segLength2  = (segLength * ENTRIES) + delayLength;
+    const double segLength3  = segLength2 + endLength;
+
+    int heights[ENTRIES + 1];
+    heights[0] = seg.data.at(0);
+    for (int i = 1; i <= ENTRIES; i++)
+        heights[i] = heights[i - 1] + seg.data.at(i);
+
+    for (int pos = 0; pos < length && pos < segLength3; pos++)
+    {
+        if (pos < segLength * ENTRIES)
+        {
+            const int entry    = pos / segLength;
+            const double start = entry * segLength;
+            out[pos] = heights[entry] + ((heights[entry + 1] - heights[entry]) * (pos - start)) / segLength;
+        }
+        else if (pos < segLength2)
+            out[pos] = heights[ENTRIES];
+        else
+            out[pos] = heights[ENTRIES] - (heights[ENTRIES] * (pos - segLength2)) / endLength;
+    }
+}
+
+// The horizon carries over between sections, so is evaluated over the whole level.
+// Each horizon change moves to its new value over the length of its section.
+void HeightProfile::evaluateHorizon()
+{
+    int horizon = HORIZON_DEFAULT;
+    int pos = 0;
+
+    foreach (Span span, spans)
+    {
+        if (span.pattern < 0 || span.pattern >= sections->size())
+            continue;
+
+        const HeightSegment& seg = sections->at(span.pattern);
+
+        if (seg.type != 4 || seg.step <= 0)
+            continue;
+
+        for (; pos < span.pos; pos++)
+            horizons[pos] = horizon;
+
+        const double segLength = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
+        const int target = seg.value1;
+
+        for (int i = 0; pos < horizons.size() && i < segLength; pos++, i++)
+            horizons[pos] = horizon + ((target - horizon) * i) / segLength;
+
+        horizon = target;
+    }
+
+    for (; pos < horizons.size(); pos++)
+        horizons[pos] = horizon;
+}
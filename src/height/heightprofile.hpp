@@ -0,0 +1,78 @@
+/***************************************************************************
+    Height Profile.
+
+    Evaluates the height sections of a level at every road position in a
+    single pass, rather than one position at a time as the preview does.
+
+    Each height point covers the road until the next height point. Only the
+    spans whose position, length or pattern have changed are evaluated
+    again when the level is edited.
+
+    Heights are relative to the start of each section, as in the game.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifndef HEIGHTPROFILE_HPP
+#define HEIGHTPROFILE_HPP
+
+#include <QList>
+#include <QVector>
+
+#include "../stdint.hpp"
+#include "heightformat.hpp"
+
+class LevelData;
+
+class HeightProfile
+{
+public:
+    // Horizon at the start of a level
+    const static int16_t HORIZON_DEFAULT = 0x240;
+
+    HeightProfile();
+
+    void setLevel(const LevelData* level, const QList<HeightSegment>* sections);
+    void invalidatePattern(int index);
+    void invalidate();
+    bool update();
+
+    int length() const                  { return heights.size(); }
+    int16_t heightAt(int pos) const     { return heights.at(pos); }
+    int16_t horizonAt(int pos) const    { return horizons.at(pos); }
+    int16_t getMinHeight() const        { return minHeight; }
+    int16_t getMaxHeight() const        { return maxHeight; }
+
+private:
+    const static bool DEBUG = false;
+
+    // Road covered by a single height point
+    struct Span
+    {
+        int pos;
+        int end;
+        int pattern;
+        bool valid;
+    };
+
+    const LevelData* level;
+    const QList<HeightSegment>* sections;
+
+    QVector<Span> spans;
+
+    // Height and horizon at each road position
+    QVector<int16_t> heights;
+    QVector<int16_t> horizons;
+
+    int16_t minHeight;
+    int16_t maxHeight;
+
+    void evaluate(const Span& span);
+    void evaluateHeightMap(const HeightSegment& seg, int16_t* out, int length);
+    void evaluateHold(const HeightSegment& seg, int16_t* out, int length);
+    void evaluateMixedHold(const HeightSegment& seg, int16_t* out, int length);
+    void evaluateHorizon();
+};
+
+#endif // HEIGHTPROFILE_HPP
@@ -0,0 +1,185 @@
+/***************************************************************************
+    Height Profile Widget.
+
+    Strip showing the height of the road and the horizon across the whole
+    of the active level, with the current road position marked.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <QtWidgets>
+
+#include "../levelchanges.hpp"
+#include "heightprofilewidget.hpp"
+
+HeightProfileWidget::HeightProfileWidget(QWidget *parent) :
+    QWidget(parent)
+{
+    position   = 0;
+    imageDirty = true;
+
+    setMinimumHeight(STRIP_HEIGHT);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+QSize HeightProfileWidget::sizeHint() const
+{
+    return QSize(256, STRIP_HEIGHT);
+}
+
+void HeightProfileWidget::setChanges(LevelChanges* changes)
+{
+    connect(changes, SIGNAL(pathChanged(int,int)),      this, SLOT(refresh()));
+    connect(changes, SIGNAL(heightPointsChanged()),     this, SLOT(refresh()));
+    connect(changes, SIGNAL(heightPatternChanged(int)), this, SLOT(patternChanged(int)));
+    connect(changes, SIGNAL(levelChanged()),            this, SLOT(refresh()));
+}
+
+void HeightProfileWidget::setLevel(const LevelData* level, const QList<HeightSegment>* sections)
+{
+    profile.setLevel(level, sections);
+    refresh();
+}
+
+void HeightProfileWidget::setPosition(int pos)
+{
+    if (position != pos)
+    {
+        update(toX(position), 0, 1, height());
+        position = pos;
+        update(toX(position), 0, 1, height());
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Change Tracking
+// ------------------------------------------------------------------------------------------------
+
+void HeightProfileWidget::patternChanged(int index)
+{
+    profile.invalidatePattern(index == LevelChanges::ALL_PATTERNS ? -1 : index);
+    refresh();
+}
+
+// Height points are compared against the last evaluation, so only the changed spans are redone
+void HeightProfileWidget::refresh()
+{
+    if (profile.update())
+    {
+        imageDirty = true;
+        update();
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Rendering
+// ------------------------------------------------------------------------------------------------
+
+int HeightProfileWidget::toX(int pos) const
+{
+    if (profile.length() <= 1)
+        return 0;
+
+    return (pos * (width() - 1)) / (profile.length() - 1);
+}
+
+int HeightProfileWidget::toPos(int x) const
+{
+    if (width() <= 1)
+        return 0;
+
+    return qBound(0, (x * (profile.length() - 1)) / (width() - 1), qMax(profile.length() - 1, 0));
+}
+
+void HeightProfileWidget::drawProfile()
+{
+    image = QImage(width(), height(), QImage::Format_RGB32);
+    imageDirty = false;
+
+    QPainter painter(&image);
+    const int HH = height() / 2;
+
+    // Draw Background (As HeightWidget)
+    painter.fillRect(0, 0,  width(), HH, QColor(0x01, 0x6F, 0xAC));
+    painter.fillRect(0, HH, width(), height() - HH, QColor(0x01, 0x54, 0x7E));
+
+    const int length = profile.length();
+    if (length < 2)
+        return;
+
+    // Scale heights symmetrically around the centre line
+    const int range   = qMax(qMax(qAbs((int) profile.getMinHeight()), qAbs((int) profile.getMaxHeight())), 1);
+    const double yGap = (double) range / (HH - 2);
+
+    int horizonMin = profile.horizonAt(0);
+    int horizonMax = horizonMin;
+    for (int pos = 1; pos < length; pos++)
+    {
+        horizonMin = qMin(horizonMin, (int) profile.horizonAt(pos));
+        horizonMax = qMax(horizonMax, (int) profile.horizonAt(pos));
+    }
+
+    // One column per pixel, using the position at the start of each column
+    QPolygon road;
+    QPolygon horizon;
+    road << QPoint(0, HH);
+
+    for (int x = 0; x < width(); x++)
+    {
+        const int pos = toPos(x);
+        road << QPoint(x, HH - (profile.heightAt(pos) / yGap));
+
+        if (horizonMax != horizonMin)
+            horizon << QPoint(x, height() - 2 - (((profile.horizonAt(pos) - horizonMin) * (height() - 4)) / (horizonMax - horizonMin)));
+    }
+
+    road << QPoint(width() - 1, HH);
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QColor(0xB4, 0xD2, 0xE6));
+    painter.setBrush(QColor(0x34, 0x8C, 0xBC));
+    painter.drawPolygon(road);
+
+    // Horizon changes
+    if (!horizon.isEmpty())
+    {
+        QPen pen(QColor(0xFF, 0xD0, 0x40));
+        pen.setStyle(Qt::DashLine);
+        painter.setPen(pen);
+        painter.drawPolyline(horizon);
+    }
+}
+
+void HeightProfileWidget::paintEvent(QPaintEvent *event)
+{
+    if (imageDirty || image.size() != size())
+        drawProfile();
+
+    QPainter painter(this);
+    QRect dirtyRect = event->rect();
+    painter.drawImage(dirtyRect, image, dirtyRect);
+
+    // Current Position
+    painter.setPen(QColor(0xFF, 0x40, 0x40));
+    const int x = toX(position);
+    painter.drawLine(x, 0, x, height());
+}
+
+void HeightProfileWidget::resizeEvent(QResizeEvent *event)
+{
+    imageDirty = true;
+    QWidget::resizeEvent(event);
+}
+
+void HeightProfileWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        emit positionSelected(toPos(event->x()));
+}
+
+void HeightProfileWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton)
+        emit positionSelected(toPos(event->x()));
+}
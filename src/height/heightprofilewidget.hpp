@@ -0,0 +1,63 @@
+/***************************************************************************
+    Height Profile Widget.
+
+    Strip showing the height of the road and the horizon across the whole
+    of the active level, with the current road position marked.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifndef HEIGHTPROFILEWIDGET_HPP
+#define HEIGHTPROFILEWIDGET_HPP
+
+#include <QWidget>
+#include <QImage>
+
+#include "heightprofile.hpp"
+
+class LevelChanges;
+
+class HeightProfileWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit HeightProfileWidget(QWidget *parent = 0);
+    void setChanges(LevelChanges* changes);
+    void setLevel(const LevelData* level, const QList<HeightSegment>* sections);
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+
+signals:
+    void positionSelected(int);
+
+public slots:
+    void setPosition(int pos);
+
+private slots:
+    void patternChanged(int index);
+    void refresh();
+
+private:
+    const static int STRIP_HEIGHT = 64;
+
+    HeightProfile profile;
+
+    // Profile drawn at the current size
+    QImage image;
+    bool imageDirty;
+
+    // Current road position
+    int position;
+
+    void drawProfile();
+    int toX(int pos) const;
+    int toPos(int x) const;
+};
+
+#endif // HEIGHTPROFILEWIDGET_HPP
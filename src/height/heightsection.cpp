@@ -11,6 +11,7 @@
 
 #include "heightsection.hpp"
 #include "../levels/levels.hpp"
+#include "../thumbnailcache.hpp"
 
 HeightSection::HeightSection(QObject *parent, QList<HeightSegment>* sectionList, QListView* view, Levels *levels) :
     QObject(parent)
@@ -18,6 +19,7 @@ HeightSection::HeightSection(QObject *parent, QList<HeightSegment>* sectionList,
     this->sectionList = sectionList; // List of height sections
     this->view        = view;        // UI: The List view visualizing the sprites that the user can select them from
     this->levels      = levels;      // Height points are shared between levels
+    this->thumbnails  = NULL;
 
     // Setup List View (Note in QT models should not be stored.)
     view->setModel(new QStandardItemModel());
@@ -40,6 +42,8 @@ void HeightSection::generate()
 
     heightPoint = -1;
 
+    levels->getChanges()->notifyHeightPattern();
+
     emit setDeleteSecBut(sectionList->size() > 1);
     emit setInsertSecBut(sectionList->size() < 255);
 }
@@ -68,6 +72,42 @@ HeightSegment* HeightSection::getCurrentSection()
         return &(*sectionList)[index.row()];
 }
 
+// Report an edit to the selected section
+void HeightSection::sectionChanged()
+{
+    QModelIndex index = view->selectionModel()->currentIndex();
+
+    if (index.isValid())
+        levels->getChanges()->notifyHeightPattern(index.row());
+
+    emit refreshPreview();
+}
+
+void HeightSection::setThumbnails(ThumbnailCache* thumbnails)
+{
+    this->thumbnails = thumbnails;
+    view->setIconSize(QSize(ThumbnailCache::PATTERN_WIDTH, ThumbnailCache::PATTERN_HEIGHT));
+    connect(levels->getChanges(), SIGNAL(heightPatternChanged(int)), this, SLOT(updateThumbnails(int)));
+    updateThumbnails(LevelChanges::ALL_PATTERNS);
+}
+
+void HeightSection::updateThumbnails(int index)
+{
+    if (thumbnails == NULL)
+        return;
+
+    QStandardItemModel* model = (QStandardItemModel*) view->model();
+    const int rows = qMin(model->rowCount(), sectionList->size());
+
+    if (index == LevelChanges::ALL_PATTERNS)
+    {
+        for (int i = 0; i < rows; i++)
+            thumbnails->setHeightThumbnail(model->item(i), sectionList->at(i));
+    }
+    else if (index < rows)
+        thumbnails->setHeightThumbnail(model->item(index), sectionList->at(index));
+}
+
 QList<HeightSegment>* HeightSection::getSectionList()
 {
     return sectionList;
@@ -98,29 +138,41 @@ void HeightSection::setSectionName(int sectionIndex, QString text)
 void HeightSection::setStretch(int value)
 {
     HeightSegment* currentSection = getCurrentSection();
-    currentSection->step = value;
-    emit refreshPreview();
+    if (currentSection->step != value)
+    {
+        currentSection->step = value;
+        sectionChanged();
+    }
 }
 
 void HeightSection::setStretchUp(int value)
 {
     HeightSegment* currentSection = getCurrentSection();
-    currentSection->value1 = value;
-    emit refreshPreview();
+    if (currentSection->value1 != value)
+    {
+        currentSection->value1 = value;
+        sectionChanged();
+    }
 }
 
 void HeightSection::setStretchDown(int value)
 {
     HeightSegment* currentSection = getCurrentSection();
-    currentSection->value2 = value;
-    emit refreshPreview();
+    if (currentSection->value2 != value)
+    {
+        currentSection->value2 = value;
+        sectionChanged();
+    }
 }
 
 void HeightSection::setDelay(int value)
 {
     HeightSegment* currentSection = getCurrentSection();
-    currentSection->value1 = value;
-    emit refreshPreview();
+    if (currentSection->value1 != value)
+    {
+        currentSection->value1 = value;
+        sectionChanged();
+    }
 }
 
 void HeightSection::setHeightPoint(int pos)
@@ -137,7 +189,7 @@ void HeightSection::insertHeightPoint()
     const int insertPoint = heightPoint == -1 ? 0 : heightPoint;
     currentSection->data.insert(insertPoint, 0);
     emit sendNewPoint(insertPoint);
-    emit refreshPreview();
+    sectionChanged();
     emit refreshWidget();
 }
 
@@ -152,7 +204,7 @@ void HeightSection::deleteHeightPoint()
             heightPoint--;
 
         emit sendNewPoint(heightPoint);
-        emit refreshPreview();
+        sectionChanged();
         emit refreshWidget();
     }
 }
@@ -206,6 +258,7 @@ void HeightSection::newEntry(int type)
     sectionList->insert(index+1, newSection);
     model->insertRow(index+1, new QStandardItem(newSection.name));
     levels->remapHeightSections(index+1, 1);
+    levels->getChanges()->notifyHeightPattern();
     emit setDeleteSecBut(sectionList->size() > 1);
     emit setInsertSecBut(sectionList->size() < 255);
 }
@@ -225,6 +278,7 @@ void HeightSection::deleteEntry()
 
     // Remap existing sections in height layout
     levels->remapHeightSections(index, 0);
+    levels->getChanges()->notifyHeightPattern();
 
     emit setDeleteSecBut(sectionList->size() > 1);
     emit setInsertSecBut(sectionList->size() < 255);
@@ -245,6 +299,7 @@ void HeightSection::duplicateEntry()
     model->insertRow(index+1, newSection);
     sectionList->insert(index+1, currentSection);
     levels->remapHeightSections(index+1, 1);
+    levels->getChanges()->notifyHeightPattern();
 
     emit setDeleteSecBut(sectionList->size() > 1);
     emit setInsertSecBut(sectionList->size() < 255);
@@ -269,6 +324,7 @@ void HeightSection::moveUp()
 
     sectionList->swapItemsAt(index, index-1);
     levels->swapHeightSections(index, index-1);
+    levels->getChanges()->notifyHeightPattern();
     view->selectionModel()->setCurrentIndex(swap1->index(), QItemSelectionModel::ClearAndSelect);
 }
 
@@ -289,6 +345,7 @@ void HeightSection::moveDown()
 
         sectionList->swapItemsAt(index, index+1);
         levels->swapHeightSections(index, index+1);
+        levels->getChanges()->notifyHeightPattern();
         view->selectionModel()->setCurrentIndex(swap1->index(), QItemSelectionModel::ClearAndSelect);
     }
 }
@@ -17,6 +17,7 @@
 
 class QListView;
 class Levels;
+class ThumbnailCache;
 
 class HeightSection : public QObject
 {
@@ -30,6 +31,8 @@ public:
     QList<HeightSegment>* getSectionList();
     QString getSectionName(int);
     void setSectionName(int, QString);
+    void sectionChanged();
+    void setThumbnails(ThumbnailCache* thumbnails);
     
 signals:
     void updateSection(HeightSegment*);
@@ -57,6 +60,7 @@ public slots:
 
 private slots:
     void setCurrentSection();
+    void updateThumbnails(int index);
 
 private:
     // Height Section List
@@ -67,6 +71,9 @@ private:
 
     // Height Point Selected
     int heightPoint;
+
+    // Elevation curve of each section
+    ThumbnailCache* thumbnails;
 };
 
 #endif // HEIGHTSECTION_HPP
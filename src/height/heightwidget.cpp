@@ -98,14 +98,13 @@ void HeightWidget::createHeightMap()
     // calculate y spacing to use between points
     int yMin   = INT_MAX;
     int yMax   = INT_MIN;
-    int ySpace = y;
-    for (int i = 0; i < seg->data.size(); i++)
+    const QList<int> heights = accumulateHeights(*seg);
+    for (int i = 0; i < heights.size(); i++)
     {
-        ySpace += -seg->data.at(i);
-        if (ySpace < yMin)
-            yMin = ySpace;
-        if (ySpace > yMax)
-            yMax = ySpace;
+        if (heights.at(i) < yMin)
+            yMin = heights.at(i);
+        if (heights.at(i) > yMax)
+            yMax = heights.at(i);
     }
 
     int diff = std::max(std::abs(yMax), std::abs(yMin));
@@ -125,6 +124,22 @@ void HeightWidget::createHeightMap()
     }
 }
 
+// Height after each entry of a height map, relative to the start. Each entry holds the change
+// in height from the last. In screen direction, so a rising road is negative.
+QList<int> HeightWidget::accumulateHeights(const HeightSegment& seg)
+{
+    QList<int> heights;
+    int y = 0;
+
+    for (int i = 0; i < seg.data.size(); i++)
+    {
+        y += -seg.data.at(i);
+        heights.push_back(y);
+    }
+
+    return heights;
+}
+
 void HeightWidget::createHeightDelay()
 {
     const int16_t y1 = -seg->data.at(0);
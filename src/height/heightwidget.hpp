@@ -19,6 +19,7 @@ public:
     explicit HeightWidget(QWidget *parent = 0);
     ~HeightWidget();
     int getSelectedPoint();
+    static QList<int> accumulateHeights(const HeightSegment& seg);
 
 protected:
     void leaveEvent(QEvent* e);
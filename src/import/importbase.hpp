@@ -11,6 +11,7 @@
 #include <QList>
 #include "../globals.hpp"
 
+class LevelData;
 struct SpriteFormat;
 struct SpriteSectionEntry;
 struct HeightSegment;
@@ -18,7 +19,7 @@ struct HeightSegment;
 class ImportBase
 {
 public:
-    virtual bool loadLevel(int id, const bool loadPatterns = true) = 0;
+    virtual bool loadLevel(LevelData* level, int id, const bool loadPatterns = true) = 0;
     virtual QList<HeightSegment> loadHeightSections() = 0;
     virtual QList<SpriteFormat> loadSpriteList() = 0;
     virtual uint8_t* getPaletteData() = 0;
@@ -6,6 +6,7 @@
 ***************************************************************************/
 
 #include <QtCore/qmath.h> // Sqrt
+#include <QtConcurrent>
 
 #include "../leveldata.hpp"
 #include "../sprites/spritelist.hpp"
@@ -57,6 +58,7 @@ const static uint32_t PAL_GND_TABLE       = 0x17350; // Table of long addresses
 ImportOutRun::ImportOutRun()
 {
     romsLoaded = false;
+    romCrc     = 0;
 }
 
 ImportOutRun::~ImportOutRun(){}
@@ -64,12 +66,12 @@ ImportOutRun::~ImportOutRun(){}
 QList<QString> ImportOutRun::getLevelNames()
 {
     QList<QString> levelList;
-    for (int i = 0; i < 23; i++)
+    for (int i = 0; i < ROM_LEVELS; i++)
         levelList.push_back(LEVEL_LIST[i]);
     return levelList;
 }
 
-bool ImportOutRun::loadLevel(int id, const bool loadPatterns)
+bool ImportOutRun::loadLevel(LevelData* level, int id, const bool loadPatterns)
 {
     // Normal Level
     if (id < NORMAL_LEVELS)
@@ -78,18 +80,18 @@ bool ImportOutRun::loadLevel(int id, const bool loadPatterns)
         // Import Palette
         // --------------------------------------------------------------------------------------------
 
-        loadLevelPalette(id);
+        loadLevelPalette(level, id);
 
         // --------------------------------------------------------------------------------------------
         // Import Road Points
         // --------------------------------------------------------------------------------------------
 
-        return loadLevelData(STAGE_LOOKUPS[id] + 24, levelData, LevelData::LEVEL_LENGTH, loadPatterns);
+        return loadLevelData(STAGE_LOOKUPS[id] + 24, level, LevelData::LEVEL_LENGTH, loadPatterns);
     }
     // End Section (No Palette Data)
     else
     {
-        return loadLevelData(STAGE_LOOKUPS[id], levelData, levelData->length, loadPatterns);
+        return loadLevelData(STAGE_LOOKUPS[id], level, level->length, loadPatterns);
     }
 }
 
@@ -111,15 +113,19 @@ bool ImportOutRun::loadEndSection(LevelData *level, const bool loadPatterns)
     return loadLevelData(STAGE_LOOKUPS[NORMAL_LEVELS], level, level->length, loadPatterns);
 }
 
-bool ImportOutRun::loadLevelData(uint32_t stageAdr, LevelData* level, const int levelLength, const bool loadPatterns)
+// End sections share a single path. Set loadPath to false to leave it alone.
+bool ImportOutRun::loadLevelData(uint32_t stageAdr, LevelData* level, const int levelLength, const bool loadPatterns,
+                                 const bool loadPath)
 {
-    level->points->clear();
     uint32_t adr = rom0.read32(stageAdr + 0);
     int count = 0;
 
     PathPoint prev;
 
-    while (true)
+    if (loadPath)
+        level->points->clear();
+
+    while (loadPath)
     {
         int16_t pos = rom0.read16(&adr);
 
@@ -224,6 +230,58 @@ bool ImportOutRun::loadLevelData(uint32_t stageAdr, LevelData* level, const int
     return true;
 }
 
+// ------------------------------------------------------------------------------------------------
+// Import every level, end section and the split in one go.
+//
+// romLevels contains a LevelData for each entry in the level list, in order. These are
+// imported concurrently. The shared palette, height and scenery patterns should be loaded
+// separately.
+// ------------------------------------------------------------------------------------------------
+
+bool ImportOutRun::loadGame(QList<LevelData*> romLevels, LevelData* split)
+{
+    if (!romsLoaded || romLevels.size() != ROM_LEVELS)
+        return false;
+
+    QList<int> ids;
+    for (int id = 0; id < ROM_LEVELS; id++)
+        ids.push_back(id);
+
+    // Import control points
+    QtConcurrent::blockingMap(ids, [=](int& id)
+    {
+        LevelData* level = romLevels.at(id);
+
+        if (id < NORMAL_LEVELS)
+        {
+            loadLevelPaletteIndex(level, id);
+            loadLevelData(STAGE_LOOKUPS[id] + 24, level, LevelData::LEVEL_LENGTH, true);
+        }
+        // Only the first end section writes the path they share
+        else
+        {
+            loadLevelData(STAGE_LOOKUPS[id], level, level->length, true, id == NORMAL_LEVELS);
+        }
+    });
+
+    loadSplit(split, true);
+
+    // Generate path data. Done once all the paths have been loaded.
+    // End sections also write to the path they share, so only the first is done concurrently.
+    QList<LevelData*> independent = romLevels.mid(0, NORMAL_LEVELS + 1);
+    independent.push_back(split);
+
+    QtConcurrent::blockingMap(independent, [](LevelData*& level)
+    {
+        level->updatePathData();
+    });
+
+    for (int id = NORMAL_LEVELS + 1; id < ROM_LEVELS; id++)
+        romLevels.at(id)->updatePathData();
+
+    return true;
+}
+
 // ------------------------------------------------------------------------------------------------
 // guessAngle
 //
@@ -232,56 +290,85 @@ bool ImportOutRun::loadLevelData(uint32_t stageAdr, LevelData* level, const int
 // We generate this value so that track segments can be easily edited and the relevant metadata is
 // created which doesn't exist in the raw output.
 //
-// There might be a better way to do this than brute force?
+// The curve info generated by each angle is calculated once, and inverted into a lookup table.
 // -----------------------------------------------------------------------------------------------
 
-int ImportOutRun::guessAngle(int curveInfo)
+class CurveAngleTable
 {
-    qreal angle = 0;
+public:
+    const static int ANGLES = 300;        // Angle increments to consider
+    const static int MAX_DIFF = 1000;     // Maximum difference for a match
 
-    int minDiff = 1000;
-    int bestAngle = -1;
-
-    for (int angleInc = 0; angleInc < 300; angleInc++)
+    CurveAngleTable()
     {
-        qreal inc = ((qreal) angleInc / 10000);
+        qreal angle = 0;
 
-        const int x1 = qSin(angle) * LevelData::FIXED_ONE;
-        const int y1 = qCos(angle) * LevelData::FIXED_ONE;
-        const int x2 = qSin(angle + inc) * LevelData::FIXED_ONE;
-        const int y2 = qCos(angle + inc) * LevelData::FIXED_ONE;
+        for (int angleInc = 0; angleInc < ANGLES; angleInc++)
+        {
+            qreal inc = ((qreal) angleInc / 10000);
 
-        const int xdiff = x2 - x1;
-        const int ydiff = y2 - y1;
+            const int x1 = qSin(angle) * LevelData::FIXED_ONE;
+            const int y1 = qCos(angle) * LevelData::FIXED_ONE;
+            const int x2 = qSin(angle + inc) * LevelData::FIXED_ONE;
+            const int y2 = qCos(angle + inc) * LevelData::FIXED_ONE;
 
-        const double l = qSqrt((xdiff*xdiff)+(ydiff*ydiff));
-        const int curveInfoNew = l == 0 ? 0 : (1.0 / l) * LevelData::FIXED_ONE;
+            const int xdiff = x2 - x1;
+            const int ydiff = y2 - y1;
 
-        int diff = qAbs(curveInfoNew - curveInfo);
-        if (diff <= minDiff)
-        {
-            minDiff = diff;
-            bestAngle = angleInc;
-
-            // Found optimal angle
-            if (diff == 0)
-                return angleInc;
+            const double l = qSqrt((xdiff*xdiff)+(ydiff*ydiff));
+            curveInfo[angleInc] = l == 0 ? 0 : (1.0 / l) * LevelData::FIXED_ONE;
         }
+
+        // Curve info can't exceed FIXED_ONE, as the points are a whole unit apart at minimum
+        for (int i = 0; i <= LevelData::FIXED_ONE; i++)
+            lookup[i] = search(i);
     }
 
-    // Error: Did Not Calculate Curve Info Correctly
-    if (bestAngle == -1)
+    int getAngle(int info) const
     {
-        bestAngle = 0;
+        if (info >= 0 && info <= LevelData::FIXED_ONE)
+            return lookup[info];
+
+        return search(info);
     }
-    /*else if (minDiff != 0)
+
+private:
+    int curveInfo[ANGLES];
+    uint16_t lookup[LevelData::FIXED_ONE + 1];
+
+    // First exact match. Otherwise, the closest match (favouring larger angles).
+    int search(int info) const
     {
-        std::cout << "Had to guess " << bestAngle << std::endl;
-    }*/
-    return bestAngle;
+        int minDiff = MAX_DIFF;
+        int bestAngle = -1;
+
+        for (int angleInc = 0; angleInc < ANGLES; angleInc++)
+        {
+            int diff = qAbs(curveInfo[angleInc] - info);
+            if (diff <= minDiff)
+            {
+                minDiff = diff;
+                bestAngle = angleInc;
+
+                // Found optimal angle
+                if (diff == 0)
+                    return angleInc;
+            }
+        }
+
+        // Error: Did Not Calculate Curve Info Correctly
+        return bestAngle == -1 ? 0 : bestAngle;
+    }
+};
+
+int ImportOutRun::guessAngle(int curveInfo)
+{
+    // Built on first use. Thread safe, as levels are imported concurrently.
+    const static CurveAngleTable table;
+    return table.getAngle(curveInfo);
 }
 
-QList<HeightSegment> ImportOutRun::loadHeightSections()
+QList<HeightSegment> ImportOutRun::decodeHeightSections()
 {
     QList<HeightSegment> list;
     list.clear();
@@ -332,27 +419,27 @@ QList<HeightSegment> ImportOutRun::loadHeightSections()
     return list;
 }
 
-void ImportOutRun::loadSharedPalette()
+void ImportOutRun::decodeSharedPalette(LevelPalette* levelPal)
 {
     uint32_t adr;
     // Road Palette Entries
     for (int pal = 0; pal < LevelPalette::ROAD_PALS; pal++)
     {
         adr = rom0.read32(STAGE_LOOKUPS[pal] + 4);
-        levelData->pal->road[pal][LevelPalette::CENTRE1] = rom0.read32(&adr);
-        levelData->pal->road[pal][LevelPalette::CENTRE2] = rom0.read32(adr);
+        levelPal->road[pal][LevelPalette::CENTRE1] = rom0.read32(&adr);
+        levelPal->road[pal][LevelPalette::CENTRE2] = rom0.read32(adr);
 
         adr = rom0.read32(STAGE_LOOKUPS[pal] + 8);
-        levelData->pal->road[pal][LevelPalette::STRIPE1] = rom0.read32(&adr);
-        levelData->pal->road[pal][LevelPalette::STRIPE2] = rom0.read32(adr);
+        levelPal->road[pal][LevelPalette::STRIPE1] = rom0.read32(&adr);
+        levelPal->road[pal][LevelPalette::STRIPE2] = rom0.read32(adr);
 
         adr = rom0.read32(STAGE_LOOKUPS[pal] + 12);
-        levelData->pal->road[pal][LevelPalette::SIDE1] = rom0.read32(&adr);
-        levelData->pal->road[pal][LevelPalette::SIDE2] = rom0.read32(adr);
+        levelPal->road[pal][LevelPalette::SIDE1] = rom0.read32(&adr);
+        levelPal->road[pal][LevelPalette::SIDE2] = rom0.read32(adr);
 
         adr = rom0.read32(STAGE_LOOKUPS[pal] + 16);
-        levelData->pal->road[pal][LevelPalette::ROAD1] = rom0.read32(&adr);
-        levelData->pal->road[pal][LevelPalette::ROAD2] = rom0.read32(adr);
+        levelPal->road[pal][LevelPalette::ROAD1] = rom0.read32(&adr);
+        levelPal->road[pal][LevelPalette::ROAD2] = rom0.read32(adr);
     }
 
     // Sky Palette Entries
@@ -361,7 +448,7 @@ void ImportOutRun::loadSharedPalette()
         uint32_t src = rom0.read32(PAL_SKY_TABLE + (pal << 2));
 
         for (int i = 0; i < LevelPalette::SKY_LENGTH; i++)
-            levelData->pal->sky[pal][i] = rom0.read32(&src);
+            levelPal->sky[pal][i] = rom0.read32(&src);
     }
 
     // Ground Palette Entries
@@ -370,24 +457,29 @@ void ImportOutRun::loadSharedPalette()
         uint32_t src = rom0.read32(PAL_GND_TABLE + (pal << 2));
 
         for (int i = 0; i < LevelPalette::GND_LENGTH; i++)
-            levelData->pal->gnd[pal][i] = rom0.read32(&src);
+            levelPal->gnd[pal][i] = rom0.read32(&src);
     }
 }
 
-void ImportOutRun::loadLevelPalette(int id)
+void ImportOutRun::loadLevelPalette(LevelData* level, int id)
 {
-    levelData->roadPal = std::min(id, LevelPalette::ROAD_PALS - 1);
+    loadLevelPaletteIndex(level, id);
+    loadSharedPalette(level->pal);
+}
+
+// Select the palettes used by this level, without loading the palettes themselves
+void ImportOutRun::loadLevelPaletteIndex(LevelData* level, int id)
+{
+    level->roadPal = std::min(id, LevelPalette::ROAD_PALS - 1);
 
     uint32_t adr = rom0.read32(STAGE_LOOKUPS[id] + 0);
-    levelData->skyPal  = rom0.read16(adr);
+    level->skyPal  = rom0.read16(adr);
 
     adr = rom0.read32(STAGE_LOOKUPS[id] + 20);
-    levelData->gndPal = rom0.read16(adr);
-
-    loadSharedPalette();
+    level->gndPal = rom0.read16(adr);
 }
 
-QList<SpriteFormat> ImportOutRun::loadSpriteList()
+QList<SpriteFormat> ImportOutRun::decodeSpriteList()
 {
     QList<SpriteFormat> list;
 
@@ -424,13 +516,12 @@ uint8_t* ImportOutRun::getPaletteData()
     return &rom0.rom[PALETTE];
 }
 
-QList<SpriteSectionEntry> ImportOutRun::loadSpriteSections(int id)
+QList<SpriteSectionEntry> ImportOutRun::decodeSpriteSections()
 {
     QList<SpriteSectionEntry> list;
-    const static int TABLE_ENTRIES = 230;
+    const static int ENTRIES = 230;
 
-    uint32_t adr_p    = SPRITE_MASTER_TABLE;
-    const int ENTRIES = id == 0 ? TABLE_ENTRIES : id + 1;
+    uint32_t adr_p = SPRITE_MASTER_TABLE;
 
     for (int i = 0; i < ENTRIES; i++)
     {
@@ -473,19 +564,73 @@ QList<SpriteSectionEntry> ImportOutRun::loadSpriteSections(int id)
             section.sprites.push_front(entry);
         }
 
-        if (id == 0 || i == id)
-            list.push_back(section);
+        list.push_back(section);
     }
 
     return list;
 }
 
+// ------------------------------------------------------------------------------------------------
+// Decoded ROM Tables
+//
+// The tables are decoded the first time they are needed, then shared by every subsequent import.
+// They are only rebuilt if the program ROMs change.
+// ------------------------------------------------------------------------------------------------
+
+QSharedPointer<const ImportOutRun::RomTables> ImportOutRun::getTables()
+{
+    if (tables.isNull() || tables->crc != romCrc)
+    {
+        RomTables* t      = new RomTables();
+        t->crc            = romCrc;
+        t->heightSections = decodeHeightSections();
+        t->spriteSections = decodeSpriteSections();
+        t->spriteList     = decodeSpriteList();
+        decodeSharedPalette(&t->palette);
+        tables = QSharedPointer<const RomTables>(t);
+    }
+    return tables;
+}
+
+QList<HeightSegment> ImportOutRun::loadHeightSections()
+{
+    return getTables()->heightSections;
+}
+
+QList<SpriteFormat> ImportOutRun::loadSpriteList()
+{
+    return getTables()->spriteList;
+}
+
+// Returns every scenery pattern, or just the requested one
+QList<SpriteSectionEntry> ImportOutRun::loadSpriteSections(int id)
+{
+    const QList<SpriteSectionEntry>& list = getTables()->spriteSections;
+
+    if (id == 0)
+        return list;
+
+    QList<SpriteSectionEntry> entry;
+    if (id < list.size())
+        entry.push_back(list.at(id));
+    return entry;
+}
+
+void ImportOutRun::loadSharedPalette(LevelPalette* levelPal)
+{
+    *levelPal = getTables()->palette;
+}
+
 // ------------------------------------------------------------------------------------------------
 // Rom Load & Unload
 // ------------------------------------------------------------------------------------------------
 
 void ImportOutRun::unloadRoms()
 {
+    tables.clear();
+    romCrc     = 0;
+    romsLoaded = false;
+
     rom0.unload();
     rom1.unload();
     tiles.unload();
@@ -551,6 +696,9 @@ bool ImportOutRun::loadRevBRoms(QString path)
     status += sprites.load("mpr-10376.15", 0x080002, 0x20000, 0xf3b8f318, RomLoader::INTERLEAVE4);
     status += sprites.load("mpr-10378.16", 0x080003, 0x20000, 0xa1062984, RomLoader::INTERLEAVE4);
 
+    // Decoded tables are only valid for the program ROMs they came from
+    romCrc = rom1.crc32(rom0.crc32());
+
     // If status has been incremented, a rom has failed to load.
     return romsLoaded = status == 0;
 }
@@ -8,8 +8,12 @@
 #ifndef IMPORTOUTRUN_HPP
 #define IMPORTOUTRUN_HPP
 
+#include <QSharedPointer>
 #include "importbase.hpp"
 #include "romloader.hpp"
+#include "../height/heightformat.hpp"
+#include "../sprites/spriteformat.hpp"
+#include "../levels/levelpalette.hpp"
 
 class LevelData;
 
@@ -19,6 +23,9 @@ public:
     // Number of normal levels, i.e. not end sections
     static const int NORMAL_LEVELS = 18;
 
+    // Number of levels and end sections in the ROM
+    static const int ROM_LEVELS = 23;
+
     bool romsLoaded;
 
     // OutRun Romset
@@ -34,18 +41,41 @@ public:
     QList<QString> getLevelNames();
     void unloadRoms();
     bool loadRevBRoms(QString path);
-    bool loadLevel(int id, const bool loadPatterns = true);
+    bool loadLevel(LevelData* level, int id, const bool loadPatterns = true);
     bool loadSplit(LevelData* level,const bool loadPatterns = true);
     bool loadEndSection(LevelData* level,const bool loadPatterns = true);
-    bool loadLevelData(uint32_t stageAdr, LevelData* level, const int levelLength, const bool loadPatterns);
+    bool loadLevelData(uint32_t stageAdr, LevelData* level, const int levelLength, const bool loadPatterns,
+                       const bool loadPath = true);
+    bool loadGame(QList<LevelData*> romLevels, LevelData* split);
     QList<HeightSegment> loadHeightSections();
-    void loadSharedPalette();
-    void loadLevelPalette(int id);
+    void loadSharedPalette(LevelPalette* levelPal);
+    void loadLevelPalette(LevelData* level, int id);
+    void loadLevelPaletteIndex(LevelData* level, int id);
     QList<SpriteFormat> loadSpriteList();
     uint8_t* getPaletteData();
     QList<SpriteSectionEntry> loadSpriteSections(int id = 0);
 
 private:
+    // Tables decoded from the program ROMs. Shared by every import, and never modified once built.
+    struct RomTables
+    {
+        uint32_t crc;                               // CRC of the ROMs these were decoded from
+        QList<HeightSegment> heightSections;
+        QList<SpriteSectionEntry> spriteSections;
+        QList<SpriteFormat> spriteList;
+        LevelPalette palette;
+    };
+
+    QSharedPointer<const RomTables> tables;
+
+    // CRC of the currently loaded program ROMs
+    uint32_t romCrc;
+
+    QSharedPointer<const RomTables> getTables();
+    QList<HeightSegment> decodeHeightSections();
+    QList<SpriteSectionEntry> decodeSpriteSections();
+    QList<SpriteFormat> decodeSpriteList();
+    void decodeSharedPalette(LevelPalette* levelPal);
     int guessAngle(int);
 };
 
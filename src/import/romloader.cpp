@@ -32,6 +32,39 @@ void RomLoader::init(const uint32_t length)
     rom = new uint8_t[length];
 }
 
+// CRC-32 lookup table
+struct Crc32Table
+{
+    uint32_t entry[256];
+
+    Crc32Table()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int j = 0; j < 8; j++)
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            entry[i] = c;
+        }
+    }
+};
+
+// CRC-32 of the loaded data. Pass a previous result to continue a running CRC.
+uint32_t RomLoader::crc32(uint32_t crc) const
+{
+    const static Crc32Table table;
+
+    crc = ~crc;
+
+    if (rom)
+    {
+        for (uint32_t i = 0; i < length; i++)
+            crc = table.entry[(crc ^ rom[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
 void RomLoader::unload(void)
 {
     if (rom)
@@ -32,6 +32,7 @@ public:
     void setRomPath(std::string path);
     int load(const char* filename, const int offset, const int length, const int, const uint8_t mode = NORMAL);
     void unload(void);
+    uint32_t crc32(uint32_t crc = 0) const;
 
     // ----------------------------------------------------------------------------
     // Used by translated 68000 Code
@@ -0,0 +1,865 @@
+/***************************************************************************
+    Edit Journal.
+
+    Crash recovery for the project being edited.
+
+    Edits reported to LevelChanges are appended to a binary journal once
+    editing pauses. Each record holds the new state of one aspect of a
+    level, or of a single pattern, so replaying the records in order over
+    the last snapshot restores the project.
+
+    The journal is compacted into a snapshot of the whole project
+    periodically, and whenever the project is restructured. Snapshots use
+    the project file format.
+
+    Files are written by a dedicated thread, so the editor never waits on
+    the disk.
+
+    Journal Format:
+    - Header:  magic (quint32), version (quint16), generation (quint32)
+    - Records: payload length (quint32), payload checksum (quint16), payload
+
+    Replay stops at the first incomplete or corrupt record, which is the
+    tail left behind by a crash.
+
+    Each snapshot records a new generation, which is written to the header
+    of the journal started after it. A journal is only replayed over the
+    snapshot with the same generation.
+
+    Each running editor writes its own files, named after its process id,
+    and holds a lock file for as long as it runs. Only files whose lock is
+    no longer held are offered for recovery.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <iostream>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+
+#include "levels/levels.hpp"
+#include "height/heightsection.hpp"
+#include "sprites/spritesection.hpp"
+#include "projectfile.hpp"
+#include "journal.hpp"
+
+static void writeControlPoints(QDataStream& out, const QList<ControlPoint>& points)
+{
+    out << (qint32) points.size();
+    foreach (ControlPoint cp, points)
+        out << (qint32) cp.pos << (qint32) cp.type << (qint32) cp.value1 << (qint32) cp.value2;
+}
+
+static bool readControlPoints(QDataStream& in, QList<ControlPoint>& points)
+{
+    qint32 size;
+    in >> size;
+
+    for (int i = 0; i < size && in.status() == QDataStream::Ok; i++)
+    {
+        qint32 pos, type, value1, value2;
+        in >> pos >> type >> value1 >> value2;
+
+        ControlPoint cp;
+        cp.pos    = pos;
+        cp.type   = type;
+        cp.value1 = value1;
+        cp.value2 = value2;
+        points.push_back(cp);
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+// ------------------------------------------------------------------------------------------------
+//                                          JOURNAL WRITER
+// ------------------------------------------------------------------------------------------------
+
+JournalWriter::JournalWriter(const QString& journalFile, const QString& snapshotFile)
+{
+    this->journalFile  = journalFile;
+    this->snapshotFile = snapshotFile;
+    journal    = NULL;
+    generation = 0;
+}
+
+JournalWriter::~JournalWriter()
+{
+    delete journal;
+}
+
+bool JournalWriter::open(bool truncate)
+{
+    if (journal == NULL)
+        journal = new QFile(journalFile);
+    else
+        journal->close();
+
+    if (!journal->open(truncate ? QIODevice::WriteOnly | QIODevice::Truncate : QIODevice::WriteOnly | QIODevice::Append))
+    {
+        if (DEBUG)
+            std::cout << "Journal: unable to open " << journalFile.toStdString() << std::endl;
+        return false;
+    }
+
+    if (journal->size() == 0)
+    {
+        QDataStream out(journal);
+        out << Journal::MAGIC << Journal::VERSION << generation;
+    }
+
+    return true;
+}
+
+// Records are flushed as they are written, so they survive the editor crashing
+void JournalWriter::append(QByteArray record)
+{
+    if (journal == NULL || !journal->isOpen())
+    {
+        if (!open(false))
+            return;
+    }
+
+    journal->write(record);
+    journal->flush();
+}
+
+// The snapshot is replaced atomically, then the journal is restarted with the snapshot's
+// generation. A failure to write the snapshot leaves the previous snapshot and its journal
+// intact. A crash before the journal is restarted leaves the previous journal behind, which
+// replay ignores as its generation no longer matches.
+void JournalWriter::compact(QSharedPointer<const ProjectSnapshot> project)
+{
+    QString error;
+
+    if (!ProjectFile::write(snapshotFile, *project, &error))
+    {
+        if (DEBUG)
+            std::cout << "Journal: snapshot failed: " << error.toStdString() << std::endl;
+
+        // Records that follow belong to the previous snapshot, which is still in place
+        emit compacted(false);
+        return;
+    }
+
+    generation = project->journalGeneration;
+
+    if (open(true))
+        journal->flush();
+
+    emit compacted(true);
+}
+
+void JournalWriter::discard()
+{
+    if (journal != NULL)
+        journal->close();
+
+    QFile::remove(journalFile);
+    QFile::remove(snapshotFile);
+}
+
+// ------------------------------------------------------------------------------------------------
+//                                              JOURNAL
+// ------------------------------------------------------------------------------------------------
+
+Journal::Journal(QObject* parent, Levels* levels, HeightSection* heightSection, SpriteSection* spriteSection) :
+    QObject(parent)
+{
+    this->levels        = levels;
+    this->heightSection = heightSection;
+    this->spriteSection = spriteSection;
+
+    active       = false;
+    records      = 0;
+    generation   = (quint32) QDateTime::currentMSecsSinceEpoch(); // Differs from earlier sessions
+    dirty        = 0;
+    dirtyLevel   = 0;
+    dirtyProject = false;
+
+    compacting     = 0;
+    unsaved        = 0;
+    unsavedLevel   = 0;
+    unsavedProject = false;
+
+    path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/recovery";
+    QDir().mkpath(path);
+
+    const QString session = QString::number(QCoreApplication::applicationPid());
+    journalFile  = path + "/journal-"  + session + ".bin";
+    snapshotFile = path + "/snapshot-" + session + ".xml";
+
+    // Held until the editor exits. Left behind by a crash, when the process no longer exists.
+    lock = new QLockFile(path + "/session-" + session + ".lock");
+    lock->setStaleLockTime(0);
+    lock->tryLock(0);
+    recoveryLock = NULL;
+
+    qRegisterMetaType<QSharedPointer<const ProjectSnapshot> >("QSharedPointer<const ProjectSnapshot>");
+
+    thread = new QThread(this);
+    writer = new JournalWriter(journalFile, snapshotFile);
+    writer->moveToThread(thread);
+    connect(this, SIGNAL(appendRecord(QByteArray)), writer, SLOT(append(QByteArray)));
+    connect(this, SIGNAL(compactProject(QSharedPointer<const ProjectSnapshot>)),
+            writer, SLOT(compact(QSharedPointer<const ProjectSnapshot>)));
+    connect(writer, SIGNAL(compacted(bool)), this, SLOT(compacted(bool)));
+    thread->start(QThread::LowPriority);
+
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(FLUSH_DELAY);
+    connect(flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
+    compactTimer = new QTimer(this);
+    compactTimer->setInterval(COMPACT_INTERVAL);
+    connect(compactTimer, SIGNAL(timeout()), this, SLOT(checkpoint()));
+
+    LevelChanges* changes = levels->getChanges();
+    connect(changes, SIGNAL(pathChanged(int, int)),      this, SLOT(pathChanged()));
+    connect(changes, SIGNAL(widthChanged(int)),          this, SLOT(widthChanged()));
+    connect(changes, SIGNAL(heightPointsChanged()),      this, SLOT(heightPointsChanged()));
+    connect(changes, SIGNAL(sceneryPointsChanged()),     this, SLOT(sceneryPointsChanged()));
+    connect(changes, SIGNAL(heightPatternChanged(int)),  this, SLOT(heightPatternChanged(int)));
+    connect(changes, SIGNAL(sceneryPatternChanged(int)), this, SLOT(sceneryPatternChanged(int)));
+    connect(changes, SIGNAL(paletteChanged()),           this, SLOT(paletteChanged()));
+    connect(changes, SIGNAL(projectChanged()),           this, SLOT(projectChanged()));
+}
+
+Journal::~Journal()
+{
+    thread->quit();
+    thread->wait();
+    delete writer;
+    delete lock;
+    delete recoveryLock;
+}
+
+// Find the files left behind by a session that did not exit cleanly. Sessions still running
+// hold their lock, and are never offered. The most recent session is offered first.
+bool Journal::hasRecovery()
+{
+    if (!recoverySession.isEmpty())
+        return true;
+
+    if (active)
+        return false;
+
+    QFileInfoList snapshots = QDir(path).entryInfoList(QStringList("snapshot-*.xml"), QDir::Files, QDir::Time);
+
+    for (int i = 0; i < snapshots.size(); i++)
+    {
+        const QString session = snapshots.at(i).completeBaseName().mid(QString("snapshot-").length());
+
+        // Left behind by an earlier process with this process id. Nothing has been written yet.
+        if (snapshots.at(i).absoluteFilePath() == QFileInfo(snapshotFile).absoluteFilePath())
+        {
+            recoverySession = session;
+            return true;
+        }
+
+        // Held whilst the files are recovered, so no other editor offers them too
+        QLockFile* sessionLock = new QLockFile(path + "/session-" + session + ".lock");
+        sessionLock->setStaleLockTime(0);
+
+        if (sessionLock->tryLock(0))
+        {
+            recoveryLock    = sessionLock;
+            recoverySession = session;
+            return true;
+        }
+
+        delete sessionLock;
+    }
+
+    return false;
+}
+
+QString Journal::getSnapshotFilename() const
+{
+    return path + "/snapshot-" + recoverySession + ".xml";
+}
+
+// Remove the files found by hasRecovery(), once they have been recovered or declined
+void Journal::discardRecovery()
+{
+    if (recoverySession.isEmpty())
+        return;
+
+    // This session's own files are replaced when journalling starts
+    if (getSnapshotFilename() != snapshotFile)
+    {
+        QFile::remove(path + "/journal-" + recoverySession + ".bin");
+        QFile::remove(getSnapshotFilename());
+    }
+
+    delete recoveryLock;
+    recoveryLock = NULL;
+    recoverySession.clear();
+}
+
+// Start journalling edits to the project as it stands. A snapshot of the project is written
+// immediately, which replaces any files left behind by an earlier process with the same id.
+void Journal::start()
+{
+    active = true;
+    compact();
+    compactTimer->start();
+}
+
+// Discard the journal and snapshot. Called on a clean exit.
+void Journal::stop()
+{
+    active = false;
+    flushTimer->stop();
+    compactTimer->stop();
+    QMetaObject::invokeMethod(writer, "discard", Qt::BlockingQueuedConnection);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Recording
+// ------------------------------------------------------------------------------------------------
+
+void Journal::pathChanged()          { mark(RECORD_PATH);           }
+void Journal::widthChanged()         { mark(RECORD_WIDTH);          }
+void Journal::heightPointsChanged()  { mark(RECORD_HEIGHT_POINTS);  }
+void Journal::sceneryPointsChanged() { mark(RECORD_SCENERY_POINTS); }
+void Journal::paletteChanged()       { mark(RECORD_PALETTE);        }
+
+void Journal::heightPatternChanged(int index)
+{
+    if (index == LevelChanges::ALL_PATTERNS)
+    {
+        projectChanged();
+        return;
+    }
+
+    if (!active)
+        return;
+
+    dirtyHeightPatterns.insert(index);
+    flushTimer->start();
+}
+
+void Journal::sceneryPatternChanged(int index)
+{
+    if (index == LevelChanges::ALL_PATTERNS)
+    {
+        projectChanged();
+        return;
+    }
+
+    if (!active)
+        return;
+
+    dirtySceneryPatterns.insert(index);
+    flushTimer->start();
+}
+
+// Levels or pattern lists restructured. Records can't describe this, so the
+// project is compacted into a new snapshot instead.
+void Journal::projectChanged()
+{
+    if (!active)
+        return;
+
+    dirtyProject = true;
+    flushTimer->start();
+}
+
+// Aspects of the active level changed. Level aspects are only tracked for one level at
+// a time, so edits to the previous level are journalled first.
+void Journal::mark(int record)
+{
+    if (!active)
+        return;
+
+    const int level = levels->getActiveLevel();
+
+    if (dirty != 0 && level != dirtyLevel)
+        flush();
+
+    dirtyLevel = level;
+    dirty     |= 1 << record;
+    flushTimer->start();
+}
+
+void Journal::flush()
+{
+    flushTimer->stop();
+
+    if (!active)
+        return;
+
+    if (dirtyProject)
+    {
+        compact();
+        return;
+    }
+
+    for (int record = RECORD_PATH; record <= RECORD_SCENERY_POINTS; record++)
+    {
+        if (dirty & (1 << record))
+        {
+            emit appendRecord(createRecord(record, dirtyLevel));
+            records++;
+        }
+    }
+
+    if (dirty & (1 << RECORD_PALETTE))
+    {
+        emit appendRecord(createRecord(RECORD_PALETTE, dirtyLevel));
+        records++;
+    }
+
+    foreach (int index, dirtyHeightPatterns)
+    {
+        if (index < heightSection->getSectionList()->size())
+        {
+            emit appendRecord(createRecord(RECORD_HEIGHT_PATTERN, index));
+            records++;
+        }
+    }
+
+    foreach (int index, dirtySceneryPatterns)
+    {
+        if (index < spriteSection->getSectionList()->size())
+        {
+            emit appendRecord(createRecord(RECORD_SCENERY_PATTERN, index));
+            records++;
+        }
+    }
+
+    dirty = 0;
+    dirtyHeightPatterns.clear();
+    dirtySceneryPatterns.clear();
+
+    if (records >= COMPACT_RECORDS)
+        compact();
+}
+
+// Snapshot the whole project, which supersedes the journal and any pending edits
+void Journal::compact()
+{
+    if (!active)
+        return;
+
+    flushTimer->stop();
+
+    // The edits are only safe once the snapshot has been written
+    if (dirty != 0)
+    {
+        if (unsaved != 0 && unsavedLevel != dirtyLevel)
+            unsavedProject = true;
+
+        unsaved     |= dirty;
+        unsavedLevel = dirtyLevel;
+    }
+
+    unsavedProject |= dirtyProject;
+    unsavedHeightPatterns.unite(dirtyHeightPatterns);
+    unsavedSceneryPatterns.unite(dirtySceneryPatterns);
+    compacting++;
+
+    dirty        = 0;
+    dirtyProject = false;
+    dirtyHeightPatterns.clear();
+    dirtySceneryPatterns.clear();
+    records      = 0;
+
+    if (DEBUG)
+        std::cout << "Journal: compacting" << std::endl;
+
+    // 0 marks a project that isn't a recovery snapshot
+    if (++generation == 0)
+        generation++;
+
+    ProjectSnapshot* project   = new ProjectSnapshot(levels, heightSection, spriteSection);
+    project->journalGeneration = generation;
+    emit compactProject(QSharedPointer<const ProjectSnapshot>(project));
+}
+
+// Reported by the writer for each snapshot, in the order they were requested. When a snapshot
+// fails, the previous snapshot and journal are still in place, so the edits it held are marked
+// again. They are journalled over the previous snapshot, and a restructured project is retried
+// with the next flush.
+void Journal::compacted(bool written)
+{
+    compacting--;
+
+    if (written && compacting > 0)
+        return;
+
+    if (!written && active)
+    {
+        // Level aspects are only tracked for one level at a time
+        if (unsaved != 0 && dirty != 0 && dirtyLevel != unsavedLevel)
+            unsavedProject = true;
+        else if (unsaved != 0)
+        {
+            dirty     |= unsaved;
+            dirtyLevel = unsavedLevel;
+        }
+
+        dirtyProject |= unsavedProject;
+        dirtyHeightPatterns.unite(unsavedHeightPatterns);
+        dirtySceneryPatterns.unite(unsavedSceneryPatterns);
+
+        // A failed restructure waits for the next edit or checkpoint, rather than retrying at once
+        if (!dirtyProject)
+            flushTimer->start();
+    }
+
+    unsaved        = 0;
+    unsavedProject = false;
+    unsavedHeightPatterns.clear();
+    unsavedSceneryPatterns.clear();
+}
+
+// Periodic snapshot. Also captures changes that aren't recorded, such as renamed levels.
+void Journal::checkpoint()
+{
+    flush();
+
+    if (records > 0)
+        compact();
+}
+
+QByteArray Journal::createRecord(int record, int index)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << (quint8) record << (qint32) index;
+
+    switch (record)
+    {
+        case RECORD_PATH:
+        {
+            const QList<PathPoint>* points = levels->getLevels()->at(index)->points;
+            out << (qint32) points->size();
+            foreach (PathPoint point, *points)
+                out << (qint32) point.length << (qint32) point.angle_inc;
+            break;
+        }
+
+        case RECORD_WIDTH:
+            writeControlPoints(out, levels->getLevels()->at(index)->widthP);
+            break;
+
+        case RECORD_HEIGHT_POINTS:
+            writeControlPoints(out, levels->getLevels()->at(index)->heightP);
+            break;
+
+        case RECORD_SCENERY_POINTS:
+            out << levels->displayStartLine();
+            writeControlPoints(out, levels->getLevels()->at(index)->spriteP);
+            break;
+
+        // The level's palette selection, and the palettes shared by all levels
+        case RECORD_PALETTE:
+        {
+            const LevelData* level = levels->getLevels()->at(index);
+            out << (quint16) level->skyPal << (quint16) level->gndPal << (quint16) level->roadPal;
+            out.writeRawData((const char*) level->pal, sizeof(LevelPalette));
+            break;
+        }
+
+        case RECORD_HEIGHT_PATTERN:
+        {
+            const HeightSegment& seg = heightSection->getSectionList()->at(index);
+            out << heightSection->getSectionName(index)
+                << (qint32) seg.type << (qint32) seg.step << (qint32) seg.value1 << (qint32) seg.value2
+                << seg.data;
+            break;
+        }
+
+        case RECORD_SCENERY_PATTERN:
+        {
+            const SpriteSectionEntry& entry = spriteSection->getSectionList()->at(index);
+            out << spriteSection->getSectionName(index) << (quint16) entry.frequency << (qint32) entry.sprites.size();
+
+            for (int i = 0; i < entry.sprites.size(); i++)
+            {
+                const SpriteEntry& sprite = entry.sprites.at(i);
+                out << (quint8) sprite.props << (qint8) sprite.x << (qint16) sprite.y
+                    << (quint8) sprite.type << (quint8) sprite.pal
+                    << spriteSection->getSpriteName(index, i);
+            }
+            break;
+        }
+    }
+
+    QByteArray data;
+    QDataStream frame(&data, QIODevice::WriteOnly);
+    frame << (quint32) payload.size() << qChecksum(payload.constData(), payload.size());
+    data.append(payload);
+    return data;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Replay
+// ------------------------------------------------------------------------------------------------
+
+// Replay the journal over the snapshot, once it has been loaded.
+// Returns the number of records replayed.
+int Journal::replay()
+{
+    if (recoverySession.isEmpty())
+        return 0;
+
+    QFile file(path + "/journal-" + recoverySession + ".bin");
+
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    QDataStream in(&file);
+    quint32 magic;
+    quint16 version;
+    quint32 journalGeneration;
+    in >> magic >> version >> journalGeneration;
+
+    if (in.status() != QDataStream::Ok || magic != MAGIC || version != VERSION)
+        return 0;
+
+    // Journal left behind by a crash whilst the snapshot was replaced. Its records belong to the
+    // previous snapshot, and would be applied to the wrong levels and patterns.
+    if (journalGeneration != ProjectFile::readJournalGeneration(getSnapshotFilename()))
+        return 0;
+
+    QMap<int, QString> sectionNames;
+    QMap<int, QStringList> spriteNames;
+    int count = 0;
+
+    while (!in.atEnd())
+    {
+        quint32 length;
+        quint16 checksum;
+        in >> length >> checksum;
+
+        if (in.status() != QDataStream::Ok || length > file.size())
+            break;
+
+        QByteArray payload((int) length, 0);
+        if (in.readRawData(payload.data(), length) != (int) length)
+            break;
+
+        if (qChecksum(payload.constData(), payload.size()) != checksum)
+            break;
+
+        if (!applyRecord(payload, sectionNames, spriteNames))
+            break;
+
+        count++;
+    }
+
+    // Scenery pattern names are held by the pattern list, which is rebuilt with the replayed names
+    if (!sectionNames.isEmpty())
+    {
+        QList<QString> sections;
+        QList<QString> sprites;
+
+        for (int i = 0; i < spriteSection->getSectionList()->size(); i++)
+        {
+            if (sectionNames.contains(i))
+            {
+                sections.push_back(sectionNames.value(i));
+                sprites.append(spriteNames.value(i));
+            }
+            else
+            {
+                sections.push_back(spriteSection->getSectionName(i));
+                for (int j = 0; j < spriteSection->getSectionList()->at(i).sprites.size(); j++)
+                    sprites.push_back(spriteSection->getSpriteName(i, j));
+            }
+        }
+
+        spriteSection->generateEntries(sections, sprites);
+    }
+
+    if (DEBUG)
+        std::cout << "Journal: replayed " << count << " records" << std::endl;
+
+    return count;
+}
+
+bool Journal::applyRecord(const QByteArray& payload, QMap<int, QString>& sectionNames, QMap<int, QStringList>& spriteNames)
+{
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint8 record;
+    qint32 index;
+    in >> record >> index;
+
+    if (index < 0)
+        return false;
+
+    switch (record)
+    {
+        case RECORD_PATH:
+        case RECORD_WIDTH:
+        case RECORD_HEIGHT_POINTS:
+        case RECORD_SCENERY_POINTS:
+        case RECORD_PALETTE:
+            if (index >= levels->getLevels()->size())
+                return false;
+            break;
+
+        case RECORD_HEIGHT_PATTERN:
+            if (index >= heightSection->getSectionList()->size())
+                return false;
+            break;
+
+        case RECORD_SCENERY_PATTERN:
+            if (index >= spriteSection->getSectionList()->size())
+                return false;
+            break;
+
+        default:
+            return false;
+    }
+
+    switch (record)
+    {
+        case RECORD_PATH:
+        {
+            LevelData* level = levels->getLevels()->at(index);
+            qint32 size;
+            in >> size;
+
+            QList<PathPoint> points;
+            for (int i = 0; i < size && in.status() == QDataStream::Ok; i++)
+            {
+                qint32 length, angle_inc;
+                in >> length >> angle_inc;
+
+                PathPoint point;
+                point.pos       = 0;
+                point.length    = length;
+                point.angle_inc = angle_inc;
+                points.push_back(point);
+            }
+
+            if (in.status() != QDataStream::Ok)
+                return false;
+
+            *level->points = points;
+            level->updatePathData();
+            break;
+        }
+
+        case RECORD_WIDTH:
+        {
+            QList<ControlPoint> widthP;
+            if (!readControlPoints(in, widthP))
+                return false;
+            levels->getLevels()->at(index)->widthP = widthP;
+            break;
+        }
+
+        case RECORD_HEIGHT_POINTS:
+        {
+            QList<ControlPoint> heightP;
+            if (!readControlPoints(in, heightP))
+                return false;
+            levels->getLevels()->at(index)->heightP = heightP;
+            break;
+        }
+
+        case RECORD_SCENERY_POINTS:
+        {
+            bool startLine;
+            QList<ControlPoint> spriteP;
+            in >> startLine;
+            if (!readControlPoints(in, spriteP))
+                return false;
+            levels->setStartLine(startLine);
+            levels->getLevels()->at(index)->spriteP = spriteP;
+            break;
+        }
+
+        case RECORD_PALETTE:
+        {
+            quint16 skyPal, gndPal, roadPal;
+            LevelPalette pal;
+            in >> skyPal >> gndPal >> roadPal;
+            if (in.readRawData((char*) &pal, sizeof(LevelPalette)) != (int) sizeof(LevelPalette))
+                return false;
+
+            LevelData* level = levels->getLevels()->at(index);
+            level->skyPal  = skyPal;
+            level->gndPal  = gndPal;
+            level->roadPal = roadPal;
+            *level->pal    = pal;
+            break;
+        }
+
+        case RECORD_HEIGHT_PATTERN:
+        {
+            HeightSegment seg;
+            qint32 type, step, value1, value2;
+            in >> seg.name >> type >> step >> value1 >> value2 >> seg.data;
+            if (in.status() != QDataStream::Ok)
+                return false;
+
+            seg.type   = type;
+            seg.step   = step;
+            seg.value1 = value1;
+            seg.value2 = value2;
+            (*heightSection->getSectionList())[index] = seg;
+            break;
+        }
+
+        case RECORD_SCENERY_PATTERN:
+        {
+            QString name;
+            quint16 frequency;
+            qint32 size;
+            in >> name >> frequency >> size;
+
+            SpriteSectionEntry& entry = (*spriteSection->getSectionList())[index];
+            QList<SpriteEntry> sprites;
+            QStringList names;
+
+            for (int i = 0; i < size && in.status() == QDataStream::Ok; i++)
+            {
+                quint8 props, type, pal;
+                qint8 x;
+                qint16 y;
+                QString spriteName;
+                in >> props >> x >> y >> type >> pal >> spriteName;
+
+                SpriteEntry sprite;
+                sprite.props    = props;
+                sprite.x        = x;
+                sprite.y        = y;
+                sprite.type     = type;
+                sprite.pal      = pal;
+                sprite.selected = false;
+                sprites.push_back(sprite);
+                names.push_back(spriteName);
+            }
+
+            if (in.status() != QDataStream::Ok)
+                return false;
+
+            entry.frequency = frequency;
+            entry.sprites   = sprites;
+            sectionNames.insert(index, name);
+            spriteNames.insert(index, names);
+            break;
+        }
+    }
+
+    return true;
+}
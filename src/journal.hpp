@@ -0,0 +1,166 @@
+/***************************************************************************
+    Edit Journal.
+
+    Crash recovery for the project being edited.
+
+    Edits reported to LevelChanges are appended to a binary journal once
+    editing pauses. Each record holds the new state of one aspect of a
+    level, or of a single pattern, so replaying the records in order over
+    the last snapshot restores the project.
+
+    The journal is compacted into a snapshot of the whole project
+    periodically, and whenever the project is restructured. Snapshots use
+    the project file format.
+
+    Files are written by a dedicated thread, so the editor never waits on
+    the disk.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+
+#include <QObject>
+#include <QByteArray>
+#include <QMap>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+#include "projectsnapshot.hpp"
+
+class QFile;
+class QLockFile;
+class QThread;
+class QTimer;
+class Levels;
+class HeightSection;
+class SpriteSection;
+
+// Writes the journal and snapshot files. Lives on the journal thread.
+class JournalWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    JournalWriter(const QString& journalFile, const QString& snapshotFile);
+    ~JournalWriter();
+
+public slots:
+    void append(QByteArray record);
+    void compact(QSharedPointer<const ProjectSnapshot> project);
+    void discard();
+
+signals:
+    void compacted(bool written);
+
+private:
+    const static bool DEBUG = false;
+
+    QString journalFile;
+    QString snapshotFile;
+    QFile* journal;
+    quint32 generation;        // Generation of the last snapshot, written to the journal header
+
+    bool open(bool truncate);
+};
+
+class Journal : public QObject
+{
+    Q_OBJECT
+
+public:
+    const static int FLUSH_DELAY      = 1000;  // Milliseconds after an edit before it is journalled
+    const static int COMPACT_INTERVAL = 60000; // Milliseconds between snapshots, whilst editing
+    const static int COMPACT_RECORDS  = 256;   // Records journalled before a snapshot is forced
+
+    const static quint32 MAGIC   = 0x4C4A524E; // 'LJRN'
+    const static quint16 VERSION = 2;
+
+    Journal(QObject* parent, Levels* levels, HeightSection* heightSection, SpriteSection* spriteSection);
+    ~Journal();
+
+    bool hasRecovery();
+    bool isActive() const { return active; }
+    QString getSnapshotFilename() const;
+    int replay();
+    void discardRecovery();
+    void start();
+    void stop();
+
+signals:
+    void appendRecord(QByteArray record);
+    void compactProject(QSharedPointer<const ProjectSnapshot> project);
+
+private slots:
+    void pathChanged();
+    void widthChanged();
+    void heightPointsChanged();
+    void sceneryPointsChanged();
+    void heightPatternChanged(int index);
+    void sceneryPatternChanged(int index);
+    void paletteChanged();
+    void projectChanged();
+    void flush();
+    void compact();
+    void checkpoint();
+    void compacted(bool written);
+
+private:
+    const static bool DEBUG = false;
+
+    enum Record
+    {
+        RECORD_PATH,
+        RECORD_WIDTH,
+        RECORD_HEIGHT_POINTS,
+        RECORD_SCENERY_POINTS,
+        RECORD_HEIGHT_PATTERN,
+        RECORD_SCENERY_PATTERN,
+        RECORD_PALETTE
+    };
+
+    Levels* levels;
+    HeightSection* heightSection;
+    SpriteSection* spriteSection;
+
+    QString path;
+    QString journalFile;
+    QString snapshotFile;
+    QLockFile* lock;           // Marks this session's files as in use
+    QString recoverySession;   // Session whose files are offered for recovery
+    QLockFile* recoveryLock;
+
+    QThread* thread;
+    JournalWriter* writer;
+    QTimer* flushTimer;        // Delays journalling whilst editing
+    QTimer* compactTimer;
+
+    bool active;               // Edits are being journalled
+    int records;               // Records journalled since the last snapshot
+    quint32 generation;        // Snapshot the journal is being written for
+
+    // Edits not yet journalled
+    int dirty;                 // Aspects of dirtyLevel (bitmask of Record)
+    int dirtyLevel;
+    bool dirtyProject;         // Project restructured. Needs a snapshot.
+    QSet<int> dirtyHeightPatterns;
+    QSet<int> dirtySceneryPatterns;
+
+    // Edits only held by the snapshots still being written. Marked again if a snapshot fails.
+    int compacting;            // Snapshots requested, but not yet written
+    int unsaved;
+    int unsavedLevel;
+    bool unsavedProject;
+    QSet<int> unsavedHeightPatterns;
+    QSet<int> unsavedSceneryPatterns;
+
+    void mark(int record);
+    QByteArray createRecord(int record, int index);
+    bool applyRecord(const QByteArray& payload, QMap<int, QString>& sectionNames, QMap<int, QStringList>& spriteNames);
+};
+
+#endif // JOURNAL_HPP
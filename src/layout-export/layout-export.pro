@@ -0,0 +1,39 @@
+#-------------------------------------------------
+#
+# layout-export QMake File
+#
+# Headless export of LayOut projects to CannonBall,
+# for batch builds. Shares the project and export
+# code with the editor.
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+
+TARGET = layout-export
+TEMPLATE = app
+
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += main.cpp \
+        ../projectfile.cpp \
+        ../leveldata.cpp \
+        ../export/exportcannonball.cpp \
+        ../export/exportsnapshot.cpp
+
+HEADERS += ../projectfile.hpp \
+        ../projectsnapshot.hpp \
+        ../leveldata.hpp \
+        ../controlpoint.hpp \
+        ../stdint.hpp \
+        ../globals.hpp \
+        ../levels/levelconstants.hpp \
+        ../levels/levelpalette.hpp \
+        ../height/heightformat.hpp \
+        ../sprites/spriteformat.hpp \
+        ../export/exportbase.hpp \
+        ../export/exportcannonball.hpp \
+        ../export/exportsnapshot.hpp
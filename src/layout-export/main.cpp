@@ -0,0 +1,212 @@
+/***************************************************************************
+    Layout: A Track Editor for OutRun
+    - Headless CannonBall Export
+
+    Exports one or more projects to CannonBall track files, without the
+    editor. Projects are exported in parallel, on worker threads.
+
+    Usage: layout-export [-o directory] [-j jobs] project.xml...
+
+    Returns a non-zero status if any project fails to export.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <iostream>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSet>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include "projectsnapshot.hpp"
+#include "projectfile.hpp"
+#include "levels/levelconstants.hpp"
+#include "export/exportcannonball.hpp"
+#include "export/exportsnapshot.hpp"
+
+struct ExportJob
+{
+    QString project;
+    QString output;
+};
+
+struct ExportResult
+{
+    bool success;
+    QString error;
+    qint64 bytes;
+    qint64 readTime;          // Milliseconds
+    qint64 exportTime;        // Milliseconds
+
+    ExportResult() : success(false), bytes(0), readTime(0), exportTime(0) {}
+};
+
+// The editor guarantees these, but a project file may have been edited by hand
+static bool validateProject(const ProjectSnapshot& project, QString* error)
+{
+    bool split = false;
+
+    foreach (const ProjectLevel& level, project.levels)
+    {
+        if (level.type < LevelConstants::NORMAL || level.type > LevelConstants::SPLIT)
+        {
+            *error = "Level '" + level.name + "' has an unknown type";
+            return false;
+        }
+        split |= level.type == LevelConstants::SPLIT;
+    }
+
+    if (!split)
+    {
+        *error = "Project has no split section";
+        return false;
+    }
+
+    for (int i = 0; i < LevelConstants::MAP_SLOTS; i++)
+    {
+        if (project.mapping.at(i) < 0 || project.mapping.at(i) >= project.levels.size())
+        {
+            *error = "Stage " + QString::number(i) + " is not mapped to a level";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Runs on a worker thread
+static ExportResult exportProject(const ExportJob& job)
+{
+    ExportResult result;
+    QElapsedTimer timer;
+    timer.start();
+
+    ProjectSnapshot project;
+
+    if (!ProjectFile::read(job.project, project, &result.error) ||
+        !validateProject(project, &result.error))
+        return result;
+
+    result.readTime = timer.restart();
+
+    ExportCannonball exporter;
+    const ExportSnapshot snapshot(project);
+
+    if (!exporter.write(job.output, snapshot))
+    {
+        result.error = exporter.getError();
+        return result;
+    }
+
+    result.exportTime = timer.elapsed();
+    result.bytes      = QFileInfo(job.output).size();
+    result.success    = true;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("layout-export");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Export LayOut projects to CannonBall track files.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("projects", "LayOut projects (.xml) to export.", "project.xml...");
+
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Write track files to <directory>, rather than alongside each project.",
+                                    "directory");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs",
+                                  "Export <jobs> projects at once. Defaults to the number of cores.",
+                                  "jobs");
+    parser.addOption(outputOption);
+    parser.addOption(jobsOption);
+    parser.process(app);
+
+    const QStringList projects = parser.positionalArguments();
+
+    if (projects.isEmpty())
+        parser.showHelp(1);
+
+    if (parser.isSet(jobsOption))
+    {
+        const int jobs = parser.value(jobsOption).toInt();
+
+        if (jobs < 1)
+        {
+            std::cerr << "layout-export: invalid number of jobs" << std::endl;
+            return 1;
+        }
+        QThreadPool::globalInstance()->setMaxThreadCount(jobs);
+    }
+
+    QDir outputDir;
+    if (parser.isSet(outputOption))
+    {
+        outputDir = QDir(parser.value(outputOption));
+
+        if (!outputDir.exists() && !QDir().mkpath(outputDir.path()))
+        {
+            std::cerr << "layout-export: unable to create " << qPrintable(outputDir.path()) << std::endl;
+            return 1;
+        }
+    }
+
+    // Each project is written to a track file of the same name
+    QList<ExportJob> jobs;
+    QSet<QString> outputs;
+    int failed = 0;
+
+    foreach (const QString& filename, projects)
+    {
+        QFileInfo info(filename);
+        ExportJob job;
+        job.project = filename;
+        job.output  = (parser.isSet(outputOption) ? outputDir : info.dir()).filePath(info.completeBaseName() + ".bin");
+
+        if (outputs.contains(QFileInfo(job.output).absoluteFilePath()))
+        {
+            std::cerr << "layout-export: " << qPrintable(filename) << ": "
+                      << qPrintable(job.output) << " is also written by another project" << std::endl;
+            failed++;
+            continue;
+        }
+
+        outputs.insert(QFileInfo(job.output).absoluteFilePath());
+        jobs.push_back(job);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QList<ExportResult> results = QtConcurrent::blockingMapped<QList<ExportResult> >(jobs, exportProject);
+
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        const ExportJob& job       = jobs.at(i);
+        const ExportResult& result = results.at(i);
+
+        if (result.success)
+        {
+            std::cout << qPrintable(job.project) << " -> " << qPrintable(job.output)
+                      << ": " << result.bytes << " bytes"
+                      << " (read " << result.readTime << " ms, export " << result.exportTime << " ms)" << std::endl;
+        }
+        else
+        {
+            std::cerr << "layout-export: " << qPrintable(job.project) << ": " << qPrintable(result.error) << std::endl;
+            failed++;
+        }
+    }
+
+    std::cout << (projects.size() - failed) << " exported, " << failed << " failed"
+              << " in " << timer.elapsed() << " ms" << std::endl;
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/***************************************************************************
+    Level Change Tracking.
+
+    Editors report what they have changed here, rather than simply asking
+    for the preview to be redrawn. Each change is published as a typed
+    signal and bumps a generation counter for the data it affects.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <iostream>
+#include "levelchanges.hpp"
+
+LevelChanges::LevelChanges(QObject *parent) :
+    QObject(parent)
+{
+    for (int i = 0; i < ASPECTS; i++)
+        generation[i] = 0;
+}
+
+void LevelChanges::bump(int aspect)
+{
+    generation[aspect]++;
+
+    if (DEBUG)
+        std::cout << "LevelChanges: aspect " << aspect << " generation " << generation[aspect] << std::endl;
+}
+
+// Path changed between the two positions. Positions after endPos are unaffected.
+void LevelChanges::notifyPath(int startPos, int endPos)
+{
+    bump(PATH);
+    emit pathChanged(startPos, endPos);
+}
+
+// Road width changed from this position onwards
+void LevelChanges::notifyWidth(int startPos)
+{
+    bump(WIDTH);
+    emit widthChanged(startPos);
+}
+
+void LevelChanges::notifyHeightPoints()
+{
+    bump(HEIGHT_POINTS);
+    emit heightPointsChanged();
+}
+
+void LevelChanges::notifySceneryPoints()
+{
+    bump(SCENERY_POINTS);
+    emit sceneryPointsChanged();
+}
+
+void LevelChanges::notifyHeightPattern(int index)
+{
+    bump(HEIGHT_PATTERNS);
+    emit heightPatternChanged(index);
+}
+
+void LevelChanges::notifySceneryPattern(int index)
+{
+    bump(SCENERY_PATTERNS);
+    emit sceneryPatternChanged(index);
+}
+
+void LevelChanges::notifyPalette()
+{
+    bump(PALETTE);
+    emit paletteChanged();
+}
+
+// Scenery pattern selected or deselected. The data is unchanged, but the preview highlights the selection.
+void LevelChanges::notifyScenerySelection(int index)
+{
+    bump(SCENERY_SELECTION);
+    emit scenerySelectionChanged(index);
+}
+
+// A different level has been loaded, or the project replaced. Everything has changed.
+void LevelChanges::notifyLevel()
+{
+    for (int i = 0; i < ASPECTS; i++)
+        bump(i);
+
+    emit levelChanged();
+}
+
+// Levels added, deleted, renamed or remapped, or the project replaced. Switching the active
+// level doesn't change the project, so only notifies levelChanged.
+void LevelChanges::notifyProject()
+{
+    emit projectChanged();
+}
@@ -0,0 +1,76 @@
+/***************************************************************************
+    Level Change Tracking.
+
+    Editors report what they have changed here, rather than simply asking
+    for the preview to be redrawn. Each change is published as a typed
+    signal and bumps a generation counter for the data it affects.
+
+    Consumers can use the signals to invalidate exactly what is affected,
+    or compare generations to find out whether anything they depend on has
+    changed since they last looked.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include "stdint.hpp"
+
+class LevelChanges : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Data that can change
+    enum Aspect
+    {
+        PATH,             // Path points of the active level
+        WIDTH,            // Width points or start width of the active level
+        HEIGHT_POINTS,    // Height points of the active level
+        SCENERY_POINTS,   // Scenery points (and start line) of the active level
+        HEIGHT_PATTERNS,  // Height pattern list
+        SCENERY_PATTERNS, // Scenery pattern list
+        PALETTE,          // Level palette
+        SCENERY_SELECTION,// Selection within the scenery pattern list (not an edit)
+        ASPECTS
+    };
+
+    // Pattern index when the list itself has been restructured
+    const static int ALL_PATTERNS = -1;
+
+    explicit LevelChanges(QObject *parent = 0);
+
+    uint32_t getGeneration(int aspect) const { return generation[aspect]; }
+
+    void notifyPath(int startPos, int endPos);
+    void notifyWidth(int startPos);
+    void notifyHeightPoints();
+    void notifySceneryPoints();
+    void notifyHeightPattern(int index = ALL_PATTERNS);
+    void notifySceneryPattern(int index = ALL_PATTERNS);
+    void notifyPalette();
+    void notifyScenerySelection(int index);
+    void notifyLevel();
+    void notifyProject();
+
+signals:
+    void pathChanged(int startPos, int endPos);
+    void widthChanged(int startPos);
+    void heightPointsChanged();
+    void sceneryPointsChanged();
+    void heightPatternChanged(int index);
+    void sceneryPatternChanged(int index);
+    void paletteChanged();
+    void scenerySelectionChanged(int index);
+    void levelChanged();
+    void projectChanged();
+
+private:
+    const static bool DEBUG = false;
+
+    uint32_t generation[ASPECTS];
+
+    void bump(int aspect);
+};
@@ -20,9 +20,6 @@
 #include <QtCore/qmath.h>
 #include "leveldata.hpp"
 
-// Global reference to the current level
-LevelData* levelData;
-
 LevelData::LevelData(LevelPalette* pal, int type, QList<PathPoint> *points)
 {
     this->pal    = pal;
@@ -136,7 +133,7 @@ void LevelData::updatePathData()
 
 // Get the rectangle co-ordinates containing the path
 // This can probably be merged with the below
-QRectF LevelData::getPathRect()
+QRectF LevelData::getPathRect() const
 {
     const static int PADDING = 40;
 
@@ -525,7 +522,7 @@ int LevelData::insertSceneryPoint(int pos)
 }
 
 // Convert Position to QPoint
-QPoint LevelData::posToPoint(int pos)
+QPoint LevelData::posToPoint(int pos) const
 {
     return path_render[pos];
 }
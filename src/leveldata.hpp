@@ -135,7 +135,7 @@ public:
     ~LevelData();
     void clear();
     void updatePathData();
-    QRectF getPathRect();
+    QRectF getPathRect() const;
     void updateWidthData();
     void insertPathPoint(int index);
     void deletePathPoint(int index);
@@ -145,7 +145,7 @@ public:
     int  insertWidthPoint(int);
     int  insertHeightPoint(int);
     int  insertSceneryPoint(int);
-    QPoint posToPoint(int);
+    QPoint posToPoint(int) const;
     int splitPathPoints(int insertPos);
 
 private:
@@ -153,6 +153,4 @@ private:
     void updateRenderData();
 };
 
-extern LevelData* levelData;
-
 #endif // ROADDATA_HPP
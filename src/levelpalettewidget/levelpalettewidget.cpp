@@ -10,15 +10,18 @@
 ***************************************************************************/
 
 #include "leveldata.hpp"
+#include "levelchanges.hpp"
 #include "utils.hpp"
 #include "levelpalettewidget.hpp"
 #include "ui_levelpalettewidget.h"
 
-LevelPaletteWidget::LevelPaletteWidget(QWidget *parent, LevelPalette *levelPal) :
+LevelPaletteWidget::LevelPaletteWidget(QWidget *parent, LevelPalette *levelPal, LevelChanges *changes) :
     QWidget(parent),
     ui(new Ui::RoadPaletteWidget)
 {
-    pal = levelPal;
+    pal           = levelPal;
+    level         = NULL;
+    this->changes = changes;
 
     ui->setupUi(this);
 
@@ -57,19 +60,22 @@ LevelPaletteWidget::~LevelPaletteWidget()
     delete ui;
 }
 
-void LevelPaletteWidget::refresh()
+// Show the palettes selected by this level
+void LevelPaletteWidget::refresh(LevelData* level)
 {
+    this->level = level;
+
     refreshRoadPalette();
-    ui->spinRoadPal->setValue(levelData->roadPal);
+    ui->spinRoadPal->setValue(level->roadPal);
     refreshSkyPalette();
-    ui->spinSkyPal->setValue(levelData->skyPal);
+    ui->spinSkyPal->setValue(level->skyPal);
     refreshGndPalette();
-    ui->spinGndPal->setValue(levelData->gndPal);
+    ui->spinGndPal->setValue(level->gndPal);
 }
 
 void LevelPaletteWidget::refreshRoadPalette()
 {
-    uint32_t* roadPal = pal->road[levelData->roadPal];
+    uint32_t* roadPal = pal->road[level->roadPal];
 
     setupWidget(ui->road1Back,   roadPal[LevelPalette::ROAD1]);
     setupWidget(ui->road1Cent,   roadPal[LevelPalette::CENTRE1]);
@@ -88,7 +94,7 @@ void LevelPaletteWidget::refreshSkyPalette()
     QRgb* rgb = new QRgb[pal->SKY_LENGTH * 2];
     for (int i = 0; i < pal->SKY_LENGTH * 2;)
     {
-        uint32_t color = pal->sky[levelData->skyPal][--src];
+        uint32_t color = pal->sky[level->skyPal][--src];
         rgb[i++] = Utils::convertToQT(color & 0xFFFF);
         rgb[i++] = Utils::convertToQT(color >> 16);
     }
@@ -103,7 +109,7 @@ void LevelPaletteWidget::refreshGndPalette()
     QRgb* rgb = new QRgb[pal->GND_LENGTH * 2];
     for (int i = 0; i < pal->GND_LENGTH * 2;)
     {
-        uint32_t color = pal->gnd[levelData->gndPal][--src];
+        uint32_t color = pal->gnd[level->gndPal][--src];
         rgb[i++] = Utils::convertToQT(color & 0xFFFF);
         rgb[i++] = Utils::convertToQT(color >> 16);
     }
@@ -122,82 +128,90 @@ void LevelPaletteWidget::setupWidget(PreviewPalette* widget, uint32_t color)
 
 void LevelPaletteWidget::setRoad1Back(int entry, uint16_t s16Color)
 {
-    setRoadColor(&pal->road[levelData->roadPal][LevelPalette::ROAD1], entry, s16Color);
+    setRoadColor(&pal->road[level->roadPal][LevelPalette::ROAD1], entry, s16Color);
 }
 
 void LevelPaletteWidget::setRoad1Cent(int entry, uint16_t s16Color)
 {
-    setRoadColor(&pal->road[levelData->roadPal][LevelPalette::CENTRE1], entry, s16Color);
+    setRoadColor(&pal->road[level->roadPal][LevelPalette::CENTRE1], entry, s16Color);
 }
 
 void LevelPaletteWidget::setRoad1Edge(int entry, uint16_t s16Color)
 {
-    setRoadColor(&pal->road[levelData->roadPal][LevelPalette::SIDE1], entry, s16Color);
+    setRoadColor(&pal->road[level->roadPal][LevelPalette::SIDE1], entry, s16Color);
 }
 
 void LevelPaletteWidget::setRoad1Stripe(int entry, uint16_t s16Color)
 {
-    setRoadColor(&pal->road[levelData->roadPal][LevelPalette::STRIPE1], entry, s16Color);
+    setRoadColor(&pal->road[level->roadPal][LevelPalette::STRIPE1], entry, s16Color);
 }
 
 void LevelPaletteWidget::setRoad2Back(int entry, uint16_t s16Color)
 {
-    setRoadColor(&pal->road[levelData->roadPal][LevelPalette::ROAD2], entry, s16Color);
+    setRoadColor(&pal->road[level->roadPal][LevelPalette::ROAD2], entry, s16Color);
 }
 
 void LevelPaletteWidget::setRoad2Cent(int entry, uint16_t s16Color)
 {
-    setRoadColor(&pal->road[levelData->roadPal][LevelPalette::CENTRE2], entry, s16Color);
+    setRoadColor(&pal->road[level->roadPal][LevelPalette::CENTRE2], entry, s16Color);
 }
 
 void LevelPaletteWidget::setRoad2Edge(int entry, uint16_t s16Color)
 {
-    setRoadColor(&pal->road[levelData->roadPal][LevelPalette::SIDE2], entry, s16Color);
+    setRoadColor(&pal->road[level->roadPal][LevelPalette::SIDE2], entry, s16Color);
 }
 
 void LevelPaletteWidget::setRoad2Stripe(int entry, uint16_t s16Color)
 {
-    setRoadColor(&pal->road[levelData->roadPal][LevelPalette::STRIPE2], entry, s16Color);
+    setRoadColor(&pal->road[level->roadPal][LevelPalette::STRIPE2], entry, s16Color);
 }
 
 // Change a colour in a Sky Palette
 void LevelPaletteWidget::setSky(int entry, uint16_t s16Color)
 {
     // (Note we invert this palette in terms of order for usability)
-    setRoadColor(&pal->sky[levelData->skyPal][pal->SKY_LENGTH - (entry >> 1) - 1], entry ^ 1, s16Color);
+    setRoadColor(&pal->sky[level->skyPal][pal->SKY_LENGTH - (entry >> 1) - 1], entry ^ 1, s16Color);
 }
 
 // Select Specific Sky Palette
 void LevelPaletteWidget::setSkyIndex(int value)
 {
-    levelData->skyPal = value;
+    level->skyPal = value;
     refreshSkyPalette();
     emit refreshPreview();
-    emit refreshPalette();
+    paletteChanged();
 }
 
 // Change a colour in a Ground Palette
 void LevelPaletteWidget::setGnd(int entry, uint16_t s16Color)
 {
     // (Note we invert this palette in terms of order for usability)
-    setRoadColor(&pal->gnd[levelData->gndPal][pal->GND_LENGTH - (entry >> 1) - 1], entry ^ 1, s16Color);
+    setRoadColor(&pal->gnd[level->gndPal][pal->GND_LENGTH - (entry >> 1) - 1], entry ^ 1, s16Color);
 }
 
 // Select Specific Ground Palette
 void LevelPaletteWidget::setGndIndex(int value)
 {
-    levelData->gndPal = value;
+    level->gndPal = value;
     refreshGndPalette();
     emit refreshPreview();
-    emit refreshPalette();
+    paletteChanged();
 }
 
 // Select Specific Road Palette
 void LevelPaletteWidget::setRoadIndex(int value)
 {
-    levelData->roadPal = value;
+    level->roadPal = value;
     refreshRoadPalette();
     emit refreshPreview();
+    paletteChanged();
+}
+
+void LevelPaletteWidget::paletteChanged()
+{
+    if (changes != NULL)
+        changes->notifyPalette();
+
     emit refreshPalette();
 }
 
@@ -214,33 +228,33 @@ void LevelPaletteWidget::setRoadColor(uint32_t* p, int entry, uint16_t s16Color)
         *p |= (s16Color << 16);
     }
 
-    emit refreshPalette();
+    paletteChanged();
 }
 
 // Copy Road 1 Palette to Road 2
 void LevelPaletteWidget::copyRoad1Palette()
 {
-    uint32_t* roadPal = pal->road[levelData->roadPal];
+    uint32_t* roadPal = pal->road[level->roadPal];
     roadPal[LevelPalette::ROAD2]   = roadPal[LevelPalette::ROAD1];
     roadPal[LevelPalette::SIDE2]   = roadPal[LevelPalette::SIDE1];
     roadPal[LevelPalette::STRIPE2] = roadPal[LevelPalette::STRIPE1];
     roadPal[LevelPalette::CENTRE2] = roadPal[LevelPalette::CENTRE1];
     refresh();
     emit refreshPreview();
-    emit refreshPalette();
+    paletteChanged();
 }
 
 // Copy Road 2 Palette to Road 1
 void LevelPaletteWidget::copyRoad2Palette()
 {
-    uint32_t* roadPal = pal->road[levelData->roadPal];
+    uint32_t* roadPal = pal->road[level->roadPal];
     roadPal[LevelPalette::ROAD1]   = roadPal[LevelPalette::ROAD2];
     roadPal[LevelPalette::SIDE1]   = roadPal[LevelPalette::SIDE2];
     roadPal[LevelPalette::STRIPE1] = roadPal[LevelPalette::STRIPE2];
     roadPal[LevelPalette::CENTRE1] = roadPal[LevelPalette::CENTRE2];
     refresh();
     emit refreshPreview();
-    emit refreshPalette();
+    paletteChanged();
 }
 
 void LevelPaletteWidget::fillSky()
@@ -259,14 +273,14 @@ void LevelPaletteWidget::fillSky()
         rgb[i] = startColor.rgb();
         const uint16_t color = Utils::convertToS16(rgb[i]);
 
-        uint32_t *p = &pal->sky[levelData->skyPal][pal->SKY_LENGTH - 1 - (i >> 1)];
+        uint32_t *p = &pal->sky[level->skyPal][pal->SKY_LENGTH - 1 - (i >> 1)];
         *p = (i & 1) ? ((*p & 0x00000FFFF) + (color << 16))
                      : ((*p & 0xFFFFF0000) + color);
     }
 
     refreshSkyPalette();
     emit refreshPreview();
-    emit refreshPalette();
+    paletteChanged();
 }
 
 void LevelPaletteWidget::interpolateSky()
@@ -306,14 +320,14 @@ void LevelPaletteWidget::interpolateSky()
         rgb[i] = QColor(r, g, b).rgb();
         const uint16_t color = Utils::convertToS16(rgb[i]);
 
-        uint32_t *p = &pal->sky[levelData->skyPal][pal->SKY_LENGTH - 1 - (i >> 1)];
+        uint32_t *p = &pal->sky[level->skyPal][pal->SKY_LENGTH - 1 - (i >> 1)];
         *p = (i & 1) ? ((*p & 0x00000FFFF) + (color << 16))
                      : ((*p & 0xFFFFF0000) + color);
     }
 
     refreshSkyPalette();
     emit refreshPreview();
-    emit refreshPalette();
+    paletteChanged();
 }
 
 void LevelPaletteWidget::interpolateGround()
@@ -353,7 +367,7 @@ void LevelPaletteWidget::interpolateGround()
         rgb[i+1] = QColor(r, g, b).rgb();
         const uint16_t color2 = Utils::convertToS16(rgb[i+1]);
 
-        uint32_t *p = &pal->gnd[levelData->gndPal][pal->GND_LENGTH - 1 - (i >> 1)];
+        uint32_t *p = &pal->gnd[level->gndPal][pal->GND_LENGTH - 1 - (i >> 1)];
         *p = color1 + (color2 << 16);
 
         step++;
@@ -361,7 +375,7 @@ void LevelPaletteWidget::interpolateGround()
 
     refreshGndPalette();
     emit refreshPreview();
-    emit refreshPalette();
+    paletteChanged();
 }
 
 // Interpolate between two values.
@@ -16,7 +16,9 @@
 #include "stdint.hpp"
 
 class PreviewPalette;
+class LevelChanges;
 struct LevelPalette;
+class LevelData;
 
 namespace Ui {
 class RoadPaletteWidget;
@@ -27,9 +29,9 @@ class LevelPaletteWidget : public QWidget
     Q_OBJECT
     
 public:
-    explicit LevelPaletteWidget(QWidget *parent = 0, LevelPalette* roadPalette = NULL);
+    explicit LevelPaletteWidget(QWidget *parent = 0, LevelPalette* roadPalette = NULL, LevelChanges* changes = NULL);
     ~LevelPaletteWidget();
-    void refresh();
+    void refresh(LevelData* level);
 
 signals:
     void refreshPalette();
@@ -58,9 +60,12 @@ private slots:
 private:
     Ui::RoadPaletteWidget *ui;
     LevelPalette *pal;
+    LevelData *level;
+    LevelChanges *changes;
 
     void setupWidget(PreviewPalette* widget, uint32_t color);
     void setRoadColor(uint32_t *p, int entry, uint16_t s16Color);
+    void paletteChanged();
     void refreshRoadPalette();
     void refreshSkyPalette();
     void refreshGndPalette();
@@ -0,0 +1,27 @@
+/***************************************************************************
+    Level Types And Mapping Slots
+
+    Shared by the editor and the headless export tool, so has no
+    dependency on the widgets.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifndef LEVELCONSTANTS_HPP
+#define LEVELCONSTANTS_HPP
+
+#include "../globals.hpp"
+
+struct LevelConstants
+{
+    // Sections Headings
+    static const int NORMAL = 0;
+    static const int END    = 1;
+    static const int SPLIT  = 2;
+
+    // Slots in mapping array (15 levels + end sections)
+    static const int MAP_SLOTS = 20;
+};
+
+#endif // LEVELCONSTANTS_HPP
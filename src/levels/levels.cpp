@@ -6,14 +6,23 @@
     See license.txt for more details.
 ***************************************************************************/
 #include <iostream>
+#include <QTimer>
 #include "ui_levels.h"
 #include "levels.hpp"
+#include "../thumbnailcache.hpp"
 
 Levels::Levels(QWidget *parent, LevelPalette *roadPalette) :
     QWidget(parent),
     ui(new Ui::Levels)
 {
     pal = roadPalette;
+    changes = new LevelChanges(this);
+    thumbnails = NULL;
+
+    thumbnailTimer = new QTimer(this);
+    thumbnailTimer->setSingleShot(true);
+    thumbnailTimer->setInterval(THUMBNAIL_DELAY);
+    connect(thumbnailTimer, SIGNAL(timeout()), this, SLOT(updateThumbnail()));
 
     ui->setupUi(this);
 
@@ -21,11 +30,12 @@ Levels::Levels(QWidget *parent, LevelPalette *roadPalette) :
     ui->treeView->setModel(new QStandardItemModel());
 
     connect(ui->treeView->model(),          SIGNAL(itemChanged(QStandardItem*)),             this, SLOT(updateLevelLabels(QStandardItem*)));
+    connect(ui->treeView->itemDelegate(),   SIGNAL(commitData(QWidget*)),                    this, SLOT(levelRenamed()));
     connect(ui->buttonSwitch,               SIGNAL(clicked()),                               this, SLOT(setLevel()));
     connect(ui->buttonNew,                  SIGNAL(clicked()),                               this, SLOT(newLevelButton()));
     connect(ui->buttonDelete,               SIGNAL(clicked()),                               this, SLOT(deleteLevel()));
     connect(ui->buttonMap,                  SIGNAL(clicked()),                               this, SLOT(mapLevel()));
-    connect(ui->checkStartLine,             SIGNAL(clicked()),                               this, SIGNAL(refreshPreview()));
+    connect(ui->checkStartLine,             SIGNAL(clicked()),                               this, SLOT(toggleStartLine()));
     connect(ui->treeView->selectionModel(), SIGNAL(currentChanged(QModelIndex,QModelIndex)), this, SLOT(updateDeleteButton()));
     connect(ui->treeView->selectionModel(), SIGNAL(currentChanged(QModelIndex,QModelIndex)), this, SLOT(updateMapButton()));
     connect(ui->treeView->selectionModel(), SIGNAL(currentChanged(QModelIndex,QModelIndex)), this, SLOT(updateEditButton()));
@@ -136,6 +146,7 @@ void Levels::init()
         levelMap[i] = -1;
 
     setDefaultPalette();
+    changes->notifyProject();
 }
 
 void Levels::setDefaultPalette()
@@ -186,7 +197,7 @@ void Levels::setDefaultMapping()
 void Levels::selectFirstLevel()
 {
     QStandardItemModel* model = (QStandardItemModel*) ui->treeView->model();
-    levelData = levels[0];
+    activeLevel = 0;
     QModelIndex mi = model->index(0, 0);
     ui->treeView->setCurrentIndex(mi);
     ui->treeView->expandAll();
@@ -261,6 +272,7 @@ void Levels::insertLevel(QStandardItem* parent, QString name, LevelData* level,
     item->setCheckState(Qt::Unchecked);
     parent->appendRow(item);
     updateDeleteButton();
+    changes->notifyProject();
 }
 
 void Levels::deleteLevel()
@@ -322,6 +334,7 @@ void Levels::deleteLevel()
 
     updateLevelLabels(NULL);
     updateDeleteButton();
+    changes->notifyProject();
 }
 
 void Levels::setLevel()
@@ -360,22 +373,30 @@ void Levels::setLevel(int section, int index)
         activeLevel = normalSection->rowCount() + endSection->rowCount();
     }
 
-    levelData = levels[activeLevel];
+    LevelData* level = levels[activeLevel];
 
-    if (levelData->type == NORMAL)
+    if (level->type == NORMAL)
     {
         if (getMappedLevel(0) == activeLevel)
-            levelData->startWidth = START_WIDTH_L1;
+            level->startWidth = START_WIDTH_L1;
         // Other Level
         else
-            levelData->startWidth = START_WIDTH;
+            level->startWidth = START_WIDTH;
     }
 
-    levelData->updatePathData();
+    level->updatePathData();
+    changes->notifyLevel();
 
     emit loadLevel();
 }
 
+// The start line is drawn as part of the scenery
+void Levels::toggleStartLine()
+{
+    changes->notifySceneryPoints();
+    emit refreshPreview();
+}
+
 void Levels::mapLevel()
 {
     int index = getSelectedRow();
@@ -399,12 +420,19 @@ void Levels::mapLevel()
         }
 
         // The start width of a level is hard coded.
+        LevelData* level = levels[activeLevel];
+
         if (getMappedLevel(0) == activeLevel)
-            levelData->startWidth = START_WIDTH_L1;
+            level->startWidth = START_WIDTH_L1;
         else
-            levelData->startWidth = START_WIDTH;
+            level->startWidth = START_WIDTH;
+
+        level->updateWidthData();
 
-        levelData->updateWidthData();
+        // The start width and start line depend on the level mapped to the first stage
+        changes->notifyWidth(0);
+        changes->notifySceneryPoints();
+        changes->notifyProject();
         emit refreshPreview();
     }
 }
@@ -425,6 +453,12 @@ void Levels::updateLevelLabels(QStandardItem*)
     }
 }
 
+// Name edited in the tree view
+void Levels::levelRenamed()
+{
+    changes->notifyProject();
+}
+
 void Levels::renameLevel(int index, QString name)
 {
     if (index < getNumNormalLevels())
@@ -444,6 +478,48 @@ void Levels::setMappedLevel(int stage, int value)
 
 }
 
+// ------------------------------------------------------------------------------------------------
+// Thumbnails
+// ------------------------------------------------------------------------------------------------
+
+void Levels::setThumbnails(ThumbnailCache* thumbnails)
+{
+    this->thumbnails = thumbnails;
+    ui->treeView->setIconSize(QSize(ThumbnailCache::LEVEL_SIZE, ThumbnailCache::LEVEL_SIZE));
+
+    connect(changes, SIGNAL(pathChanged(int,int)), thumbnailTimer, SLOT(start()));
+    connect(changes, SIGNAL(levelChanged()),       this,           SLOT(updateThumbnails()));
+
+    updateThumbnails();
+}
+
+// Tree item representing a level
+QStandardItem* Levels::getLevelItem(int index)
+{
+    if (index < getNumNormalLevels())
+        return normalSection->child(index);
+    else if (index < getNumNormalLevels() + getNumEndSections())
+        return endSection->child(index - getNumNormalLevels());
+    else
+        return splitSection;
+}
+
+// Path of the active level has been edited
+void Levels::updateThumbnail()
+{
+    if (thumbnails != NULL && activeLevel < levels.size())
+        thumbnails->setLevelThumbnail(getLevelItem(activeLevel), levels[activeLevel]);
+}
+
+void Levels::updateThumbnails()
+{
+    if (thumbnails == NULL)
+        return;
+
+    for (int i = 0; i < levels.size(); i++)
+        thumbnails->setLevelThumbnail(getLevelItem(i), levels[i]);
+}
+
 // ------------------------------------------------------------------------------------------------
 // TreeView Helper Functions
 // ------------------------------------------------------------------------------------------------
@@ -583,6 +659,8 @@ void Levels::swapScenerySections(int swap1, int swap2)
                 cp->value2 = swap1;
         }
     }
+
+    changes->notifySceneryPoints();
 }
 
 void Levels::remapScenerySections(int id, int mode)
@@ -620,6 +698,8 @@ void Levels::remapScenerySections(int id, int mode)
             }
         }
     }
+
+    changes->notifySceneryPoints();
 }
 
 void Levels::swapHeightSections(int swap1, int swap2)
@@ -636,6 +716,8 @@ void Levels::swapHeightSections(int swap1, int swap2)
                 cp->value1 = swap1;
         }
     }
+
+    changes->notifyHeightPoints();
 }
 
 
@@ -675,4 +757,6 @@ void Levels::remapHeightSections(int id, int mode)
             }
         }
     }
+
+    changes->notifyHeightPoints();
 }
\ No newline at end of file
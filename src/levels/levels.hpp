@@ -12,27 +12,23 @@
 #include <QWidget>
 #include "../globals.hpp"
 #include "../leveldata.hpp"
+#include "../levelchanges.hpp"
+#include "levelconstants.hpp"
 
 class QRadioButton;
 class QLabel;
+class QTimer;
+class ThumbnailCache;
 
 namespace Ui {
 class Levels;
 }
 
-class Levels : public QWidget
+class Levels : public QWidget, public LevelConstants
 {
     Q_OBJECT
     
 public:
-    // Sections Headings
-    static const int NORMAL = 0;
-    static const int END    = 1;
-    static const int SPLIT  = 2;
-
-    // Slots in mapping array (15 levels + end sections)
-    static const int MAP_SLOTS = 20;
-
     explicit Levels(QWidget *parent = 0, LevelPalette* roadPalette = NULL);
     ~Levels();
     void init();
@@ -53,6 +49,7 @@ public:
     void newLevel(QString name);
     void newEndSection();
     void newEndSection(QString name);
+    void setThumbnails(ThumbnailCache* thumbnails);
 
     // Get Split Level
     LevelData* getSplit()                 { return levels[normalSection->rowCount() + endSection->rowCount()]; }
@@ -75,12 +72,21 @@ public:
     // Get The Active Level Opened In The Editor
     int getActiveLevel()                  { return activeLevel; }
 
+    // Get A Pointer To The Level Opened In The Editor
+    LevelData* getActiveLevelP()          { return levels[activeLevel]; }
+
+    // Get The Palette Shared By All Levels
+    LevelPalette* getPalette()            { return pal; }
+
     // Get The Level Mapped To this Stage
     int getMappedLevel(int stage)         { return levelMap[stage]; }
 
     // Get A Pointer To The Level Mapped To This Stage
     LevelData* getMappedLevelP(int stage) { return levels[levelMap[stage]]; }
 
+    // Get The Change Tracker For Level Data
+    LevelChanges* getChanges()            { return changes; }
+
 signals:
     void loadLevel();
     void refreshPreview();
@@ -92,10 +98,14 @@ public slots:
 private slots:
     void deleteLevel();
     void mapLevel();
+    void toggleStartLine();
     void updateLevelLabels(QStandardItem* item = NULL);
+    void levelRenamed();
     void updateDeleteButton();
     void updateMapButton();
     void updateEditButton();
+    void updateThumbnail();
+    void updateThumbnails();
 
 private:
     Ui::Levels *ui;
@@ -103,6 +113,9 @@ private:
     // Shared Level Palette Data
     LevelPalette* pal;
 
+    // Change Tracker For Level Data
+    LevelChanges* changes;
+
     // List of Levels
     QList<LevelData*> levels;
 
@@ -130,12 +143,20 @@ private:
     // The Level currently being edited
     int activeLevel;
 
+    // Thumbnails of each level's path
+    ThumbnailCache* thumbnails;
+
+    // Delays redrawing the active level's thumbnail whilst the path is being edited
+    QTimer* thumbnailTimer;
+    const static int THUMBNAIL_DELAY = 250;
+
     void setDefaultPalette();
     void insertLevel(QStandardItem *parent, QString name, LevelData* level, int pos);
     void loadLevel(const char* name);
     int getSelectedRow();
     int getSectionIndex(bool allowClickOnHeader = false);
     int getRadioIndex();
+    QStandardItem* getLevelItem(int index);
 };
 
 #endif // LEVELS_HPP
@@ -15,6 +15,9 @@
 #include <QSignalMapper>
 #include <QSettings>
 #include <QProcess>
+#include <QProgressDialog>
+#include <QProgressBar>
+#include <QLabel>
 #include <QMessageBox>
 #include <QDesktopServices> // URL Handling
 #include <QUrl>
@@ -28,15 +31,34 @@
 #include "levels/levels.hpp"
 #include "import/importoutrun.hpp"
 #include "export/exportcannonball.hpp"
+#include "export/exporttask.hpp"
+#include "savetask.hpp"
+#include "romtask.hpp"
+#include "journal.hpp"
 #include "import/importdialog.hpp"
 #include "settings/settingsdialog.hpp"
 #include "about/about.hpp"
 #include "levelpalettewidget/levelpalettewidget.hpp"
+#include "thumbnailcache.hpp"
+#include "preview/overdrawprofiler.hpp"
 #include "utils.hpp"
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
+// ROM stage imported into each mapping slot. Branches are listed right to left on each row
+// of the mapping panel (2b before 2a), whereas the ROM stores them left to right.
+const static int SLOT_STAGES[Levels::MAP_SLOTS] =
+{
+    0,                      // Stage 1
+    2,  1,                  // Stage 2
+    5,  4,  3,              // Stage 3
+    9,  8,  7,  6,          // Stage 4
+    14, 13, 12, 11, 10,     // Stage 5
+    ImportOutRun::NORMAL_LEVELS + 4, ImportOutRun::NORMAL_LEVELS + 3, ImportOutRun::NORMAL_LEVELS + 2,
+    ImportOutRun::NORMAL_LEVELS + 1, ImportOutRun::NORMAL_LEVELS + 0, // End sections
+};
+
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
@@ -45,7 +67,12 @@ MainWindow::MainWindow(QWidget *parent) :
     externalProcess = NULL;
     aboutDialog     = NULL;
     roadPalette     = new LevelPalette();
-    exportCannon    = new ExportCannonball();
+    exportTask      = NULL;
+    exportDialog    = NULL;
+    saveTask        = NULL;
+    romTask         = NULL;
+    profileDialog   = NULL;
+    launchAfterExport = false;
     importOutRun    = new ImportOutRun();
     importDialog    = new ImportDialog(this, "Import Level", importOutRun->getLevelNames(), true);
     settingsDialog  = new SettingsDialog(this);
@@ -58,10 +85,16 @@ MainWindow::MainWindow(QWidget *parent) :
     // Do this before other UI operations
     ui->setupUi(this);
 
-    // Add additional tabs
-    roadPaletteWidget = new LevelPaletteWidget(this, roadPalette);
-    ui->editModeTabs->addTab(roadPaletteWidget, "Palette");
+    romProgress = new QProgressBar(this);
+    romProgress->setMaximumWidth(160);
+    romProgress->setTextVisible(false);
+    romProgress->hide();
+    ui->statusBar->addPermanentWidget(romProgress);
 
+    previewStats = new QLabel(this);
+    ui->statusBar->addPermanentWidget(previewStats);
+
+    // Add additional tabs
     levels = new Levels(this, roadPalette);
     levels->init();
     levels->newLevel();
@@ -69,6 +102,10 @@ MainWindow::MainWindow(QWidget *parent) :
     levels->selectFirstLevel();
     ui->tabMain->addTab(levels, "Levels");
 
+    roadPaletteWidget = new LevelPaletteWidget(this, roadPalette, levels->getChanges());
+    ui->editModeTabs->addTab(roadPaletteWidget, "Palette");
+    roadPaletteWidget->refresh(levels->getActiveLevelP());
+
     ui->densityBar->setRange(0, 128);
 
     // Setup Path Ranges
@@ -110,6 +147,14 @@ MainWindow::MainWindow(QWidget *parent) :
                                       levels);
     ui->patternList->setModel(ui->spriteTreeView->model());
 
+    // Setup Thumbnails
+    thumbnails = new ThumbnailCache(this);
+    levels->setThumbnails(thumbnails);
+    heightSection->setThumbnails(thumbnails);
+    spriteSection->setThumbnails(thumbnails);
+    ui->heightList->setIconSize(QSize(ThumbnailCache::PATTERN_WIDTH, ThumbnailCache::PATTERN_HEIGHT));
+    ui->patternList->setIconSize(QSize(ThumbnailCache::PATTERN_WIDTH, ThumbnailCache::PATTERN_HEIGHT));
+
     setSpriteProps(NULL);
 
     // --------------------------------------------------------------------------------------------
@@ -121,6 +166,17 @@ MainWindow::MainWindow(QWidget *parent) :
     // Setup Road Path Widget
     ui->roadPathWidget->setSpriteSection(spriteSection);
     ui->roadPathWidget->setHeightSection(heightSection);
+    ui->roadPathWidget->setChanges(levels->getChanges());
+    ui->roadPathWidget->setLevel(levels->getActiveLevelP());
+    ui->roadPathWidget->setSpriteBudget(ui->RenderS16Widget->getSpriteBudget());
+
+    OverdrawProfiler* profiler = ui->RenderS16Widget->getOverdrawProfiler();
+    connect(profiler,             SIGNAL(progress(int, int)),          this,                     SLOT(overdrawProgress(int, int)));
+    connect(profiler,             SIGNAL(finished()),                  this,                     SLOT(overdrawProfiled()));
+
+    // Setup Height Profile
+    ui->heightProfileWidget->setChanges(levels->getChanges());
+    ui->heightProfileWidget->setLevel(levels->getActiveLevelP(), &heightSections);
 
     connect(ui->roadPathWidget,   SIGNAL(refreshPreview()),           ui->RenderS16Widget,      SLOT(redrawPos()));
     connect(ui->roadPathWidget,   SIGNAL(refreshPreview(int)),        ui->spinPosition,         SLOT(setValue(int)));
@@ -147,7 +203,13 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->spinPosition,     SIGNAL(valueChanged(int)),          ui->slidePosition,        SLOT(setValue(int)));
     connect(ui->spinPosition,     SIGNAL(valueChanged(int)),          ui->RenderS16Widget,      SLOT(setRoadPos(int)));
     connect(ui->spinPosition,     SIGNAL(valueChanged(int)),          ui->roadPathWidget,       SLOT(setRoadPos(int)));
+    connect(ui->spinPosition,     SIGNAL(valueChanged(int)),          ui->heightProfileWidget,  SLOT(setPosition(int)));
+    connect(ui->heightProfileWidget, SIGNAL(positionSelected(int)),   ui->spinPosition,         SLOT(setValue(int)));
     connect(ui->checkScenery,     SIGNAL(toggled(bool)),              ui->RenderS16Widget,      SLOT(setSceneryGuides(bool)));
+    connect(ui->checkOverdraw,    SIGNAL(toggled(bool)),              ui->RenderS16Widget,      SLOT(setOverdraw(bool)));
+    connect(ui->checkDrive,       SIGNAL(toggled(bool)),              ui->RenderS16Widget,      SLOT(setDrive(bool)));
+    connect(ui->RenderS16Widget,  SIGNAL(driveChanged(bool)),         ui->checkDrive,           SLOT(setChecked(bool)));
+    connect(ui->RenderS16Widget,  SIGNAL(statsChanged(QString)),      previewStats,             SLOT(setText(QString)));
     connect(ui->comboGuidelines,  SIGNAL(currentIndexChanged(int)),   ui->RenderS16Widget,      SLOT(setGuidelines(int)));
 
     // --------------------------------------------------------------------------------------------
@@ -306,20 +368,25 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(signalMapper, SIGNAL(mappedInt(int)), this, SLOT(updateWidth(int)));
 
     xml = new GenerateXML(levels, heightSection, spriteSection);
+    journal = new Journal(this, levels, heightSection, spriteSection);
     loadSettings();
-    initRomData();
     on_actionNew_Project_triggered();
+    initRomData(); // Recovers the project once the ROMs have loaded
 }
 
 MainWindow::~MainWindow()
 {
     stopExternalProcess();
 
+    // Let any export or save finish writing its snapshot before tearing down
+    delete exportTask;
+    delete saveTask;
+    delete romTask; // Before the ROMs it may be reading from
+
     delete roadPaletteWidget;
     delete roadPalette;
     delete levels;
     delete spriteList;
-    delete exportCannon;
     delete importOutRun;
     delete xml;
     delete settings;
@@ -332,6 +399,7 @@ MainWindow::~MainWindow()
 void MainWindow::closeEvent(QCloseEvent* event)
 {
     saveSettings();
+    journal->stop(); // Clean exit. Nothing to recover.
     return QWidget::closeEvent(event);
 }
 
@@ -342,8 +410,11 @@ void MainWindow::closeEvent(QCloseEvent* event)
 // Called on level switch to a level that already exists.
 void MainWindow::initLevel()
 {
+    ui->roadPathWidget->setLevel(levels->getActiveLevelP());
+    ui->heightProfileWidget->setLevel(levels->getActiveLevelP(), &heightSections);
+
     // Set spin position based on level length. This varies between normal and split levels.
-    ui->spinPosition->setRange(0, levelData->length);
+    ui->spinPosition->setRange(0, levels->getActiveLevelP()->length);
 
     if (importOutRun->romsLoaded)
     {
@@ -352,7 +423,7 @@ void MainWindow::initLevel()
     }
 
     ui->spinPosition->setValue(0);
-    roadPaletteWidget->refresh();
+    roadPaletteWidget->refresh(levels->getActiveLevelP());
     ui->roadPathWidget->init();
     ui->roadPathWidget->setView(ui->editModeTabs->currentIndex()); // also enables insert button correctly
     ui->roadPathWidget->update();
@@ -459,7 +530,7 @@ void MainWindow::setHeightPoint(int value)
             break;
     }
     ui->heightWidget->createSegment();
-    ui->RenderS16Widget->redrawPos();
+    heightSection->sectionChanged();
 }
 
 void MainWindow::setHeightPattern()
@@ -469,8 +540,9 @@ void MainWindow::setHeightPattern()
     int index = ui->roadPathWidget->getCurrentCP();
     if (index != -1)
     {
-        ControlPoint* cp = &levelData->heightP[index];
+        ControlPoint* cp = &levels->getActiveLevelP()->heightP[index];
         cp->value1 = selectedIndex;
+        levels->getChanges()->notifyHeightPoints();
         ui->RenderS16Widget->redrawPos();
     }
 }
@@ -599,8 +671,9 @@ void MainWindow::setSceneryPattern()
     int cp = ui->roadPathWidget->getCurrentCP();
     if (cp != -1 && selectedIndex != -1)
     {
-        ControlPoint* sp = &levelData->spriteP[cp];
+        ControlPoint* sp = &levels->getActiveLevelP()->spriteP[cp];
         sp->value2 = selectedIndex;
+        levels->getChanges()->notifySceneryPoints();
         ui->RenderS16Widget->redrawPos();
     }
 }
@@ -649,11 +722,11 @@ void MainWindow::setZoom(int zoom)
 void MainWindow::on_actionNew_Project_triggered()
 {
     toggleControls(false);
-    levelData->clear();
+    levels->getActiveLevelP()->clear();
     heightSections.clear();
 
     ui->RenderS16Widget->setupRoadPalettes();
-    roadPaletteWidget->refresh();
+    roadPaletteWidget->refresh(levels->getActiveLevelP());
     ui->roadPathWidget->init();
     heightSection->generate();
     heightSection->newEntry(0);
@@ -675,6 +748,9 @@ void MainWindow::on_actionNew_Project_triggered()
     levels->setDefaultMapping();
     file_loaded = false;
     this->setWindowTitle("Untitled - LayOut");
+
+    for (int i = 0; i < LevelChanges::ASPECTS; i++)
+        newProjectGen[i] = levels->getChanges()->getGeneration(i);
 }
 
 // Open Project
@@ -687,31 +763,66 @@ void MainWindow::on_actionOpen_Project_triggered()
 
     if (!filename.isEmpty())
     {
-        toggleControls(false);
-
-        levels->init();
-        heightSections.clear();
         projectPath = filename;
-        xml->loadProject(filename);
-        levels->selectFirstLevel();
+        loadProject(filename);
+        file_loaded = true;
+        this->setWindowTitle(QFileInfo(filename).fileName() + " - LayOut");
+    }
+}
 
-        // Update HeightMap
-        heightSection->generate();
-        heightSection->setSection(0);
+// Load a project file, optionally replaying the edit journal over it
+void MainWindow::loadProject(QString filename, bool recover)
+{
+    toggleControls(false);
 
-        ui->RenderS16Widget->init();
-        ui->RenderS16Widget->setupRoadPalettes();
-        roadPaletteWidget->refresh();
+    levels->init();
+    heightSections.clear();
+    xml->loadProject(filename);
+    if (recover)
+        journal->replay();
+    levels->selectFirstLevel();
 
-        ui->roadPathWidget->init();
-        ui->roadPathWidget->setView(ui->editModeTabs->currentIndex()); // also enables insert button correctly
-        ui->roadPathWidget->update();
+    // Update HeightMap
+    heightSection->generate();
+    heightSection->setSection(0);
 
-        spriteSection->itemSelected(0, false);
-        file_loaded = true;
-        this->setWindowTitle(QFileInfo(filename).fileName() + " - LayOut");
+    ui->RenderS16Widget->init();
+    ui->RenderS16Widget->setupRoadPalettes();
+    roadPaletteWidget->refresh(levels->getActiveLevelP());
+
+    ui->roadPathWidget->init();
+    ui->roadPathWidget->setView(ui->editModeTabs->currentIndex()); // also enables insert button correctly
+    ui->roadPathWidget->update();
+
+    spriteSection->itemSelected(0, false);
+}
 
+// Offer to recover the project from a session that did not exit cleanly, then start
+// journalling edits. Requires the ROMs, so waits until they have been loaded.
+// Files that aren't offered are left for the next session.
+void MainWindow::recoverProject(bool offer)
+{
+    if (journal->isActive() || !importOutRun->romsLoaded)
+        return;
+
+    if (offer && journal->hasRecovery())
+    {
+        QMessageBox::StandardButton button =
+            QMessageBox::question(this, "Recover Project",
+                                  "LayOut did not exit cleanly last time.\n\nRecover the unsaved project?",
+                                  QMessageBox::Yes | QMessageBox::No);
+
+        if (button == QMessageBox::Yes)
+        {
+            loadProject(journal->getSnapshotFilename(), true);
+            file_loaded = false;
+            this->setWindowTitle("Recovered - LayOut");
+        }
+
+        journal->discardRecovery();
     }
+
+    journal->start();
 }
 
 // Save Project
@@ -720,7 +831,7 @@ void MainWindow::on_actionSave_Project_triggered()
     if (!file_loaded || projectPath.isEmpty())
         on_actionSave_Project_As_triggered();
     else
-        xml->saveProject(projectPath);
+        startSave(projectPath);
 }
 
 // Save Project As...
@@ -735,7 +846,7 @@ void MainWindow::on_actionSave_Project_As_triggered()
     {
         file_loaded = true;
         projectPath = filename;
-        xml->saveProject(filename);
+        startSave(filename);
         this->setWindowTitle(QFileInfo(filename).fileName() + " - LayOut");
     }
 }
@@ -751,7 +862,7 @@ void MainWindow::on_actionCannonball_triggered()
     if (!filename.isEmpty())
     {
         exportPath = filename;
-        exportCannon->write(filename, levels, heightSections, spriteSections);
+        startExport(filename, false);
     }
 }
 
@@ -827,6 +938,54 @@ void MainWindow::on_actionOutRun_Split_triggered()
     levels->setLevel(Levels::SPLIT);
 }
 
+// Import every level, end section and the split, mapped as per the arcade
+void MainWindow::on_actionOutRun_Complete_Game_triggered()
+{
+    toggleControls(false);
+
+    spriteSection->blockSignals(true);
+    ui->roadPathWidget->blockSignals(true);
+
+    // Shared tables are only read once
+    on_load_outrun_heightmap_triggered();
+    spriteSections = importOutRun->loadSpriteSections();
+    spriteSection->generateEntries();
+    importOutRun->loadSharedPalette(roadPalette);
+
+    // Create a level for each entry in the ROM. The split is created by init().
+    levels->init();
+    const QList<QString> names = importOutRun->getLevelNames();
+
+    for (int id = 0; id < ImportOutRun::ROM_LEVELS; id++)
+    {
+        if (id < ImportOutRun::NORMAL_LEVELS)
+            levels->newLevel(names.at(id));
+        else
+            levels->newEndSection(names.at(id));
+    }
+
+    importOutRun->loadGame(levels->getLevels()->mid(0, ImportOutRun::ROM_LEVELS), levels->getSplit());
+
+    // Levels are created in ROM order, so map each slot to the stage it plays in the game
+    levels->setDefaultMapping();
+    for (int slot = 0; slot < Levels::MAP_SLOTS; slot++)
+        levels->setMappedLevel(slot, SLOT_STAGES[slot]);
+
+    levels->getChanges()->notifyHeightPattern();
+    levels->getChanges()->notifySceneryPattern();
+    levels->getChanges()->notifyPalette();
+
+    spriteSection->blockSignals(false);
+    ui->roadPathWidget->blockSignals(false);
+
+    ui->RenderS16Widget->setupRoadPalettes();
+    levels->selectFirstLevel();
+    spriteSection->itemSelected(0, false);
+
+    file_loaded = false;
+    this->setWindowTitle("Untitled - LayOut");
+}
+
 void MainWindow::importLevel(int id)
 {
     toggleControls(false);
@@ -847,13 +1006,14 @@ void MainWindow::importLevel(int id)
 
     heightSections.clear();
     on_load_outrun_heightmap_triggered();
-    importOutRun->loadLevel(id);
-    levelData->updatePathData();
+    importOutRun->loadLevel(levels->getActiveLevelP(), id);
+    levels->getActiveLevelP()->updatePathData();
+    levels->getChanges()->notifyLevel();
     spriteSections = importOutRun->loadSpriteSections();
     spriteSection->generateEntries();
     ui->RenderS16Widget->init();
     ui->RenderS16Widget->setupRoadPalettes();
-    roadPaletteWidget->refresh();
+    roadPaletteWidget->refresh(levels->getActiveLevelP());
 
     spriteSection->blockSignals(false);
     ui->roadPathWidget->blockSignals(false);
@@ -882,10 +1042,11 @@ void MainWindow::on_actionOutRun_Scenery_Patterns_triggered()
 // Import Road Palette
 void MainWindow::on_actionOutRun_Road_Palettes_triggered()
 {
-    importOutRun->loadSharedPalette();
+    importOutRun->loadSharedPalette(roadPalette);
+    levels->getChanges()->notifyPalette();
     ui->RenderS16Widget->setupRoadPalettes();
     ui->RenderS16Widget->redrawPos();
-    roadPaletteWidget->refresh();
+    roadPaletteWidget->refresh(levels->getActiveLevelP());
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -911,17 +1072,7 @@ void MainWindow::on_actionCannonBall_Run_triggered()
         }
 
         if (!exportRunPath.isEmpty())
-        {
-            exportCannon->write(exportRunPath, levels, heightSections, spriteSections);
-            externalProcess = new QProcess(this);
-            QString program = settingsDialog->cannonballPath;
-            QStringList arguments;
-            arguments << "-file" << exportRunPath;
-            // Forward output of program to the main output
-            //externalProcess->setProcessChannelMode(QProcess::ForwardedChannels);
-            externalProcess->setWorkingDirectory(QFileInfo(settingsDialog->cannonballPath).absolutePath());
-            externalProcess->start(program, arguments);
-        }
+            startExport(exportRunPath, true);
     }
     else
     {
@@ -929,6 +1080,170 @@ void MainWindow::on_actionCannonBall_Run_triggered()
     }
 }
 
+// Launch CannonBall once the export has been written
+void MainWindow::launchCannonBall()
+{
+    externalProcess = new QProcess(this);
+    QString program = settingsDialog->cannonballPath;
+    QStringList arguments;
+    arguments << "-file" << exportRunPath;
+    // Forward output of program to the main output
+    //externalProcess->setProcessChannelMode(QProcess::ForwardedChannels);
+    externalProcess->setWorkingDirectory(QFileInfo(settingsDialog->cannonballPath).absolutePath());
+    externalProcess->start(program, arguments);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Background Export
+// ------------------------------------------------------------------------------------------------
+
+// The project is copied before returning. It can be edited whilst the file is written.
+// Write the project on a worker, so large projects don't stall the editor
+void MainWindow::startSave(const QString& filename)
+{
+    if (saveTask != NULL && saveTask->isRunning())
+        saveTask->wait(); // Saves complete in order
+
+    delete saveTask;
+    saveTask = new SaveTask(this, filename, levels, heightSection, spriteSection);
+    connect(saveTask, SIGNAL(finished(bool)), this, SLOT(saveFinished(bool)));
+    ui->statusBar->showMessage("Saving " + QFileInfo(filename).fileName() + "...");
+    saveTask->start();
+}
+
+void MainWindow::saveFinished(bool success)
+{
+    if (success)
+        ui->statusBar->showMessage("Saved " + QFileInfo(saveTask->getFilename()).fileName(), 2000);
+    else
+    {
+        ui->statusBar->clearMessage();
+        QMessageBox::warning(this, "Save Error", saveTask->getError());
+    }
+}
+
+void MainWindow::startExport(const QString& filename, bool launch)
+{
+    if (exportTask != NULL && exportTask->isRunning())
+    {
+        QMessageBox::warning(this, "Export Error", "An export is already in progress!");
+        return;
+    }
+
+    delete exportTask;
+    exportTask = new ExportTask(this, new ExportCannonball(), filename, levels, heightSection, spriteSection);
+    launchAfterExport = launch;
+
+    if (exportDialog == NULL)
+    {
+        exportDialog = new QProgressDialog("Exporting track data...", "Cancel", 0, 100, this);
+        exportDialog->setWindowModality(Qt::NonModal);
+        exportDialog->setMinimumDuration(500); // Only shown for slow exports
+        exportDialog->setAutoClose(false);
+        exportDialog->setAutoReset(false);
+    }
+    exportDialog->reset();
+
+    connect(exportTask,   SIGNAL(progress(int, int)), this,       SLOT(exportProgress(int, int)));
+    connect(exportTask,   SIGNAL(finished(bool)),     this,       SLOT(exportFinished(bool)));
+    connect(exportDialog, SIGNAL(canceled()),         exportTask, SLOT(cancel()));
+
+    exportTask->start();
+}
+
+void MainWindow::exportProgress(int done, int total)
+{
+    if (exportDialog != NULL && !exportDialog->wasCanceled())
+    {
+        exportDialog->setMaximum(total);
+        exportDialog->setValue(done);
+    }
+}
+
+void MainWindow::exportFinished(bool success)
+{
+    const bool canceled = exportDialog->wasCanceled();
+    exportDialog->reset();
+    exportDialog->hide();
+
+    if (success)
+    {
+        if (launchAfterExport)
+            launchCannonBall();
+    }
+    else if (!canceled)
+    {
+        QMessageBox::warning(this, "Export Error", exportTask->getError());
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Overdraw Profiling
+// ------------------------------------------------------------------------------------------------
+
+// Compose the level at every position on a worker, counting the pixels written by the hardware
+void MainWindow::on_actionProfile_Overdraw_triggered()
+{
+    OverdrawProfiler* profiler = ui->RenderS16Widget->getOverdrawProfiler();
+
+    if (profileDialog == NULL)
+    {
+        profileDialog = new QProgressDialog("Profiling overdraw...", "Cancel", 0, 100, this);
+        profileDialog->setWindowModality(Qt::NonModal);
+        profileDialog->setMinimumDuration(500); // Only shown for long levels
+        profileDialog->setAutoClose(false);
+        profileDialog->setAutoReset(false);
+        connect(profileDialog, SIGNAL(canceled()), profiler, SLOT(cancel()));
+    }
+    profileDialog->reset();
+
+    ui->RenderS16Widget->profileOverdraw();
+}
+
+void MainWindow::overdrawProgress(int done, int total)
+{
+    if (profileDialog != NULL && !profileDialog->wasCanceled())
+    {
+        profileDialog->setMaximum(total);
+        profileDialog->setValue(done);
+    }
+}
+
+// Report the worst positions, and move to the very worst
+void MainWindow::overdrawProfiled()
+{
+    const static int WORST_POSITIONS = 10;
+
+    if (profileDialog != NULL)
+    {
+        profileDialog->reset();
+        profileDialog->hide();
+    }
+
+    OverdrawProfiler* profiler = ui->RenderS16Widget->getOverdrawProfiler();
+    const QVector<OverdrawReport>& reports = profiler->getReports();
+    QVector<int> worst = profiler->worstPositions(WORST_POSITIONS);
+
+    if (worst.isEmpty())
+        return;
+
+    QString text = "Positions where the most pixels are written:\n";
+
+    foreach (int pos, worst)
+    {
+        const OverdrawReport& report = reports.at(pos);
+        text += QString("\nPosition %1: %2 pixels (%3x screen), worst scanline %4 (%5 pixels)")
+                    .arg(pos)
+                    .arg(report.pixels)
+                    .arg((double) report.pixels / (S16_WIDTH * S16_HEIGHT), 0, 'f', 2)
+                    .arg(report.worstLine)
+                    .arg(report.worstLinePixels);
+    }
+
+    ui->spinPosition->setValue(worst.first());
+    QMessageBox::information(this, "Overdraw Profile", text);
+}
+
 void MainWindow::stopExternalProcess()
 {
     if (externalProcess != NULL)
@@ -939,61 +1254,171 @@ void MainWindow::stopExternalProcess()
     }
 }
 
+// Load the ROMs in the background. Projects can be opened and edited straight away, and the
+// parts of the editor that need the ROMs come online as each stage finishes.
 void MainWindow::initRomData()
 {
-    bool success = false;
+    delete romTask; // Cancels any load in progress
+    romTask = NULL;
 
-    if (!settingsDialog->romPath.isNull() && !settingsDialog->romPath.isEmpty())
+    if (settingsDialog->romPath.isNull() || settingsDialog->romPath.isEmpty())
     {
-        QDir romPath = settingsDialog->romPath;
+        unloadRoms();
+        ui->statusBar->showMessage("WARNING: You must setup a rom path!");
+        settingsDialog->show();
+        return;
+    }
 
-        if (romPath.isReadable())
-        {
-            if (importOutRun->loadRevBRoms(settingsDialog->romPath))
-            {
-                QRgb* spritePalette = Utils::convertEntirePaletteToQT(importOutRun->getPaletteData());
-                Sprite::convertSpriteRom(importOutRun->sprites.rom, importOutRun->sprites.length, spritePalette);
-                ui->RenderS16Widget->setData(levels, &heightSections, &spriteSections,
-                                             &importOutRun->rom0, &importOutRun->sprites, &importOutRun->rom1, &importOutRun->road);
-                ui->RenderS16Widget->setRoadPos(0);
-                ui->previewPaletteWidget->setPaletteData(spritePalette, 8, 2);
-                spriteList->setList(importOutRun->loadSpriteList());
-                spriteList->toggleHiddenSprites(ui->checkHideSprites->isChecked());
-                ui->RenderS16Widget->init();
-                ui->RenderS16Widget->setRoadPos(0);
-                on_actionNew_Project_triggered();
-                ui->statusBar->showMessage("ROMs Successfully loaded");
-                success = true;
-            }
-        }
+    toggleRomControls(false);
+    toggleProjectControls(true);
 
-        if (!success)
-        {
-            QMessageBox::warning(this, "ROM Load Failure", "Unable to load required ROM files.");
-            ui->statusBar->showMessage("ERROR: Rom Load Failure");
-        }
+    romTask = new RomTask(this, settingsDialog->romPath);
+    connect(romTask, SIGNAL(stageFinished(int)), this, SLOT(romStageFinished(int)));
+    connect(romTask, SIGNAL(finished(bool)),     this, SLOT(romsFinished(bool)));
+
+    romProgress->setRange(0, RomTask::STAGES);
+    romProgress->setValue(0);
+    romProgress->show();
+    ui->statusBar->showMessage(RomTask::getStageName(RomTask::LOAD_ROMS) + "...");
+    romTask->start();
+}
+
+void MainWindow::romStageFinished(int stage)
+{
+    romProgress->setValue(stage + 1);
+    if (stage + 1 < RomTask::STAGES)
+        ui->statusBar->showMessage(RomTask::getStageName(stage + 1) + "...");
+
+    switch (stage)
+    {
+        // Editor can use the ROMs
+        case RomTask::DECODE_SPRITES:
+            useRoms();
+            break;
+
+        // Preview can use the ROMs
+        case RomTask::BUILD_PREVIEW:
+            ui->RenderS16Widget->setData(levels, &heightSections, &spriteSections, romTask->takeRenderers());
+            ui->RenderS16Widget->setRoadPos(0);
+            ui->actionProfile_Overdraw->setEnabled(true);
+            break;
+    }
+}
+
+void MainWindow::romsFinished(bool success)
+{
+    romProgress->hide();
+
+    if (success)
+    {
+        ui->statusBar->showMessage("ROMs Successfully loaded");
     }
     else
     {
-        success = false;
-        ui->statusBar->showMessage("WARNING: You must setup a rom path!");
-        settingsDialog->show();
+        unloadRoms();
+        QMessageBox::warning(this, "ROM Load Failure", "Unable to load required ROM files.");
+        ui->statusBar->showMessage("ERROR: Rom Load Failure");
+    }
+}
+
+// Switch the editor to the newly loaded ROMs
+void MainWindow::useRoms()
+{
+    // Release the ROMs used by the preview before they are replaced.
+    // Nothing may be drawing sprites when the sprite data changes.
+    ui->RenderS16Widget->setData(levels, &heightSections, &spriteSections, PreviewRenderers());
+    thumbnails->clear();
+
+    delete importOutRun;
+    importOutRun = romTask->takeRoms();
+
+    QRgb* spritePalette = romTask->takeSpritePalette();
+    Sprite::setSpriteData(romTask->takeSpriteData(), spritePalette);
+    ui->previewPaletteWidget->setPaletteData(spritePalette, 8, 2);
+    spriteList->setList(importOutRun->loadSpriteList());
+    spriteList->toggleHiddenSprites(ui->checkHideSprites->isChecked());
+
+    // A project opened or edited whilst the ROMs loaded is kept.
+    // Only an untouched new project is replaced with the default project from the ROMs.
+    const bool untouched = !file_loaded && !isNewProjectEdited();
+
+    if (untouched)
+        on_actionNew_Project_triggered();
+    else
+        loadRomDefaults();
+
+    toggleRomControls(true);
+
+    // Recovery would replace the project the user is already working on
+    recoverProject(untouched);
+}
+
+// Whether the project has been edited since it was created with New Project
+bool MainWindow::isNewProjectEdited() const
+{
+    for (int i = 0; i < LevelChanges::ASPECTS; i++)
+    {
+        if (i != LevelChanges::SCENERY_SELECTION && levels->getChanges()->getGeneration(i) != newProjectGen[i])
+            return true;
     }
+    return false;
+}
 
-    if (!success)
+// Fill in the parts of the project that come from the ROMs, where they are still empty.
+// Anything the user has already created is left alone.
+void MainWindow::loadRomDefaults()
+{
+    if (!file_loaded)
     {
-        importOutRun->unloadRoms();
+        if (spriteSections.isEmpty())
+            spriteSections = importOutRun->loadSpriteSections(60); // Import checkpoint
+
+        LevelData* split = levels->getSplit();
+        if (split->points->isEmpty())
+        {
+            importOutRun->loadSplit(split, false);
+            split->updatePathData();
+        }
+
+        LevelData* end = levels->getEndSection();
+        if (end->type == Levels::END && end->points->isEmpty())
+            importOutRun->loadEndSection(end, false);
+
+        levels->getChanges()->notifyLevel();
+        levels->getChanges()->notifyProject();
     }
 
-    ui->tabMain->setEnabled(success);
-    ui->menuImport->setEnabled(success);
-    ui->menuExport->setEnabled(success);
-    ui->actionNew_Project->setEnabled(success);
-    ui->actionOpen_Project->setEnabled(success);
-    ui->actionSave_Project->setEnabled(success);
-    ui->actionSave_Project_As->setEnabled(success);
-    ui->actionCannonball->setEnabled(success);
-    ui->actionCannonBall_Run->setEnabled(success);
+    // Sprite names are only known once the ROMs have loaded
+    spriteSection->generateEntries();
+}
+
+void MainWindow::unloadRoms()
+{
+    ui->RenderS16Widget->setData(levels, &heightSections, &spriteSections, PreviewRenderers());
+    importOutRun->unloadRoms();
+    toggleRomControls(false);
+    toggleProjectControls(false);
+}
+
+// Controls that need the ROMs. Overdraw profiling also waits for the preview.
+void MainWindow::toggleRomControls(bool enabled)
+{
+    ui->menuImport->setEnabled(enabled);
+    ui->menuExport->setEnabled(enabled);
+    ui->actionCannonball->setEnabled(enabled);
+    ui->actionCannonBall_Run->setEnabled(enabled);
+    if (!enabled)
+        ui->actionProfile_Overdraw->setEnabled(false);
+}
+
+// Controls that can be used whilst the ROMs load
+void MainWindow::toggleProjectControls(bool enabled)
+{
+    ui->tabMain->setEnabled(enabled);
+    ui->actionNew_Project->setEnabled(enabled);
+    ui->actionOpen_Project->setEnabled(enabled);
+    ui->actionSave_Project->setEnabled(enabled);
+    ui->actionSave_Project_As->setEnabled(enabled);
 }
 
 // ------------------------------------------------------------------------------------------------
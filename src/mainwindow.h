@@ -12,6 +12,7 @@
 #include <QMainWindow>
 
 #include "leveldata.hpp"
+#include "levelchanges.hpp"
 
 namespace Ui {
 class MainWindow;
@@ -26,13 +27,20 @@ class ImportDialog;
 class SettingsDialog;
 class About;
 class GenerateXML;
-class ExportCannonball;
+class ExportTask;
+class SaveTask;
+class RomTask;
+class Journal;
+class QProgressDialog;
+class QProgressBar;
+class QLabel;
 class ImportOutRun;
 class HeightModel;
 class HeightSection;
 class LevelPaletteWidget;
 class SpriteList;
 class SpriteSection;
+class ThumbnailCache;
 struct SpriteEntry;
 struct SpriteSectionEntry;
 struct HeightEntry;
@@ -93,6 +101,8 @@ private slots:
     void importLevel(int);
     void initLevel();
     void initRomData();
+    void romStageFinished(int stage);
+    void romsFinished(bool success);
 
     void on_actionAbout_LayOut_triggered();
 
@@ -102,8 +112,19 @@ private slots:
 
     void on_actionOutRun_Split_triggered();
 
+    void on_actionOutRun_Complete_Game_triggered();
+
     void on_actionExport_Sprite_Palette_triggered();
 
+    void exportProgress(int done, int total);
+    void exportFinished(bool success);
+    void saveFinished(bool success);
+    void recoverProject(bool offer);
+
+    void on_actionProfile_Overdraw_triggered();
+    void overdrawProgress(int done, int total);
+    void overdrawProfiled();
+
 protected:
     void closeEvent(QCloseEvent* event);
 
@@ -120,7 +141,25 @@ private:
     SettingsDialog* settingsDialog;
     About* aboutDialog;
 
-    ExportCannonball *exportCannon;
+    // Export in progress
+    ExportTask* exportTask;
+    QProgressDialog* exportDialog;
+    bool launchAfterExport;
+
+    // Save in progress
+    SaveTask* saveTask;
+
+    // ROMs loading in the background
+    RomTask* romTask;
+    QProgressBar* romProgress;
+    QLabel* previewStats;      // Render time and frame cache counters of the preview
+
+    // Crash recovery for the project being edited
+    Journal* journal;
+
+    // Overdraw profile in progress
+    QProgressDialog* profileDialog;
+
     ImportOutRun* importOutRun;
 
     HeightSection* heightSection;
@@ -136,10 +175,26 @@ private:
     SpriteList* spriteList;
     SpriteSection* spriteSection;
 
+    // Thumbnails shown in the level and pattern lists
+    ThumbnailCache* thumbnails;
+
     bool file_loaded;
 
+    // Change generations when the last new project was created, to find whether it has been edited
+    uint32_t newProjectGen[LevelChanges::ASPECTS];
+
     QProcess* externalProcess;
 
+    void loadProject(QString filename, bool recover = false);
+    void useRoms();
+    bool isNewProjectEdited() const;
+    void loadRomDefaults();
+    void unloadRoms();
+    void toggleRomControls(bool enabled);
+    void toggleProjectControls(bool enabled);
+    void startSave(const QString& filename);
+    void startExport(const QString& filename, bool launch);
+    void launchCannonBall();
     void stopExternalProcess();
     void loadSettings();
     void saveSettings();
@@ -109,6 +109,8 @@ HWRoad::HWRoad()
 {
     s16_width  = S16_WIDTH;
     s16_height = S16_HEIGHT;
+    ram        = ramHalves[0];
+    ramBuff    = ramHalves[1];
 }
 
 HWRoad::~HWRoad()
@@ -199,16 +201,10 @@ void HWRoad::write32(uint32_t* adr, const uint32_t data)
 
 uint16_t HWRoad::read_road_control()
 {
-    uint32_t *src = (uint32_t *)ram;
-    uint32_t *dst = (uint32_t *)ramBuff;
-
     // swap the halves of the road RAM
-    for (uint16_t i = 0; i < ROAD_RAM_SIZE/4; i++)
-    {
-        uint32_t temp = *src;
-        *src++ = *dst;
-        *dst++ = temp;
-    }
+    uint16_t* temp = ram;
+    ram     = ramBuff;
+    ramBuff = temp;
 
     return 0xffff;
 }
@@ -218,13 +214,25 @@ void HWRoad::write_road_control(const uint8_t road_control)
     this->road_control = road_control;
 }
 
+// Add a write to every pixel of a scanline, when profiling overdraw
+void HWRoad::count_writes(uint8_t* writes)
+{
+    for (int x = 0; x < s16_width; x++)
+    {
+        if (writes[x] != 0xFF)
+            writes[x]++;
+    }
+}
+
 // Background: Look for solid fill scanlines
-void HWRoad::render_background(uint32_t* pixels)
+// Only the scanlines from yStart up to yEnd are rendered, so bands can be rendered concurrently.
+// If writes is set, the pixels written are counted for profiling overdraw.
+void HWRoad::render_background(uint16_t* pixels, const int yStart, const int yEnd, uint8_t* writes)
 {
     int x, y;
     uint16_t* roadram = ramBuff;
 
-    for (y = 0; y < S16_HEIGHT; y++)
+    for (y = yStart; y < yEnd; y++)
     {
         int data0 = roadram[0x000 + y];
         int data1 = roadram[0x100 + y];
@@ -262,22 +270,25 @@ void HWRoad::render_background(uint32_t* pixels)
         // fill the scanline with color
         if (color != -1)
         {
-            uint32_t* pPixel = pixels + (y * s16_width);
+            uint16_t* pPixel = pixels + (y * s16_width);
             color |= color_offset3;
 
             for (x = 0; x < s16_width; x++)
                 *(pPixel)++ = color;
+
+            if (writes != NULL)
+                count_writes(writes + (y * s16_width));
         }
     }
 }
 
 // Foreground: Render From ROM
-void HWRoad::render_foreground(uint32_t* pixels)
+void HWRoad::render_foreground(uint16_t* pixels, const int yStart, const int yEnd, uint8_t* writes)
 {
     int x, y;
     uint16_t* roadram = ramBuff;
 
-    for (y = 0; y < S16_HEIGHT; y++)
+    for (y = yStart; y < yEnd; y++)
     {
         uint16_t color_table[32];
 
@@ -294,7 +305,7 @@ void HWRoad::render_foreground(uint32_t* pixels)
         if (((data0 & 0x800) != 0) && ((data1 & 0x800) != 0))
             continue;
 
-        uint32_t* pPixel = pixels + (y * s16_width);
+        uint16_t* pPixel = pixels + (y * s16_width);
         int32_t hpos0, hpos1, color0, color1;
         int32_t control = road_control & 3;
 
@@ -392,5 +403,9 @@ void HWRoad::render_foreground(uint32_t* pixels)
                 break;
             } // end switch
 
+        // Scanlines skipped above are not written
+        if (writes != NULL)
+            count_writes(writes + (y * s16_width));
+
     } // end for
 }
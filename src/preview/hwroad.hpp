@@ -18,14 +18,18 @@ public:
     ~HWRoad();
 
     void init(const uint8_t*);
-    void render_background(uint32_t*);
-    void render_foreground(uint32_t*);
+    void render_background(uint16_t*, const int yStart = 0, const int yEnd = S16_HEIGHT, uint8_t* writes = NULL);
+    void render_foreground(uint16_t*, const int yStart = 0, const int yEnd = S16_HEIGHT, uint8_t* writes = NULL);
     void write16(uint32_t adr, const uint16_t data);
     void write16(uint32_t* adr, const uint16_t data);
     void write32(uint32_t* adr, const uint32_t data);
     uint16_t read_road_control();
     void write_road_control(const uint8_t);
 
+    // Road RAM being written to at the specified address, for writing contiguous blocks.
+    // Blocks must not run past the end of road RAM.
+    inline uint16_t* write_ptr(uint32_t adr) { return &ram[(adr >> 1) & 0x7FF]; }
+
 private:
     // Internal screen width and height
     uint16_t s16_width, s16_height;
@@ -43,10 +47,12 @@ private:
     uint8_t roads[0x40200];
 
     // Two halves of RAM
-    uint16_t ram[ROAD_RAM_SIZE / 2];
-    uint16_t ramBuff[ROAD_RAM_SIZE / 2];
+    uint16_t ramHalves[2][ROAD_RAM_SIZE / 2];
+    uint16_t* ram;     // Written to
+    uint16_t* ramBuff; // Rendered from
 
     void decode_road(const uint8_t*);
+    void count_writes(uint8_t* writes);
 };
 
 extern HWRoad hwroad;
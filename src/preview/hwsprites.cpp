@@ -8,7 +8,6 @@
 
 #include <stdlib.h>       // abs
 #include "../globals.hpp"
-#include "renders16.hpp"
 #include "osprite.hpp"
 #include "hwsprites.hpp"
 
@@ -49,9 +48,8 @@
 *
  *******************************************************************************************/
 
-HWSprites::HWSprites(RenderS16* parent)
+HWSprites::HWSprites()
 {
-    this->parent = parent;
     x1 = 0;
     x2 = S16_WIDTH;
 }
@@ -79,7 +77,26 @@ void HWSprites::init(const uint8_t* src_sprites)
     }
 }
 
-void HWSprites::render(const uint8_t priority, osprite* sprite_entries, uint16_t sprite_count)
+// Render sprites of the specified priority to the scanlines from yStart up to yEnd.
+//
+// The sprite entries are not modified, so separate bands of the same frame can be
+// rendered concurrently. The widest line drawn of each sprite is returned in widths.
+//
+// Optionally, the pixel writes can be counted for profiling overdraw. Each write is added
+// to the screen pixel in writes, and to the total of its sprite in areas.
+void HWSprites::render(const uint8_t priority, osprite* sprite_entries, uint16_t sprite_count, uint16_t* buffer,
+                       const int yStart, const int yEnd, int* widths, uint8_t* writes, int* areas)
+{
+    if (writes != NULL && areas != NULL)
+        render_sprites<true>(priority, sprite_entries, sprite_count, buffer, yStart, yEnd, widths, writes, areas);
+    else
+        render_sprites<false>(priority, sprite_entries, sprite_count, buffer, yStart, yEnd, widths, NULL, NULL);
+}
+
+// Counting is resolved at compile time, so the preview itself pays nothing for it
+template <bool COUNT>
+void HWSprites::render_sprites(const uint8_t priority, osprite* sprite_entries, uint16_t sprite_count, uint16_t* buffer,
+                               const int yStart, const int yEnd, int* widths, uint8_t* writes, int* areas)
 {
     const uint32_t numbanks = SPRITES_LENGTH / 0x10000;
 
@@ -107,9 +124,11 @@ void HWSprites::render(const uint8_t priority, osprite* sprite_entries, uint16_t
         int32_t hzoom   = data[4] & 0x7ff;
         int32_t color   = (data[5] & 0x7f) << 4;
         int32_t x, y, ytarget, yacc = 0, pix;
+        int width = 0;
+        int area  = 0;
 
-        // initialize the end address to the start address
-        data[7] = addr;
+        // end address (data[7] on the original hardware)
+        uint16_t end = addr;
 
         // clamp to within the memory region size
         if (numbanks != 0)
@@ -127,42 +146,41 @@ void HWSprites::render(const uint8_t priority, osprite* sprite_entries, uint16_t
         // Adjust for widescreen mode
         xpos += S16_X_OFF;
 
-        spr->width = 0;
-
         for (y = top; y != ytarget; y += ydelta)
         {
-            // skip drawing if not within the cliprect
-            if (y >= 0 && y < S16_HEIGHT)
+            // skip drawing if not within the cliprect, or another band
+            if (y >= yStart && y < yEnd)
             {
-                uint32_t* pPixel = &parent->pixels[y * S16_WIDTH];
+                uint16_t* pPixel  = &buffer[y * S16_WIDTH];
+                uint8_t*  pWrites = COUNT ? &writes[y * S16_WIDTH] : NULL;
                 int32_t xacc = 0;
 
                 // non-flipped case
                 if (flip == 0)
                 {
                     // start at the word before because we preincrement below
-                    data[7] = (addr - 1);
+                    end = (addr - 1);
 
                     int line_width = 0;
 
                     for (x = xpos; (xdelta > 0 && x < S16_WIDTH) || (xdelta < 0 && x >= 0); )
                     {
-                        uint32_t pixels = sprites[spritedata + ++data[7]]; // Add to base sprite data the vzoom value
+                        uint32_t pixels = sprites[spritedata + ++end]; // Add to base sprite data the vzoom value
 
                         // draw four pixels
-                        pix = (pixels >> 28) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >> 24) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >> 20) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >> 16) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >> 12) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >>  8) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >>  4) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >>  0) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >> 28) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >> 24) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >> 20) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >> 16) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >> 12) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >>  8) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >>  4) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >>  0) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
 
                         line_width = std::abs(xpos - x);
 
-                        if (line_width > spr->width)
-                            spr->width = line_width;
+                        if (line_width > width)
+                            width = line_width;
 
                         // stop if the second-to-last pixel in the group was 0xf
                         if ((pixels & 0x000000f0) == 0x000000f0)
@@ -173,28 +191,28 @@ void HWSprites::render(const uint8_t priority, osprite* sprite_entries, uint16_t
                 else
                 {
                     // start at the word after because we predecrement below
-                    data[7] = (addr + 1);
+                    end = (addr + 1);
 
                     int line_width = 0;
 
                     for (x = xpos; (xdelta > 0 && x < S16_WIDTH) || (xdelta < 0 && x >= 0); )
                     {
-                        uint32_t pixels = sprites[spritedata + --data[7]];
+                        uint32_t pixels = sprites[spritedata + --end];
 
                         // draw four pixels
-                        pix = (pixels >>  0) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >>  4) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >>  8) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >> 12) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >> 16) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >> 20) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >> 24) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
-                        pix = (pixels >> 28) & 0xf; while (xacc < 0x200) { draw_pixel(x, pix, color, shadow, pPixel+x); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >>  0) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >>  4) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >>  8) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >> 12) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >> 16) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >> 20) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >> 24) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
+                        pix = (pixels >> 28) & 0xf; while (xacc < 0x200) { draw_pixel<COUNT>(x, pix, color, shadow, pPixel, pWrites, area); x += xdelta; xacc += hzoom; } xacc -= 0x200;
 
                         line_width = std::abs(xpos - x);
 
-                        if (line_width > spr->width)
-                            spr->width = line_width;
+                        if (line_width > width)
+                            width = line_width;
 
                         // stop if the second-to-last pixel in the group was 0xf
                         if ((pixels & 0x0f000000) == 0x0f000000)
@@ -207,13 +225,22 @@ void HWSprites::render(const uint8_t priority, osprite* sprite_entries, uint16_t
             addr += pitch * (yacc >> 9);
             yacc &= 0x1ff;
         }
+
+        widths[i] = width;
+
+        if (COUNT)
+            areas[i] += area;
     }
 }
 
-void HWSprites::draw_pixel(const int32_t x, const uint16_t pix, const uint16_t colour, const uint8_t shadow, uint32_t* pPixel)
+template <bool COUNT>
+void HWSprites::draw_pixel(const int32_t x, const uint16_t pix, const uint16_t colour, const uint8_t shadow,
+                           uint16_t* pLine, uint8_t* pWrites, int& area)
 {
     if (x >= x1 && x < x2 && pix != 0 && pix != 15)
     {
+        uint16_t* pPixel = pLine + x;
+
         if (shadow && pix == 0xa) 
         {
             *pPixel &= 0xfff;
@@ -223,5 +250,13 @@ void HWSprites::draw_pixel(const int32_t x, const uint16_t pix, const uint16_t c
         {
             *pPixel = (pix | colour | COLOR_BASE) & 0xfff;
         }
+
+        // Shadows are counted too, as they read and write the pixel beneath
+        if (COUNT)
+        {
+            if (pWrites[x] != 0xFF)
+                pWrites[x]++;
+            area++;
+        }
     }  
 }
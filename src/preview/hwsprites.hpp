@@ -10,20 +10,18 @@
 
 #include "../globals.hpp"
 
-class RenderS16;
 class osprite;
 
 class HWSprites
 {
 public:
-    HWSprites(RenderS16*);
+    HWSprites();
     ~HWSprites();
     void init(const uint8_t*);
-    void render(const uint8_t, osprite *sprite_entries, uint16_t sprite_count);
+    void render(const uint8_t, osprite *sprite_entries, uint16_t sprite_count, uint16_t* buffer,
+                const int yStart, const int yEnd, int* widths, uint8_t* writes = NULL, int* areas = NULL);
 
 private:
-    RenderS16* parent;
-
     // Clip values.
     uint16_t x1, x2;
 
@@ -32,11 +30,18 @@ private:
 
     uint32_t sprites[SPRITES_LENGTH]; // Converted sprites
 
+    template <bool COUNT>
+    void render_sprites(const uint8_t, osprite *sprite_entries, uint16_t sprite_count, uint16_t* buffer,
+                        const int yStart, const int yEnd, int* widths, uint8_t* writes, int* areas);
+
+    template <bool COUNT>
     inline void draw_pixel(
-        const int32_t x, 
-        const uint16_t pix, 
-        const uint16_t colour, 
-        const uint8_t shadow, 
-        uint32_t* pPixel);
+        const int32_t x,
+        const uint16_t pix,
+        const uint16_t colour,
+        const uint8_t shadow,
+        uint16_t* pLine,
+        uint8_t* pWrites,
+        int& area);
 };
 
@@ -28,6 +28,8 @@
 
 #include "../stdint.hpp"
 
+struct SpriteFrames;
+
 class oentry
 {
 public:
@@ -104,7 +106,8 @@ public:
 	uint16_t dst_index;
 
 	// +18 [Long] Address of actual sprite data we want to render. Offset 1/2 into ROM[0x20000]. 
-	uint32_t addr;
+	//            Held as the frames decoded from that address.
+	const SpriteFrames* frames;
 
 	// +1C [Word] Distance into screen or Sprite to Road Priority (High Number = Closer to camera)
 	uint16_t road_priority;
@@ -173,7 +176,7 @@ public:
 		width = 0;
 		priority = 0;
 		dst_index = 0;
-		addr = 0;
+		frames = NULL;
 		road_priority = 0;
 		reload = 0;
 		counter = 0;
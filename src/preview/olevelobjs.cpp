@@ -19,35 +19,14 @@
 #include "../sprites/spriteformat.hpp"
 #include "../import/romloader.hpp"
 #include "olevelobjs.hpp"
+#include "spriterom.hpp"
 
-// ------------------------------------------------------------------------------------------------
-// OutRun ROM Addresses
-// ------------------------------------------------------------------------------------------------
-
-const uint32_t MOVEMENT_LOOKUP_Z = 0x30900;
-
-// Table to alter sprite based on its y position. Input = Y Position.
-//
-// Format:
-// +0: Frame Number To Use
-// +2: Entry In Zoom Lookup Table
-const uint32_t MAP_Y_TO_FRAME = 0x30A00;
-
-// Sprites: Hard Coded Addresses.
-const uint32_t SPRITE_CLOUD_FRAMES    = 0x4246;
-const uint32_t SPRITE_MINITREE_FRAMES = 0x435C;
-const uint32_t SPRITE_GRASS_FRAMES    = 0x4548;
-const uint32_t SPRITE_SAND_FRAMES     = 0x4588;
-const uint32_t SPRITE_STONE_FRAMES    = 0x45C8;
-const uint32_t SPRITE_WATER_FRAMES    = 0x4608;
-
-// ------------------------------------------------------------------------------------------------
-
-OLevelObjs::OLevelObjs(OSprites* osprites, ORoad *oroad, RomLoader* rom)
+OLevelObjs::OLevelObjs(OSprites* osprites, ORoad *oroad, RomLoader* rom, const SpriteRom* spriteRom)
 {
-    this->osprites = osprites;
-    this->oroad    = oroad;
-    this->rom      = rom;
+    this->osprites  = osprites;
+    this->oroad     = oroad;
+    this->rom       = rom;
+    this->spriteRom = spriteRom;
 }
 
 OLevelObjs::~OLevelObjs(void)
@@ -67,7 +46,7 @@ void OLevelObjs::init_entries(uint32_t a4, const uint8_t start_index, const uint
         sprite->shadow     = rom->read8(&a4);
         sprite->pal_src    = rom->read8(&a4);
         sprite->type       = rom->read16(&a4);
-        sprite->addr       = rom->read32(SPRITELIST_ADR + sprite->type);
+        sprite->frames     = spriteRom->sprite(sprite->type);
         sprite->xw1        = 
         sprite->xw2        = rom->read16(&a4);
         sprite->yw         = rom->read16(&a4);
@@ -150,7 +129,7 @@ void OLevelObjs::setup_sprites(uint32_t z)
 // +7: [Byte] Sprite Palette
 void OLevelObjs::setup_sprite(oentry* sprite, uint32_t z)
 {
-    SpriteEntry entry = osprites->currentSection.sprites.at(osprites->seg_spr_offset1);
+    const SpriteEntry& entry = osprites->seg_sprites[osprites->seg_spr_offset1];
 
     sprite->control |= OSprites::ENABLE; // Turn sprite on
     // Set sprite x,y (world coordinates)
@@ -158,7 +137,7 @@ void OLevelObjs::setup_sprite(oentry* sprite, uint32_t z)
     sprite->xw2     = ((int8_t) entry.x << 4);
     sprite->yw      = entry.y << 7;
     sprite->type    = entry.type << 2;
-    sprite->addr    = rom->read32(SPRITELIST_ADR + sprite->type);
+    sprite->frames  = spriteRom->sprite(sprite->type);
     sprite->pal_src = entry.pal;
     osprites->map_palette(sprite);
 
@@ -320,7 +299,7 @@ void OLevelObjs::do_sprite_routine()
                 // Grass Sprite
                 case 1:
                     //sprite_grass(sprite);
-                    do_thickness_sprite(sprite, SPRITE_GRASS_FRAMES);
+                    do_thickness_sprite(sprite, SpriteRom::GRASS);
                     break;
 
                 // Sprite based clouds that span entire sky
@@ -331,7 +310,7 @@ void OLevelObjs::do_sprite_routine()
                 // Water on LHS of Stage 1
                 case 3:
                     //sprite_water(sprite);
-                    do_thickness_sprite(sprite, SPRITE_WATER_FRAMES);
+                    do_thickness_sprite(sprite, SpriteRom::WATER);
                     break;
 
                 // Start Lights & Base Pillar of Checkpoint Sign
@@ -373,12 +352,12 @@ void OLevelObjs::do_sprite_routine()
 
                 // Sand Strips
                 case 10:
-                    do_thickness_sprite(sprite, SPRITE_SAND_FRAMES);
+                    do_thickness_sprite(sprite, SpriteRom::SAND);
                     break;
 
                 // Stone Strips
                 case 11:
-                    do_thickness_sprite(sprite, SPRITE_STONE_FRAMES);
+                    do_thickness_sprite(sprite, SpriteRom::STONE);
                     break;
 
                 // Mini-Tree (Stage 5, Level ID: 0x24)
@@ -394,7 +373,7 @@ void OLevelObjs::do_sprite_routine()
 
                 // Sand (Again) - Used in end sequence #2
                 case 14:
-                    do_thickness_sprite(sprite, SPRITE_SAND_FRAMES);
+                    do_thickness_sprite(sprite, SpriteRom::SAND);
                     break;
             }
         }
@@ -562,21 +541,20 @@ void OLevelObjs::sprite_minitree(oentry* sprite)
     {
         // don't choose a custom frame
         sprite->zoom = (uint8_t) z; // Set Entry Number For Zoom Lookup Table
-        sprite->addr = rom->read32(SPRITE_MINITREE_FRAMES); // Set to first frame in table
+        sprite->frames = spriteRom->minitreeLarge; // Set to first frame in table
     }
     // Use Table to alter sprite based on its y position.
     //
     // Input = Y Position
     //
-    // Format:
-    // +0: Frame Number To Use
-    // +2: Entry In Zoom Lookup Table
+    // Output:
+    // Frame To Use
+    // Entry In Zoom Lookup Table
     else
     {
-        z <<= 1; // Note we can't use original z16, so don't try to optimize this
-        uint8_t offset = rom->read8(MAP_Y_TO_FRAME + z);
-        sprite->zoom = rom->read8(MAP_Y_TO_FRAME + z + 1);
-        sprite->addr = rom->read32(SPRITE_MINITREE_FRAMES + offset);
+        const SpriteZoomFrame& f = spriteRom->minitree(z);
+        sprite->zoom   = f.zoom;
+        sprite->frames = f.frames;
     }
     // order_sprites
     osprites->do_spr_order_shadows(sprite);
@@ -652,22 +630,21 @@ void OLevelObjs::sprite_clouds(oentry* sprite)
     {
         // 421c
         sprite->zoom = (uint8_t) z; // Set Entry Number For Zoom Lookup Table
-        sprite->addr = rom->read32(SPRITE_CLOUD_FRAMES);
+        sprite->frames = spriteRom->cloudLarge;
     }
     else
     {
         // 41f8
-        z <<= 1;
-        uint8_t lookup_z = rom->read8(MOVEMENT_LOOKUP_Z + z);
-        sprite->addr = rom->read32(SPRITE_CLOUD_FRAMES + lookup_z);
-        sprite->zoom = rom->read8(MOVEMENT_LOOKUP_Z + z + 1);
+        const SpriteZoomFrame& f = spriteRom->cloud(z);
+        sprite->frames = f.frames;
+        sprite->zoom   = f.zoom;
     }
     // end
     osprites->map_palette(sprite);
     osprites->do_spr_order_shadows(sprite);
 }
 
-void OLevelObjs::do_thickness_sprite(oentry* sprite, const uint32_t sprite_table_address)
+void OLevelObjs::do_thickness_sprite(oentry* sprite, const int frame_table)
 {
     osprites->move_sprite(sprite, 0);
     uint16_t z16 = sprite->z >> 16;
@@ -709,14 +686,14 @@ void OLevelObjs::do_thickness_sprite(oentry* sprite, const uint32_t sprite_table
     {
         //use_large_frame (don't choose a custom frame)
         sprite->zoom = (uint8_t) z; // Set Entry Number For Zoom Lookup Table
-        sprite->addr = rom->read32(0x3C + sprite_table_address); // Set default frame for larger sprite
+        sprite->frames = spriteRom->thickness(frame_table, 0x3C); // Set default frame for larger sprite
     }
     else
     {
         // use custom frame for sprite
         sprite->zoom = 0x80; // cap sprite_z minimum to 0x80
         z = (z >> 1) & 0x3C; // Mask over lower 2 bits, so the frame aligns to a word
-        sprite->addr = rom->read32(z + sprite_table_address); // Set Frame Data Based On Zoom Value
+        sprite->frames = spriteRom->thickness(frame_table, z); // Set Frame Data Based On Zoom Value
     }
     // order_sprites
     osprites->do_spr_order_shadows(sprite);
@@ -22,11 +22,12 @@
 class OSprites;
 class ORoad;
 class RomLoader;
+class SpriteRom;
 
 class OLevelObjs
 {
     public:
-        OLevelObjs(OSprites* osprites, ORoad* oroad, RomLoader *rom);
+        OLevelObjs(OSprites* osprites, ORoad* oroad, RomLoader *rom, const SpriteRom* spriteRom);
         ~OLevelObjs(void);
 
         void init_entries(uint32_t, const uint8_t start_index, const uint8_t);
@@ -38,6 +39,7 @@ class OLevelObjs
         OSprites* osprites;
         ORoad* oroad;
         RomLoader* rom;
+        const SpriteRom* spriteRom;
 
 	    void setup_sprite(oentry*, uint32_t);
 	    void setup_sprite_routine(oentry*);		
@@ -49,7 +51,7 @@ class OLevelObjs
         void sprite_rocks(oentry* sprite);
         void sprite_debris(oentry* sprite);
         void sprite_minitree(oentry* sprite);
-        void do_thickness_sprite(oentry* sprite, const uint32_t);
+        void do_thickness_sprite(oentry* sprite, const int);
         void sprite_clouds(oentry* sprite);
 	    void sprite_normal(oentry*, uint8_t);
 	    void set_spr_zoom_priority(oentry*, uint8_t);
@@ -18,9 +18,11 @@
     See license.txt for more details.
 ***************************************************************************/
 
+#include <string.h>
 #include "../import/romloader.hpp"
 #include "hwroad.hpp"
 #include "oroad.hpp"
+#include "roadkernels.hpp"
 
 
 ORoad::ORoad(QList<HeightSegment>* heightSections, HWRoad* hwroad, RomLoader* rom)
@@ -28,6 +30,9 @@ ORoad::ORoad(QList<HeightSegment>* heightSections, HWRoad* hwroad, RomLoader* ro
     this->heightSections = heightSections;
     this->hwroad         = hwroad;
     this->rom            = rom;
+    path                 = NULL;
+    end_pos              = 0;
+    bg_colors_decoded    = false;
 }
 
 ORoad::~ORoad(void)
@@ -82,6 +87,8 @@ void ORoad::init()
          road_y[i] = 0;
 
     road_pos_old = 0;
+    road_x_valid = false;
+    road_x_pos = 0;
     road_data_offset = 0;
     height_start = 0;
     height_ctrl = 0;
@@ -227,9 +234,44 @@ void ORoad::setup_road_x()
 {
     road_data_offset = (road_pos >> 16);// << 2;
     uint32_t addr = road_data_offset; // temporary hack for custom data
-    set_tilemap_x(addr);
-    setup_x_data(addr);
+
+    // Path data only changes when the level is edited, so reuse it where possible
+    if (!road_x_valid || road_x_pos != addr)
+    {
+        set_tilemap_x(addr);
+        setup_x_data(addr);
+        road_x_valid = true;
+        road_x_pos   = addr;
+    }
+    setup_hscroll();
+}
+
+// Set the road path to render
+void ORoad::setPath(const QPoint* path, int end_pos)
+{
+    this->path    = path;
+    this->end_pos = end_pos;
+    road_x_valid  = false;
+}
+
+// Force road_x to be recalculated from the path on the next tick.
+void ORoad::invalidate_road_x()
+{
+    road_x_valid = false;
+}
+
+// Re-apply the camera position to the existing road_x data.
+//
+// Writes the new H-Scroll values directly to the visible half of road ram, so the
+// preview can move the camera without ticking the entire road engine.
+void ORoad::update_hscroll()
+{
     setup_hscroll();
+
+    hwroad->read_road_control(); // swap in visible half of road ram
+    output_hscroll(&road0_h[0], HW_HSCROLL_TABLE0);
+    output_hscroll(&road1_h[0], HW_HSCROLL_TABLE1);
+    hwroad->read_road_control(); // and swap it back again
 }
 
 // Setup Road Path
@@ -240,9 +282,9 @@ void ORoad::setup_road_x()
 
 void ORoad::setup_x_data(uint32_t addr)
 {
-    const uint32_t len = levelData->end_pos - 1;
-    QPoint p1 = levelData->path[addr + 0 <= len ? addr + 0 : len];
-    QPoint p2 = levelData->path[addr + 1 <= len ? addr + 1 : len];
+    const uint32_t len = end_pos - 1;
+    QPoint p1 = path[addr + 0 <= len ? addr + 0 : len];
+    QPoint p2 = path[addr + 1 <= len ? addr + 1 : len];
 
     const int16_t x = p1.x() + p2.x(); // Length 1
     const int16_t y = p1.y() + p2.y(); // Length 2
@@ -276,8 +318,8 @@ void ORoad::setup_x_data(uint32_t addr)
     // We sample 20 Road Positions to generate the road.
     for (uint8_t i = 0; i <= 0x20; i++)
     {
-        p1 = levelData->path[addr <= len ? addr++ : len];
-        p2 = levelData->path[addr <= len ? addr++ : len];
+        p1 = path[addr <= len ? addr++ : len];
+        p2 = path[addr <= len ? addr++ : len];
 
         const int32_t x_next = p1.x() + p2.x(); // Length 1
         const int32_t y_next = p1.y() + p2.y(); // Length 2
@@ -339,11 +381,11 @@ void ORoad::set_tilemap_x(uint32_t addr)
     // d0 = Word 0 + Word 2 + Word 4 + Word 6 [Next 4 x positions]
     // d1 = Word 1 + Word 3 + Word 5 + Word 7 [Next 4 y positions]
 
-    const uint32_t len = levelData->end_pos - 1;
-    QPoint p1 = levelData->path[addr <= len ? addr++ : len];
-    QPoint p2 = levelData->path[addr <= len ? addr++ : len];
-    QPoint p3 = levelData->path[addr <= len ? addr++ : len];
-    QPoint p4 = levelData->path[addr <= len ? addr++ : len];
+    const uint32_t len = end_pos - 1;
+    QPoint p1 = path[addr <= len ? addr++ : len];
+    QPoint p2 = path[addr <= len ? addr++ : len];
+    QPoint p3 = path[addr <= len ? addr++ : len];
+    QPoint p4 = path[addr <= len ? addr++ : len];
 
     int16_t x = p1.x();
     int16_t y = p1.y();
@@ -990,11 +1032,8 @@ void ORoad::set_y_2044()
     // ------------------------------------------------------------------------
     if (section_length >= 0)
     {
-        for (uint16_t i = 0; i <= section_length; i++)
-        {
-            total_height += change_per_entry;
-            road_y[--y_addr] = (total_height << 4) >> 16;
-        }
+        total_height = RoadKernels::height_ramp(&road_y[y_addr], section_length + 1, total_height, change_per_entry);
+        y_addr -= section_length + 1;
     }
 
     // ------------------------------------------------------------------------
@@ -1120,15 +1159,8 @@ void ORoad::set_y_horizon()
     int32_t d1 = (horizon_mod * (height_start - 0x100)) >> 4;
     int32_t d2 = (horizon_base << 4) + d1;
 
-    uint32_t total_height = 0;
-
-    // write_next_y:
-    for (uint16_t i = 0; i <= 0x1FF; i++) // (1FF height positions)
-    {
-        total_height += d2;
-        uint32_t d0 = (total_height << 4) >> 16;
-        road_y[--a0] = d0;
-    }
+    // write_next_y: (1FF height positions)
+    RoadKernels::height_ramp(&road_y[a0], 0x200, 0, d2);
 
     road_unk[0] = 0;
 
@@ -1342,8 +1374,8 @@ void ORoad::do_road_data()
         // loc 1388
         else if (d7 > 0x3F)
         {
-            while (scanline-- > 0)
-                road_y[--addr_dst] = TRANSPARENT; // Copy transparent line to ram
+            // Copy transparent lines to ram
+            RoadKernels::fill(&road_y[addr_dst], scanline, TRANSPARENT);
 
             // end
             road_y[addr_priority] = 0; road_y[addr_priority + 1] = 0;
@@ -1353,26 +1385,24 @@ void ORoad::do_road_data()
             d7 |= SOLID_FILL; // Solid Fill Bits | Colour Info
 
         // 1392
-        do // Output solid colours while looping (compare with default solid fill d3)
+        // Output solid colours, each for two lines, incrementing up to the transparent colour.
+        // Stop once the scanline counter expires.
+        const int solid_lines = (TRANSPARENT - d7 + 1) * 2;
+        const int lines       = (scanline < 0 ? 0 : scanline) + 1;
+
+        if (lines <= solid_lines)
         {
-            road_y[--addr_dst] = d7; // Output solid colour
-            if (--scanline < 0) // Check whether scanloop counter expired
-            {
-                road_y[addr_priority] = 0; road_y[addr_priority + 1] = 0;
-                return;
-            }
-            road_y[--addr_dst] = d7; // Output solid colour
-            if (--scanline < 0) // Check whether scanloop counter expired
-            {
-                road_y[addr_priority] = 0; road_y[addr_priority + 1] = 0;
-                return;
-            }
-            d7++; // Increment solid colour
+            RoadKernels::colour_ramp(&road_y[addr_dst], lines, d7);
+            road_y[addr_priority] = 0; road_y[addr_priority + 1] = 0;
+            return;
         }
-        while (d7 <= TRANSPARENT);
 
-        while (scanline-- > 0)
-            road_y[--addr_dst] = TRANSPARENT; // Copy transparent line to ram
+        RoadKernels::colour_ramp(&road_y[addr_dst], solid_lines, d7);
+        addr_dst -= solid_lines;
+        scanline -= solid_lines;
+
+        // Copy transparent lines to ram
+        RoadKernels::fill(&road_y[addr_dst], scanline, TRANSPARENT);
     // 1346
     }
 
@@ -1425,56 +1455,21 @@ void ORoad::blit_roads()
 
 void ORoad::blit_road(uint32_t a0)
 {
-    uint32_t a2 = 0x400 + road_p2;
+    const int WORDS = 14 * 16;
 
     // Write 0x1A0 bytes total Src: (0x260 - 0x400) Dst: 0x1C0
-    for (int16_t i = 0; i <= 13; i++)
-    {
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-        a0 -= 2; hwroad->write16(a0, road_y[--a2]);
-    }
+    // Both are written downwards from the end address, so this is a straight copy.
+    memcpy(hwroad->write_ptr(a0 - (WORDS * 2)), &road_y[0x400 + road_p2 - WORDS], WORDS * sizeof(int16_t));
 }
 
 void ORoad::output_hscroll(int16_t* src, uint32_t dst)
 {
-    const int32_t d6 = 0x654;
-    uint32_t src_addr = 0;
-    // Copy 16 bytes
-    for (int32_t i = 0; i <= 0x3F; i++)
-    {
-        int16_t d0h = -src[src_addr++] + d6;
-        int16_t d0l = -src[src_addr++] + d6;
-        int16_t d1h = -src[src_addr++] + d6;
-        int16_t d1l = -src[src_addr++] + d6;
-        int16_t d2h = -src[src_addr++] + d6;
-        int16_t d2l = -src[src_addr++] + d6;
-        int16_t d3h = -src[src_addr++] + d6;
-        int16_t d3l = -src[src_addr++] + d6;
-
-        hwroad->write16(&dst, d0h);
-        hwroad->write16(&dst, d0l);
-        hwroad->write16(&dst, d1h);
-        hwroad->write16(&dst, d1l);
-        hwroad->write16(&dst, d2h);
-        hwroad->write16(&dst, d2l);
-        hwroad->write16(&dst, d3h);
-        hwroad->write16(&dst, d3l);
-    }
+    const int16_t d6 = 0x654;
+    uint16_t* dst_ptr = hwroad->write_ptr(dst);
+
+    // Copy 0x400 bytes
+    for (int32_t i = 0; i < 0x200; i++)
+        dst_ptr[i] = -src[i] + d6;
 }
 
 // Copy Background Colour To Road.
@@ -1495,27 +1490,27 @@ void ORoad::output_hscroll(int16_t* src, uint32_t dst)
 //          -------- ------b-  Road 0: pixel value 1 color index
 //          -------- -------c  Road 0: pixel value 0 color index
 
+//
+// The table for each fine position is decoded from rom on first use.
+
 void ORoad::copy_bg_color()
 {
     static const uint32_t ROAD_BGCOLOR = 0x109EE;
 
-    // Scroll stripe data over road based on fine position
-    uint32_t pos_fine_copy = (pos_fine & 0x1F) << 10;
-    uint32_t src = ROAD_BGCOLOR + pos_fine_copy;
-    uint32_t dst = HW_BGCOLOR;
-
-    // Copy 1K
-    for (int i = 0; i < 32; i++)
+    if (!bg_colors_decoded)
     {
-        hwroad->write32(&dst, rom->read32(&src));
-        hwroad->write32(&dst, rom->read32(&src));
-        hwroad->write32(&dst, rom->read32(&src));
-        hwroad->write32(&dst, rom->read32(&src));
-        hwroad->write32(&dst, rom->read32(&src));
-        hwroad->write32(&dst, rom->read32(&src));
-        hwroad->write32(&dst, rom->read32(&src));
-        hwroad->write32(&dst, rom->read32(&src));
+        for (int phase = 0; phase < BG_PHASES; phase++)
+        {
+            uint32_t src = ROAD_BGCOLOR + (phase << 10);
+            for (int i = 0; i < BG_WORDS; i++)
+                bg_colors[phase][i] = rom->read16(&src);
+        }
+        bg_colors_decoded = true;
     }
+
+    // Scroll stripe data over road based on fine position
+    // Copy 1K
+    memcpy(hwroad->write_ptr(HW_BGCOLOR), bg_colors[pos_fine & 0x1F], BG_WORDS * sizeof(uint16_t));
 }
 
 // Square Root Functions
@@ -162,10 +162,17 @@ public:
     void setHorizonMod(int horizon_mod);
     void setHorizon(int horizon_base);
     void removeUserOffset(int userY);
+    void setPath(const QPoint* path, int end_pos);
+    void invalidate_road_x();
+    void update_hscroll();
 
 private:
     QList<HeightSegment>* heightSections;
     HeightSegment heightSeg;
+
+    // Road Path & Length. Used in place of the data stored in ROM.
+    const QPoint* path;
+    int end_pos;
     HWRoad* hwroad;
     RomLoader* rom;
 
@@ -173,6 +180,11 @@ private:
 
     uint32_t road_pos_old; // 0x410: Road Position Backup
 
+    // Set when road_x & tilemap_h_target hold the path data for road_x_pos.
+    // Allows the instant redraw to skip setup_x_data when only heights or camera change.
+    bool road_x_valid;
+    uint32_t road_x_pos;
+
     // 60530 - [word] Distance into section of track, for height #1
     // Ranges from 0x100 - 0x1FF
     uint16_t height_start;
@@ -268,6 +280,12 @@ private:
     static const uint32_t HW_HSCROLL_TABLE1 = 0x80800;
     static const uint32_t HW_BGCOLOR = 0x80C00;
 
+    // Background colour tables (ROAD_BGCOLOR) for each fine position, decoded from rom
+    static const int BG_PHASES = 32;
+    static const int BG_WORDS  = 0x200;
+    uint16_t bg_colors[BG_PHASES][BG_WORDS];
+    bool bg_colors_decoded;
+
     void init_road_code();
     void set_default_hscroll();
     void clear_road_ram();
@@ -19,6 +19,8 @@
 #include "ozoom_lookup.hpp"
 #include "oroad.hpp"
 #include "osprites.hpp"
+#include "spriterom.hpp"
+#include "spritepatterns.hpp"
 
 // ------------------------------------------------------------------------------------------------
 // OutRun ROM Addresses
@@ -27,27 +29,23 @@
 // Sprite Default Properties Table
 const uint32_t SPRITE_DEF_PROPS1  = 0x2B70;
 
-const uint32_t SPRITE_SHDW_FRAMES = 0x7862;
-const uint32_t SPRITE_SHDW_SMALL  = 0x1193C;
-
-// Sprite Zoom Lookup Table: Table Of Longs that represent X & Y Zoom Value
-const uint32_t SPRITE_ZOOM_LOOKUP = 0x28000;
-
 // ------------------------------------------------------------------------------------------------
 
-OSprites::OSprites(HWSprites* hwsprites, QList<SpriteSectionEntry>* spriteSections, ORoad *oroad, RomLoader* rom)
+OSprites::OSprites(HWSprites* hwsprites, const QSharedPointer<const SpritePatterns>* spritePatterns, ORoad *oroad, RomLoader* rom)
 {
     this->hwsprites      = hwsprites;
-    this->spriteSections = spriteSections;
+    this->spritePatterns = spritePatterns;
     this->oroad          = oroad;
     this->rom            = rom;
-    olevelobjs           = new OLevelObjs(this, oroad, rom);
+    spriteRom            = new SpriteRom(rom);
+    olevelobjs           = new OLevelObjs(this, oroad, rom, spriteRom);
     no_sprites           = SPRITE_ENTRIES;
 }
 
 OSprites::~OSprites(void)
 {
     delete olevelobjs;
+    delete spriteRom;
 }
 
 void OSprites::init()
@@ -74,6 +72,7 @@ void OSprites::init()
     seg_sprite_freq     = 0;
     seg_spr_offset2     = 0;
     seg_spr_offset1     = 0;
+    seg_sprites         = NULL;
 
     sprite_scroll_speed = 0;//(uint16_t) (11 << 0xb); // 8800
 
@@ -81,6 +80,9 @@ void OSprites::init()
     sprite_count        = 0;
     spr_cnt_main        = 0;
     spr_cnt_shadow      = 0;
+    spr_cnt_dropped     = 0;
+    sprite_count_shadow = 0;
+    sprite_count_dropped = 0;
 
     spr_col_pal         = 0;
     pal_copy_count      = 0;
@@ -172,15 +174,19 @@ void OSprites::sprite_control(int pos, const ControlPoint* cp)
         seg_total_sprites = cp->value1;                                // Number Of Sprites In Segment [byte]
 
         // Check whether index is valid. User may have deleted section.
-        if (cp->value2 >= 0 && spriteSections->length() > cp->value2)
+        const SpritePatterns* patterns = spritePatterns->data();
+        const SpritePatterns::Pattern* pattern = patterns != NULL ? patterns->pattern(cp->value2) : NULL;
+
+        if (pattern != NULL)
         {
-            currentSection  = spriteSections->at(cp->value2);              // Block of Sprites [Byte]
-            seg_sprite_freq = currentSection.frequency;
-            seg_spr_offset2 = (int16_t) currentSection.sprites.size() - 1; // Set Reload value for sprite info offset
+            seg_sprites     = patterns->sprites(pattern);                  // Block of Sprites [Byte]
+            seg_sprite_freq = pattern->frequency;
+            seg_spr_offset2 = pattern->last;                               // Set Reload value for sprite info offset
             seg_spr_offset1 = 0;                                           // And Clear the offset into the above table
         }
         else
         {
+            seg_sprites     = NULL;
             seg_sprite_freq = 0;
             seg_spr_offset2 = 0;
             seg_spr_offset1 = 0;
@@ -307,7 +313,10 @@ void OSprites::do_spr_order_shadows(oentry* input)
 {
     // LayOut specific fix to avoid memory crash on over populated scenery segments
     if (spr_cnt_main + spr_cnt_shadow >= JUMP_ENTRIES_TOTAL)
+    {
+        spr_cnt_dropped += (input->control & SHADOW) ? 2 : 1;
         return;
+    }
 
     // Use priority as lookup into table. Assume we're on boundaries of 0x10
     uint16_t priority = (input->priority & 0x1FF) << 4;
@@ -321,6 +330,8 @@ void OSprites::do_spr_order_shadows(oentry* input)
         sprite_order[priority + bytes_to_copy + 1] = input->jump_index; // put at offset +2
         spr_cnt_main++;
     }
+    else
+        spr_cnt_dropped++;
 
     // Code to handle shadows under sprites
     // test_shadow: 
@@ -328,7 +339,10 @@ void OSprites::do_spr_order_shadows(oentry* input)
 
     // LayOut specific fix to avoid memory crash on over populated scenery segments
     if (spr_cnt_main + spr_cnt_shadow >= JUMP_ENTRIES_TOTAL)
+    {
+        spr_cnt_dropped++;
         return;
+    }
 
     input->dst_index = spr_cnt_shadow;
     spr_cnt_shadow++;                       // Increment total shadow count
@@ -336,7 +350,7 @@ void OSprites::do_spr_order_shadows(oentry* input)
     uint8_t pal_dst = input->pal_dst;       // Backup Sprite Colour Palette
     uint8_t shadow = input->shadow;         // and priority and shadow settings
     int16_t x = input->x;                   // and x position
-    uint32_t addr = input->addr;            // and original sprite data address
+    const SpriteFrames* frames = input->frames; // and original sprite frames
     input->pal_dst = 0;                     // clear colour palette
     input->shadow = 7;                      // Set NEW priority & shadow settings
     
@@ -344,12 +358,12 @@ void OSprites::do_spr_order_shadows(oentry* input)
 
     if (input->control & TRAFFIC_SPRITE)
     {
-        input->addr = SPRITE_SHDW_SMALL;
+        input->frames = spriteRom->shadowSmall;
         input->x = x;
     }
     else
     {
-        input->addr = rom->read32(SPRITE_SHDW_FRAMES + 0x3C);
+        input->frames = spriteRom->shadow;
     }
 
     do_sprite(input);           // Create Shadowed Version Of Sprite For Hardware
@@ -357,7 +371,7 @@ void OSprites::do_spr_order_shadows(oentry* input)
     input->pal_dst = pal_dst;   // Restore Sprite Colour Palette
     input->shadow = shadow;     // ...and other values
     input->x = x;
-    input->addr = addr;
+    input->frames = frames;
 }
 
 // Sprite Copying Routine
@@ -377,6 +391,7 @@ void OSprites::sprite_copy()
 
     if (spr_cnt_main + spr_cnt_shadow > 0x7F)
     {
+        spr_cnt_dropped += spr_cnt_main + spr_cnt_shadow;
         spr_cnt_main = spr_cnt_shadow = 0;
         finalise_sprites();
         return;
@@ -441,7 +456,9 @@ void OSprites::sprite_copy()
 void OSprites::finalise_sprites()
 {
     sprite_count = spr_cnt_main + spr_cnt_shadow;
-    spr_cnt_main = spr_cnt_shadow = 0;
+    sprite_count_shadow  = spr_cnt_shadow;
+    sprite_count_dropped = spr_cnt_dropped;
+    spr_cnt_main = spr_cnt_shadow = spr_cnt_dropped = 0;
 }
 
 // Convert Sprite From Internal Software Format To Hardware Format
@@ -482,8 +499,8 @@ void OSprites::do_sprite(oentry* input)
     // todo: pass pointer?
     output->scratch = input->jump_index;
 
-    // Hide Sprite if zoom lookup not set
-    if (input->zoom == 0)
+    // Hide Sprite if zoom lookup or frames not set
+    if (input->zoom == 0 || input->frames == NULL)
     {
         hide_hwsprite(input, output);
         return;
@@ -506,7 +523,8 @@ void OSprites::do_sprite(oentry* input)
     // This is the address of the frame required for the level of zoom we're using
     // There are 5 unique frames that are typically used for zoomed sprites.
     // which correspond to different screen sizes
-    uint32_t src_offsets = input->addr + ZOOM_LOOKUP[index];
+    const SpriteFrame* frame = &input->frames->frame[ZOOM_LOOKUP[index] / SpriteRom::FRAME_BYTES];
+    const uint8_t* wh = spriteRom->wh;
 
     uint16_t d0 = input->draw_props | (input->zoom << 8);
     uint16_t top_bit = d0 & 0x8000;
@@ -520,10 +538,10 @@ void OSprites::do_sprite(oentry* input)
             d0 = lookup_mask;
         }
 
-        d0 = (d0 & 0xFF00) + rom->read8(src_offsets + 1);
-        width = rom->read8(WH_TABLE + d0);
-        d0 = (d0 & 0xFF00) + rom->read8(src_offsets + 3);
-        height = rom->read8(WH_TABLE + d0);
+        d0 = (d0 & 0xFF00) + frame->width;
+        width = wh[d0];
+        d0 = (d0 & 0xFF00) + frame->height;
+        height = wh[d0];
     }
     // loc_9560:
     else
@@ -531,13 +549,13 @@ void OSprites::do_sprite(oentry* input)
         d0 &= 0x7C00;
         uint16_t h = d0;
 
-        d0 = (d0 & 0xFF00) + rom->read8(src_offsets + 1);
-        width = rom->read8(WH_TABLE + d0);
+        d0 = (d0 & 0xFF00) + frame->width;
+        width = wh[d0];
         d0 &= 0xFF;
         width += d0;
         
-        h |= rom->read8(src_offsets + 3);
-        height = rom->read8(WH_TABLE + h);
+        h |= frame->height;
+        height = wh[h];
         h &= 0xFF;
         height += h;
 
@@ -574,8 +592,8 @@ void OSprites::do_sprite(oentry* input)
     // Set Palette & Sprite Bank Information
     // -------------------------------------------------------------------------
     output->set_pal(input->pal_dst); // Set Sprite Colour Palette
-    output->set_offset(rom->read16(src_offsets + 8)); // Set Offset within selected sprite bank
-    output->set_bank(rom->read8(src_offsets + 7) << 1); // Set Sprite Bank Value
+    output->set_offset(frame->offset); // Set Offset within selected sprite bank
+    output->set_bank(frame->bank << 1); // Set Sprite Bank Value
 
     // -------------------------------------------------------------------------
     // Set Sprite Height
@@ -583,9 +601,9 @@ void OSprites::do_sprite(oentry* input)
     if (sprite_y1 < 256)
     {
         int16_t y_adj = -(sprite_y1 - 256);
-        y_adj *= rom->read16(src_offsets + 2); // Width of line data (Unsigned multiply)
+        y_adj *= frame->line_width; // Width of line data (Unsigned multiply)
         y_adj /= height; // Unsigned divide
-        y_adj *= rom->read16(src_offsets + 4); // Length of line data (Unsigned multiply)
+        y_adj *= frame->line_length; // Length of line data (Unsigned multiply)
         output->inc_offset(y_adj);
         output->data[0x0] = (output->data[0x0] & 0xFF00) | 0x100; // Mask on negative y index
         output->set_height((uint8_t) sprite_y2);
@@ -663,12 +681,12 @@ void OSprites::do_sprite(oentry* input)
     }
 
     // cont2:
-    set_hrender(input, output, rom->read16(src_offsets + 4), width);
+    set_hrender(input, output, frame->line_length, width);
     
     // -------------------------------------------------------------------------
     // Set Sprite Pitch & Priority
     // -------------------------------------------------------------------------
-    output->set_pitch(rom->read8(src_offsets + 5) << 1);
+    output->set_pitch(frame->pitch << 1);
     output->set_priority(input->shadow << 4); // todo: where does this get set?
 }
 
@@ -792,8 +810,7 @@ void OSprites::set_hrender(oentry* input, osprite* output, uint16_t offset, uint
 // Helper function to vary the move distance, based on the current frame-rate.
 void OSprites::move_sprite(oentry* sprite, uint8_t shift)
 {
-    uint32_t addr = SPRITE_ZOOM_LOOKUP + (((sprite->z >> 16) << 2) | sprite_scroll_speed);
-    uint32_t value = rom->read32(addr) >> shift;
+    uint32_t value = spriteRom->zoomStep(((sprite->z >> 16) << 2) | sprite_scroll_speed) >> shift;
     sprite->z += value;
 }
 
@@ -14,7 +14,7 @@
 
 #pragma once
 
-#include <QList>
+#include <QSharedPointer>
 #include "oentry.hpp"
 #include "osprite.hpp"
 #include "../sprites/spriteformat.hpp"
@@ -24,6 +24,8 @@ class ORoad;
 class OLevelObjs;
 struct ControlPoint;
 class RomLoader;
+class SpriteRom;
+class SpritePatterns;
 
 class OSprites
 {
@@ -121,6 +123,13 @@ public:
 	// Number of shadows to draw
 	uint16_t spr_cnt_shadow;
 
+    // LayOut: Sprites and shadows dropped as the tables were full, for the sprite budget
+    uint16_t spr_cnt_dropped;
+
+    // LayOut: Breakdown of sprite_count for the last frame
+    uint16_t sprite_count_shadow;
+    uint16_t sprite_count_dropped;
+
     // Palette Addresses. Used in conjunction with palette lookup table.
     // Originally stored between 0x61602 - 0x617FF in RAM
     //
@@ -137,9 +146,9 @@ public:
     // Stores number of palette entries to copy from rom to palram
     int16_t pal_copy_count;
 
-    SpriteSectionEntry currentSection;
+    const SpriteEntry* seg_sprites; // Sprites of current pattern
 
-    OSprites(HWSprites* hwsprites, QList<SpriteSectionEntry>* spriteSections, ORoad *oroad, RomLoader* rom);
+    OSprites(HWSprites* hwsprites, const QSharedPointer<const SpritePatterns>* spritePatterns, ORoad *oroad, RomLoader* rom);
 	~OSprites(void);
 	void init();
     void disable_sprites();
@@ -160,10 +169,11 @@ public:
 
 private:
     HWSprites* hwsprites;
-    QList<SpriteSectionEntry>* spriteSections;
+    const QSharedPointer<const SpritePatterns>* spritePatterns;
     ORoad* oroad;
     OLevelObjs* olevelobjs;
     RomLoader* rom;
+    SpriteRom* spriteRom;
 
     // Default sprite entries for stage 1 initialization
     const static uint8_t DEF_SPRITE_ENTRIES = 0x44;
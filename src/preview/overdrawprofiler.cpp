@@ -0,0 +1,128 @@
+/***************************************************************************
+    Overdraw Profiler.
+
+    Finds the positions of a level where the hardware writes the most
+    pixels.
+
+    A frame is composed at every position of the level on a worker thread,
+    counting the pixels written by the road and sprite hardware. Scenery
+    that overlaps heavily can be slow on low-end hardware, even when the
+    sprite count is within budget.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <algorithm>
+#include <iostream>
+#include <QtConcurrent>
+#include <QTimer>
+
+#include "overdrawprofiler.hpp"
+
+OverdrawProfiler::OverdrawProfiler(QObject *parent) :
+    QObject(parent)
+{
+    renderer = NULL;
+    length   = 0;
+    connect(&watcher, SIGNAL(finished()), this, SLOT(done()));
+
+    progressTimer = new QTimer(this);
+    progressTimer->setInterval(PROGRESS_INTERVAL);
+    connect(progressTimer, SIGNAL(timeout()), this, SLOT(reportProgress()));
+}
+
+OverdrawProfiler::~OverdrawProfiler()
+{
+    stop();
+    delete renderer;
+}
+
+// Takes ownership of the renderer, which may be NULL when the ROMs are unloaded
+void OverdrawProfiler::setRenderer(PreviewRenderer* renderer)
+{
+    stop();
+    reports.clear();
+
+    delete this->renderer;
+    this->renderer = renderer;
+}
+
+// Profile a snapshot of the level. A sweep already running is cancelled first.
+void OverdrawProfiler::profile(QSharedPointer<const PreviewScene> scene)
+{
+    if (renderer == NULL || scene.isNull())
+        return;
+
+    stop();
+
+    cancelled.storeRelease(0);
+    completed.storeRelease(0);
+    length = qMax(scene->end_pos, 0);
+
+    PreviewRenderer* renderer = this->renderer;
+    const QAtomicInt* cancel  = &cancelled;
+    QAtomicInt* count         = &completed;
+
+    // The snapshot is held by the job until it completes
+    watcher.setFuture(QtConcurrent::run([=]()
+    {
+        return renderer->measureOverdraw(*scene, cancel, count);
+    }));
+
+    progressTimer->start();
+}
+
+void OverdrawProfiler::stop()
+{
+    cancel();
+    watcher.waitForFinished();
+}
+
+// Cancel the sweep in progress, without waiting for it to stop
+void OverdrawProfiler::cancel()
+{
+    cancelled.storeRelease(1);
+    progressTimer->stop();
+}
+
+void OverdrawProfiler::reportProgress()
+{
+    emit progress(completed.loadAcquire(), length);
+}
+
+void OverdrawProfiler::done()
+{
+    if (cancelled.loadAcquire() != 0)
+        return;
+
+    progressTimer->stop();
+
+    reports = watcher.result();
+
+    if (DEBUG)
+    {
+        foreach (int pos, worstPositions(5))
+            std::cout << "OverdrawProfiler: pos " << pos << " pixels " << reports.at(pos).pixels << std::endl;
+    }
+
+    emit finished();
+}
+
+// Positions with the most pixel writes, worst first
+QVector<int> OverdrawProfiler::worstPositions(int count) const
+{
+    QVector<int> positions(reports.size());
+    for (int i = 0; i < positions.size(); i++)
+        positions[i] = i;
+
+    count = std::min(count, positions.size());
+
+    std::partial_sort(positions.begin(), positions.begin() + count, positions.end(), [this](int a, int b)
+    {
+        return reports.at(a).pixels > reports.at(b).pixels;
+    });
+
+    positions.resize(count);
+    return positions;
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+    Overdraw Profiler.
+
+    Finds the positions of a level where the hardware writes the most
+    pixels.
+
+    A frame is composed at every position of the level on a worker thread,
+    counting the pixels written by the road and sprite hardware. Scenery
+    that overlaps heavily can be slow on low-end hardware, even when the
+    sprite count is within budget.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QVector>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QFutureWatcher>
+
+#include "previewrenderer.hpp"
+
+class QTimer;
+
+class OverdrawProfiler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OverdrawProfiler(QObject *parent = 0);
+    ~OverdrawProfiler();
+
+    void setRenderer(PreviewRenderer* renderer);
+    void profile(QSharedPointer<const PreviewScene> scene);
+    void stop();
+    bool isRunning() const { return watcher.isRunning(); }
+
+    const QVector<OverdrawReport>& getReports() const { return reports; }
+    QVector<int> worstPositions(int count) const;
+
+signals:
+    void progress(int done, int total);
+    void finished();
+
+public slots:
+    void cancel();
+
+private slots:
+    void done();
+    void reportProgress();
+
+private:
+    const static bool DEBUG = false;
+    const static int PROGRESS_INTERVAL = 100; // Milliseconds between progress reports
+
+    // Renderer used for profiling only. Never used by more than one job at a time.
+    PreviewRenderer* renderer;
+
+    QAtomicInt cancelled;
+    QAtomicInt completed;     // Positions completed by the current job
+    int length;               // Positions profiled by the current job
+    QTimer* progressTimer;
+    QFutureWatcher<QVector<OverdrawReport> > watcher;
+
+    // Result of the last completed sweep, indexed by position
+    QVector<OverdrawReport> reports;
+};
@@ -0,0 +1,84 @@
+/***************************************************************************
+    Preview Frame Cache.
+
+    Holds recently rendered frames for the S16 Preview, so that scrubbing
+    back and forth along the road does not render the same frame twice.
+
+    Frames are keyed by position, camera and the generation of the level
+    and palette data they were rendered from. The least recently used
+    frame is evicted once the cache is full.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <iostream>
+#include "previewcache.hpp"
+
+PreviewCache::PreviewCache(int capacity)
+{
+    this->capacity = capacity;
+    hits      = 0;
+    misses    = 0;
+    evictions = 0;
+}
+
+PreviewCache::~PreviewCache()
+{
+}
+
+// Lookup a frame, marking it as the most recently used
+bool PreviewCache::find(const PreviewKey& key, CachedFrame* frame)
+{
+    int index = indexOf(key);
+
+    if (index == -1)
+    {
+        misses++;
+        return false;
+    }
+
+    hits++;
+    if (DEBUG) std::cout << "cache hit pos: " << key.pos << " hits: " << hits << " misses: " << misses << std::endl;
+
+    entries.move(index, 0);
+    *frame = entries.first();
+    return true;
+}
+
+bool PreviewCache::contains(const PreviewKey& key) const
+{
+    return indexOf(key) != -1;
+}
+
+void PreviewCache::insert(const CachedFrame& frame)
+{
+    int index = indexOf(frame.key);
+
+    if (index != -1)
+        entries.removeAt(index);
+
+    entries.push_front(frame);
+
+    while (entries.size() > capacity)
+    {
+        if (DEBUG) std::cout << "cache evict pos: " << entries.last().key.pos << std::endl;
+        entries.removeLast();
+        evictions++;
+    }
+}
+
+void PreviewCache::clear()
+{
+    entries.clear();
+}
+
+int PreviewCache::indexOf(const PreviewKey& key) const
+{
+    for (int i = 0; i < entries.size(); i++)
+    {
+        if (entries.at(i).key == key)
+            return i;
+    }
+    return -1;
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+    Preview Frame Cache.
+
+    Holds recently rendered frames for the S16 Preview, so that scrubbing
+    back and forth along the road does not render the same frame twice.
+
+    Frames are keyed by position, camera and the generation of the level
+    and palette data they were rendered from. The least recently used
+    frame is evicted once the cache is full.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <QList>
+#include "previewrenderer.hpp"
+
+// Frame held by the cache
+struct CachedFrame
+{
+    PreviewKey key;
+    QImage image;             // Final RGB image
+    QVector<QRect> selected;  // Selected scenery (screen co-ordinates)
+    OverdrawReport overdraw;  // Only when the key requests overdraw
+    bool valid;               // Level contained road to render
+
+    CachedFrame() : valid(false) {}
+};
+
+class PreviewCache
+{
+public:
+    PreviewCache(int capacity);
+    ~PreviewCache();
+
+    bool find(const PreviewKey& key, CachedFrame* frame);
+    bool contains(const PreviewKey& key) const;
+    void insert(const CachedFrame& frame);
+    void clear();
+
+    int size() const         { return entries.size(); }
+    int getHits() const      { return hits; }
+    int getMisses() const    { return misses; }
+    int getEvictions() const { return evictions; }
+
+private:
+    const static bool DEBUG = false;
+
+    int capacity;
+    QList<CachedFrame> entries; // Most recently used first
+
+    int hits;
+    int misses;
+    int evictions;
+
+    int indexOf(const PreviewKey& key) const;
+};
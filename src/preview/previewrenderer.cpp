@@ -0,0 +1,1046 @@
+/***************************************************************************
+    Preview Renderer.
+
+    Runs the OutRun road and sprite engine for the S16 Preview.
+
+    This lives on a dedicated worker thread, so the editor never waits for
+    a frame to be drawn. Frames are rendered into a pair of buffers, so the
+    preview widget can present the last completed frame whilst the next
+    one is being rendered.
+
+    Frames can instead show the overdraw of the scene: the number of times
+    each pixel is written by the road and sprite hardware.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+#include "../import/romloader.hpp"
+#include "../s16colour.hpp"
+#include "hwroad.hpp"
+#include "hwsprites.hpp"
+#include "oroad.hpp"
+#include "osprites.hpp"
+#include "previewrenderer.hpp"
+
+const static double POS_LENGTH = 10 * 12;  // Length of each segment
+
+PreviewRenderer::PreviewRenderer(RomLoader* rom0, RomLoader* sprites, RomLoader* rom1, RomLoader* roadRom)
+{
+    this->rom0 = rom0;
+
+    scene.end_pos    = 0;
+    scene.startWidth = 0;
+    scene.startLine  = false;
+    scene.skyPal     = 0;
+    scene.gndPal     = 0;
+    scene.roadPal    = 0;
+
+    hwroad    = new HWRoad();
+    hwsprites = new HWSprites();
+    hwroad->init(roadRom->rom);
+    oroad     = new ORoad(&scene.heightSections, hwroad, rom1);
+    hwsprites->init(sprites->rom);
+    osprites  = new OSprites(hwsprites, &scene.spritePatterns, oroad, rom0);
+
+    for (int i = 0; i < 2; i++)
+    {
+        frames[i].image  = QImage(S16_WIDTH, S16_HEIGHT, QImage::Format_RGB32);
+        frames[i].valid  = false;
+        frames[i].driven = false;
+        frames[i].renderTime = 0;
+    }
+    backFrame = 0;
+
+    // Split the frame into a band per core
+    const int bandCount = qBound(1, QThread::idealThreadCount(), MAX_BANDS);
+    bands.resize(bandCount);
+    for (int i = 0; i < bandCount; i++)
+    {
+        bands[i].yStart = (S16_HEIGHT * i) / bandCount;
+        bands[i].yEnd   = (S16_HEIGHT * (i + 1)) / bandCount;
+    }
+
+    pixels   = new uint16_t[S16_WIDTH * S16_HEIGHT];
+    composed = false;
+    memset(pixels, 0, S16_WIDTH * S16_HEIGHT * sizeof(uint16_t));
+
+    writes   = new uint8_t[S16_WIDTH * S16_HEIGHT];
+    composedOverdraw = false;
+    memset(writes, 0, S16_WIDTH * S16_HEIGHT * sizeof(uint8_t));
+    setupHeatColours();
+
+    memset(palette, 0, sizeof(palette));
+    memset(rgb, 0, sizeof(rgb));
+
+    for (int i = 0; i < SPR_PAL_BLOCKS; i++)
+        spritePals[i].loaded = false;
+
+    for (int i = 0; i < SPR_PAL_DST; i++)
+        spritePalDst[i] = -1;
+
+    init();
+}
+
+PreviewRenderer::~PreviewRenderer()
+{
+    delete osprites;
+    delete oroad;
+    delete hwsprites;
+    delete hwroad;
+
+    delete[] pixels;
+    delete[] writes;
+}
+
+const PreviewFrame* PreviewRenderer::getFrame(int index) const
+{
+    return &frames[index];
+}
+
+void PreviewRenderer::init()
+{
+    oroad->init();
+    resetRoadWidth();
+
+    osprites->init();
+    spriteIndex = 0;
+
+    lastPos     = 0;
+    horizonYOff = 0;
+    driving     = false;
+}
+
+void PreviewRenderer::setScene(const PreviewScene& scene)
+{
+    this->scene = scene;
+    oroad->setPath(this->scene.path.constData(), this->scene.end_pos);
+}
+
+// Render the requested frame into the back buffer, then flip it to the front.
+void PreviewRenderer::render(PreviewRequest request)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (request.scene)
+        setScene(*request.scene);
+
+    if (request.reset)
+    {
+        init();
+        request.stages = STAGE_ALL;
+    }
+
+    if (request.stages & STAGE_PALETTE)
+        setupRoadPalettes();
+
+    // Camera
+    if (request.key.cameraX != oroad->car_x_bak)
+    {
+        oroad->car_x_bak = request.key.cameraX;
+        request.stages |= STAGE_CAMERA;
+    }
+
+    if (request.key.cameraY != horizonYOff)
+    {
+        horizonYOff = request.key.cameraY;
+        request.stages |= STAGE_ROAD_Y;
+    }
+
+    if (request.drive)
+    {
+        drive(request.roadPos, request.stages);
+        compose(request.key.overdraw);
+    }
+    else
+    {
+        // Leaving drive mode. The engine is part way through a position, so simulate it again.
+        if (driving)
+        {
+            request.stages |= STAGE_ROAD_X;
+            driving = false;
+        }
+
+        // Position
+        if (request.key.pos != lastPos && request.key.pos < scene.end_pos)
+            request.stages |= STAGE_ROAD_X;
+
+        // Palette changes only need the last composed frame to be converted to RGB again
+        if (!composed || (request.stages & ~STAGE_PALETTE) || request.key.overdraw != composedOverdraw)
+        {
+            simulate(request.key.pos, request.stages);
+            compose(request.key.overdraw);
+        }
+    }
+
+    PreviewFrame* frame = &frames[backFrame];
+    frame->key    = request.key;
+    frame->driven = request.drive;
+    resolve(frame);
+    frame->renderTime = timer.nsecsElapsed() / 1000;
+
+    emit frameReady(backFrame);
+    backFrame ^= 1;
+}
+
+// Run the road and sprite stages at every position of a scene, recording the load on the
+// sprite hardware rather than drawing a frame. Returns an empty list if cancelled.
+QVector<SpriteLoad> PreviewRenderer::measureSprites(const PreviewScene& scene, const QAtomicInt* cancel)
+{
+    setScene(scene);
+    init();
+
+    QVector<SpriteLoad> load(qMax(scene.end_pos, 0));
+
+    for (int pos = 0; pos < load.size(); pos++)
+    {
+        if (cancel != NULL && cancel->loadAcquire() != 0)
+            return QVector<SpriteLoad>();
+
+        simulate(pos, STAGE_ROAD_X | STAGE_ROAD_Y | STAGE_SPRITES);
+
+        const int shadows = osprites->sprite_count_shadow;
+        load[pos].sprites = std::min(osprites->sprite_count - shadows, 0xFF);
+        load[pos].shadows = std::min(shadows, 0xFF);
+        load[pos].dropped = std::min((int) osprites->sprite_count_dropped, 0xFF);
+    }
+
+    return load;
+}
+
+// Compose a frame at every position of a scene, counting the pixels written by the hardware.
+// The number of positions completed is stored in progress. Returns an empty list if cancelled.
+QVector<OverdrawReport> PreviewRenderer::measureOverdraw(const PreviewScene& scene, const QAtomicInt* cancel, QAtomicInt* progress)
+{
+    setScene(scene);
+    init();
+
+    QVector<OverdrawReport> reports(qMax(scene.end_pos, 0));
+
+    for (int pos = 0; pos < reports.size(); pos++)
+    {
+        if (cancel != NULL && cancel->loadAcquire() != 0)
+            return QVector<OverdrawReport>();
+
+        simulate(pos, STAGE_ROAD_X | STAGE_ROAD_Y | STAGE_SPRITES);
+        compose(true);
+        reports[pos] = overdraw;
+
+        if (progress != NULL)
+            progress->storeRelease(pos + 1);
+    }
+
+    return reports;
+}
+
+// Re-run the requested stages of the preview pipeline.
+// Later stages depend on earlier ones, so they are re-run where necessary.
+void PreviewRenderer::simulate(int pos, int stages)
+{
+    // Check valid position
+    if (pos != -1 && pos < scene.end_pos)
+    {
+        if (scene.end_pos > 0)
+        {
+            if (DEBUG) std::cout << "simulate road pos: " << pos << " stages: " << stages << std::endl;
+            // Scroll road surface.
+            // Derived from the position alone, so a frame is the same regardless of how it was reached.
+            oroad->pos_fine = pos * 10;
+
+            lastPos = pos;
+
+            oroad->road_pos = pos << 16;
+
+            // Path -> road_x
+            if (stages & STAGE_ROAD_X)
+            {
+                updateRoadWidth(pos);
+                oroad->invalidate_road_x();
+            }
+
+            // Heights + Horizon -> road_y
+            // Tick enough times for the rotated road data to reach the road hardware.
+            if (stages & (STAGE_ROAD_X | STAGE_ROAD_Y))
+            {
+                updateRoadHorizon(pos);
+                updateRoadHeight(pos);
+                oroad->tick();
+                oroad->tick();
+                oroad->tick();
+                oroad->tick();
+            }
+            // Camera -> hscroll
+            else if (stages & STAGE_CAMERA)
+            {
+                oroad->update_hscroll();
+            }
+
+            // Scenery -> Sprite list
+            // Sprites are projected against the road, so changes to any earlier stage require this.
+            if (stages & (STAGE_ROAD_X | STAGE_ROAD_Y | STAGE_CAMERA | STAGE_SPRITES))
+                updateSprites(pos);
+        }
+    }
+}
+
+// Advance the road and sprite engine to a road position (16.16), the way the game does
+// whilst driving: each position passed is stepped in turn, rather than replayed from the
+// start of the level, and the road is ticked once per frame.
+//
+// Sprites are ticked once per position, as the preview's sprite engine is calibrated for.
+//
+// Road height and horizon are not stepped by the engine. The preview's ORoad has the original
+// height sequencer (setup_road_y) disabled, so they are placed from the height points for each
+// position passed, as the instant path does, and don't change within a position.
+void PreviewRenderer::drive(uint32_t roadPos, int stages)
+{
+    const int pos = roadPos >> 16;
+
+    if (pos >= scene.end_pos)
+        return;
+
+    // Edits, or jumps in position, restart the drive from the state at that position
+    if (!driving || (stages & ~STAGE_PALETTE) || pos < lastPos || pos > lastPos + MAX_DRIVE_STEP)
+    {
+        simulate(pos, STAGE_ALL);
+        driving = true;
+    }
+    else if (pos != lastPos)
+    {
+        for (int i = lastPos + 1; i <= pos; i++)
+        {
+            stepRoadWidth(i);
+            stepSprites(i);
+        }
+
+        updateRoadHorizon(pos);
+        updateRoadHeight(pos);
+        osprites->update_shadow_offset(oroad->tilemap_h_target);
+        copySpritePalData();
+        lastPos = pos;
+    }
+
+    oroad->road_pos = roadPos;
+    oroad->pos_fine = (pos * 10) + (((roadPos & 0xFFFF) * 10) >> 16);
+    oroad->tick();
+}
+
+// Compose the road and sprite layers into palette indices.
+// These are kept, so that palette changes only need resolve() to be re-run.
+//
+// When profiling, the pixel writes of the road and sprite hardware are counted too.
+void PreviewRenderer::compose(bool profile)
+{
+    composed = true;
+    composedOverdraw = profile;
+    selected.clear();
+    overdraw = OverdrawReport();
+
+    if (scene.end_pos <= 0)
+        return;
+
+    uint16_t* pix     = pixels;
+    uint8_t* counts   = profile ? writes : NULL;
+    const int count   = osprites->sprite_count;
+    osprite* entries  = osprites->sprite_entries;
+
+    // Each band is drawn in the same order as a whole frame, and only touches its own
+    // scanlines. So the result is identical however many bands there are.
+    QtConcurrent::blockingMap(bands, [=](ComposeBand& band)
+    {
+        uint16_t* bandPix = pix + (band.yStart * S16_WIDTH);
+        memset(bandPix, 0, (band.yEnd - band.yStart) * S16_WIDTH * sizeof(uint16_t));
+
+        int* areas = NULL;
+        if (counts != NULL)
+        {
+            memset(counts + (band.yStart * S16_WIDTH), 0, (band.yEnd - band.yStart) * S16_WIDTH * sizeof(uint8_t));
+            band.areas.fill(0, count);
+            areas = band.areas.data();
+        }
+
+        band.widths.fill(0, count);
+        hwroad->render_background(pix, band.yStart, band.yEnd, counts);
+        hwroad->render_foreground(pix, band.yStart, band.yEnd, counts);
+        hwsprites->render(8, entries, count, pix, band.yStart, band.yEnd, band.widths.data(), counts, areas);
+    });
+
+    for (int i = 0; i < count; i++)
+    {
+        osprite* spr = &entries[i];
+
+        // Sprite widths are only known after the render. Use the widest line of any band.
+        spr->width = 0;
+        foreach (const ComposeBand& band, bands)
+            spr->width = std::max(spr->width, band.widths.at(i));
+
+        // Selected scenery
+        if (!spr->is_hidden() && spr->selected)
+        {
+            int x = std::min(spr->get_screen_x1(), spr->get_screen_x2());
+            int y = std::min(spr->get_screen_y1(), spr->get_screen_y2());
+            selected.push_back(QRect(x + S16_X_OFF, y, spr->get_screen_width(), spr->get_screen_height()));
+        }
+
+        // Pixels written by this sprite, across all bands
+        if (profile)
+        {
+            SpriteArea sa;
+            sa.area = 0;
+            foreach (const ComposeBand& band, bands)
+                sa.area += band.areas.at(i);
+
+            if (sa.area > 0)
+            {
+                int x = std::min(spr->get_screen_x1(), spr->get_screen_x2());
+                int y = std::min(spr->get_screen_y1(), spr->get_screen_y2());
+                sa.bounds = QRect(x + S16_X_OFF, y, spr->get_screen_width(), spr->get_screen_height());
+                overdraw.top.push_back(sa);
+            }
+        }
+    }
+
+    if (profile)
+        reportOverdraw();
+}
+
+// Total the pixel writes of the last composed frame, and keep the largest sprites
+void PreviewRenderer::reportOverdraw()
+{
+    const uint8_t* count = writes;
+
+    for (int y = 0; y < S16_HEIGHT; y++)
+    {
+        int line = 0;
+        for (int x = 0; x < S16_WIDTH; x++)
+            line += *(count++);
+
+        overdraw.pixels += line;
+
+        if (line > overdraw.worstLinePixels)
+        {
+            overdraw.worstLine       = y;
+            overdraw.worstLinePixels = line;
+        }
+    }
+
+    std::sort(overdraw.top.begin(), overdraw.top.end(), [](const SpriteArea& a, const SpriteArea& b)
+    {
+        return a.area > b.area;
+    });
+
+    if (overdraw.top.size() > TOP_SPRITES)
+        overdraw.top.resize(TOP_SPRITES);
+
+    if (DEBUG)
+        std::cout << "overdraw pixels: " << overdraw.pixels << " worst line: " << overdraw.worstLine
+                  << " (" << overdraw.worstLinePixels << ")" << std::endl;
+}
+
+// Convert the composed palette indices to RGB.
+void PreviewRenderer::resolve(PreviewFrame* frame)
+{
+    frame->valid    = scene.end_pos > 0;
+    frame->selected = selected;
+    frame->overdraw = overdraw;
+
+    if (!frame->valid)
+        return;
+
+    // The preview widget may still hold the previous image. Start afresh rather than copy it.
+    if (!frame->image.isDetached())
+        frame->image = QImage(S16_WIDTH, S16_HEIGHT, QImage::Format_RGB32);
+
+    if (composedOverdraw)
+    {
+        resolveOverdraw(frame);
+        return;
+    }
+
+    uchar* bits = frame->image.bits();
+    const int pitch = frame->image.bytesPerLine();
+
+    // Lookup real RGB value from rgb array for backbuffer
+    QtConcurrent::blockingMap(bands, [=](ComposeBand& band)
+    {
+        const uint16_t* pix = pixels + (band.yStart * S16_WIDTH);
+
+        for (int y = band.yStart; y < band.yEnd; y++)
+        {
+            QRgb* line = (QRgb*) (bits + (y * pitch));
+
+            for (int x = 0; x < S16_WIDTH; x++)
+                line[x] = rgb[*(pix++) & ((S16_PALETTE_ENTRIES * 3) - 1)];
+        }
+    });
+}
+
+// Convert the pixel writes of the composed frame to a heatmap.
+void PreviewRenderer::resolveOverdraw(PreviewFrame* frame)
+{
+    uchar* bits = frame->image.bits();
+    const int pitch = frame->image.bytesPerLine();
+
+    QtConcurrent::blockingMap(bands, [=](ComposeBand& band)
+    {
+        const uint8_t* count = writes + (band.yStart * S16_WIDTH);
+
+        for (int y = band.yStart; y < band.yEnd; y++)
+        {
+            QRgb* line = (QRgb*) (bits + (y * pitch));
+
+            for (int x = 0; x < S16_WIDTH; x++)
+                line[x] = heat[*(count++)];
+        }
+    });
+}
+
+// Heatmap colour of each write count: black for pixels never written, then blue,
+// green, yellow, orange and red. Pixels written six or more times are white.
+void PreviewRenderer::setupHeatColours()
+{
+    const static int STEPS = 6;
+    const static QRgb STOPS[STEPS + 1] =
+    {
+        qRgb(0x00, 0x00, 0x00),
+        qRgb(0x10, 0x20, 0x90),
+        qRgb(0x10, 0xA0, 0x40),
+        qRgb(0xE0, 0xE0, 0x20),
+        qRgb(0xF0, 0x80, 0x10),
+        qRgb(0xE0, 0x10, 0x10),
+        qRgb(0xFF, 0xFF, 0xFF),
+    };
+
+    for (int i = 0; i < 0x100; i++)
+        heat[i] = STOPS[std::min(i, STEPS)];
+}
+
+// Swap Sprite RAM And Update Palette Data
+void PreviewRenderer::updateSprites(int posEnd)
+{
+    osprites->init(); // Clear all sprite entries
+    osprites->update_shadow_offset(oroad->tilemap_h_target);
+
+    // Find start Control Point to Iterate Back From
+    int startIndex = 0;
+    int posStart   = 0;
+    for (int i = scene.spriteP.size() - 1; i >= 0; i--)
+    {
+        ControlPoint cp = scene.spriteP.at(i);
+        if (cp.pos < posEnd - 64)
+        {
+            startIndex = i;
+            break;
+        }
+    }
+
+    // Then iterate from the previous point to that
+    startIndex -= 2;
+    if (startIndex < 0) startIndex = 0;
+
+    // If level is mapped to Stage 0, we need to render the startline
+    if (scene.startLine && posEnd < 42)
+    {
+        osprites->init_startline_sprites();
+        posStart = 0;
+    }
+    else if (startIndex < scene.spriteP.size())
+    {
+        posStart = scene.spriteP.at(startIndex).pos;
+    }
+
+    osprites->sprite_scroll_speed = 0;
+    spriteIndex = startIndex;
+    for (int i = posStart; i <= posEnd; i++)
+        stepSprites(i);
+
+    copySpritePalData();
+}
+
+// Tick the sprite engine for the next position
+void PreviewRenderer::stepSprites(int pos)
+{
+    const ControlPoint* cp = spriteIndex < scene.spriteP.size() ? &scene.spriteP.at(spriteIndex) : NULL;
+    osprites->tick(pos, cp);
+    osprites->sprite_copy();
+
+    if (cp != NULL && cp->pos <= pos)
+    {
+        spriteIndex++;
+    }
+}
+
+// To update the road width, we must iterate through the entire level until we get to the
+// relevant point.
+void PreviewRenderer::updateRoadWidth(int pos)
+{
+    resetRoadWidth();
+
+    // Iterate until current position
+    for (int i = 0; i <= pos; i++)
+        stepRoadWidth(i);
+}
+
+// Road Width at start of level
+void PreviewRenderer::resetRoadWidth()
+{
+    widthIndex  = 0;
+    widthTarget = 0;
+    widthChange = 0;
+    oroad->road_width = scene.startWidth << 16;
+    oroad->road_width_bak = oroad->road_width >> 16;
+}
+
+// Adjust the road width for the next position
+void PreviewRenderer::stepRoadWidth(int pos)
+{
+    if (widthIndex < scene.widthP.size())
+    {
+        ControlPoint widthPoint = scene.widthP.at(widthIndex);
+        if (pos == widthPoint.pos)
+        {
+            widthTarget = widthPoint.value1 << 16;
+            widthChange = widthPoint.value2;
+
+            if (widthTarget <= oroad->road_width)
+                widthChange = -widthChange;
+
+            widthIndex++;
+        }
+    }
+
+    if (widthChange)
+    {
+        oroad->road_width += (0xD0 * widthChange) << 4;
+        if (widthChange > 0)
+        {
+            if (oroad->road_width > widthTarget)
+            {
+                oroad->road_width = widthTarget;
+                widthChange = 0;
+            }
+        }
+        else if (widthChange < 0)
+        {
+            if (oroad->road_width < widthTarget)
+            {
+                oroad->road_width = widthTarget;
+                widthChange = 0;
+            }
+        }
+    }
+    oroad->road_width_bak = oroad->road_width >> 16;
+}
+
+// To set the correct horizon height we must parse all horizon heights until the current position.
+void PreviewRenderer::updateRoadHorizon(int pos)
+{
+    // Set Default Horizon Value at start of level
+    oroad->setHorizon(0x240 + horizonYOff);
+
+    foreach (ControlPoint cp, scene.heightP)
+    {
+        HeightSegment seg = scene.heightSections.at(cp.value1);
+
+        // Horizon Section
+        if (seg.type == 4)
+        {
+            // No need to process segments after the current position
+            // And if we're on a road horizon position at present, this needs
+            // to be updated by updateRoadHeight which is more granular
+            const double segLength = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
+
+            if (cp.pos + segLength > pos)
+                return;
+
+            oroad->setHorizon(seg.value1 + horizonYOff);
+        }
+    }
+}
+
+void PreviewRenderer::updateRoadHeight(int pos)
+{
+    // Find closest height segment
+    int index = -1;
+    foreach (ControlPoint cp, scene.heightP)
+    {
+        if (cp.pos <= pos)
+            index++;
+        else
+            break;
+    }
+
+    // Closest Height Segment Found
+    if (index != -1)
+    {
+        ControlPoint cp   = scene.heightP.at(index);
+        HeightSegment seg = scene.heightSections.at(cp.value1);
+
+        const int posInSeg = pos - cp.pos;         // Distance into height section
+
+        switch (seg.type)
+        {
+        // ----------------------------------------------------------------------------------------
+        // HEIGHTMAP TYPE 0: STANDARD ELEVATION
+        // ----------------------------------------------------------------------------------------
+        case 0:
+        {
+            double heightPos = 0;
+            int segmentIndex = 0;
+
+            // Store the position at which each height section actually starts
+            QList<double> heightLengths;
+            heightLengths.push_back(0);
+
+            // Iterate height map to calculate which segment we've reached
+            // segmentIndex will contain the correct segment within the heightmap
+            for (int i = segmentIndex; i < seg.data.size(); i++)
+            {
+                int16_t v = seg.data.at(i);
+
+                double segLength = 0;
+
+                if (v == 0)     segLength = POS_LENGTH / seg.step;
+                else if (v < 0) segLength = POS_LENGTH / (seg.step * seg.value1); // could be wrong way around
+                else if (v > 0) segLength = POS_LENGTH / (seg.step * seg.value2); // could be wrong way around
+
+                double increment = HEIGHT_LENGTH / segLength;
+
+                if (heightPos + increment <= posInSeg)
+                {
+                    segmentIndex++;
+                }
+                heightPos += increment;
+                heightLengths.push_back(heightPos);
+            }
+
+
+            if (segmentIndex < seg.data.size() - 5)
+            {
+                double currentLength = heightLengths.at(segmentIndex);
+
+                // Calculate length of segment we're in.
+                double segmentLength = heightLengths.at(segmentIndex + 1) - currentLength;
+
+                // Calculate distance into segment
+                double percentageIntoSegment = (posInSeg - heightLengths.at(segmentIndex)) / segmentLength;
+                int heightStart = (HEIGHT_LENGTH * percentageIntoSegment);
+
+                oroad->setHeightMap(cp.value1, segmentIndex, 0x100 + heightStart);
+            }
+            else
+            {
+                oroad->setHeightMap(0, 0, 0x100);
+            }
+        }
+        break;
+        // ----------------------------------------------------------------------------------------
+        // HEIGHTMAP TYPE 1: HOLD SECTION
+        // ----------------------------------------------------------------------------------------
+        case 1:
+        case 2:
+        {
+            const int delay = seg.value1;
+
+            // Position length of parts 1 and 2 of height section
+            const double segLength = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
+
+            // Position length of part 2 (the delayed section)
+            // Approximation only sadly, due to a bug in the OutRun code.
+            const double delayLength = delay / (POS_LENGTH / seg.step);
+            const double segLength2 = segLength + delayLength;
+
+            const double segLength3 = (segLength * 2) + delayLength;
+
+            // Part 1: This scales height start from 256 to 512
+            if (posInSeg < segLength)
+            {
+                double percentageIntoSegment = (segLength - posInSeg) / segLength;
+                int heightStart = HEIGHT_LENGTH - (HEIGHT_LENGTH * percentageIntoSegment);
+                oroad->setHeightMap(cp.value1, 0, 0x100 + heightStart, 0x100);
+            }
+            // Part 2: This scales delay down to zero
+            else if (posInSeg < segLength2)
+            {
+                double percentageIntoSegment = (segLength2 - posInSeg) / delayLength;
+                int newDelay = (delay * percentageIntoSegment);
+                oroad->setHeightMap(cp.value1, 1, 0x1FF, 0x100);
+                oroad->setDelay(newDelay);
+            }
+            // Part 3: This scales height start from 512 to 256
+            else if (posInSeg < segLength3)
+            {
+                double percentageIntoSegment = (segLength3 - posInSeg) / segLength;
+                int heightStart = (HEIGHT_LENGTH * percentageIntoSegment);
+                oroad->setHeightMap(cp.value1, 1, 0x100 + heightStart, 0x100);
+            }
+            else
+            {
+                oroad->setHeightMap(0, 0, 0x100);
+            }
+        }
+        break;
+        // ----------------------------------------------------------------------------------------
+        // HEIGHTMAP TYPE 3: MIXED HOLD SECTION
+        // ----------------------------------------------------------------------------------------
+        case 3:
+        {
+            const int delay = seg.value1;
+            const double delayLength = delay / (POS_LENGTH / seg.step);
+            const double endLength   = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
+
+            const double segLength  = HEIGHT_LENGTH / (POS_LENGTH / 4); // step is hard-coded to 4
+            const double segLength2 = (segLength * 6) + delayLength;
+            const double segLength3 = segLength2 + endLength;
+
+            // Part 1: Positions 1 to 5. This scales height start from 256 to 511
+            if (posInSeg < segLength * 6)
+            {
+                const int segmentIndex = posInSeg / segLength;
+                const int finePos = (segLength * (segmentIndex + 1)) - posInSeg;
+                const double percentageIntoSegment = (segLength - finePos) / segLength;
+                const int heightStart = (HEIGHT_LENGTH * percentageIntoSegment);
+                oroad->setHeightMap(cp.value1, segmentIndex, 0x100 + heightStart);
+            }
+            // Part 2: Hold on Entry 6
+            else if (posInSeg < segLength2)
+            {
+                double percentageIntoSegment = (segLength2 - posInSeg) / delayLength;
+                int newDelay = (delay * percentageIntoSegment);
+                oroad->setHeightMap(cp.value1, 6, 0x1FF, 0x100);
+                oroad->setDelay(newDelay);
+            }
+            // Part 3: This scales height start from 512 to 256
+            else if (posInSeg < segLength3)
+            {
+                double percentageIntoSegment = (segLength3 - posInSeg) / endLength;
+                int heightStart = (HEIGHT_LENGTH * percentageIntoSegment);
+                oroad->setHeightMap(cp.value1, 6, 0x100 + heightStart, 0x100);
+            }
+            else
+            {
+                oroad->setHeightMap(0, 0, 0x100);
+            }
+        }
+        break;
+        // ----------------------------------------------------------------------------------------
+        // CHANGE HORIZON
+        // ----------------------------------------------------------------------------------------
+        case 4:
+        {
+            const double segLength = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
+            int heightStart;
+            if (posInSeg < segLength)
+            {
+                double percentageIntoSegment = (segLength - posInSeg) / segLength;
+                heightStart = HEIGHT_LENGTH - (HEIGHT_LENGTH * percentageIntoSegment);
+            }
+            else
+            {
+                heightStart = 0xFF;
+            }
+            oroad->setHeightMap(cp.value1, 0, 0x100 + heightStart);
+            oroad->removeUserOffset(horizonYOff);
+            oroad->setHorizonMod(seg.value1 + horizonYOff);
+        }
+        break;
+
+        } // end switch
+
+    }
+    // No Height Segment Found
+    else
+    {
+        oroad->setHeightMap(0, 0, 0x100);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Palette Handling Code
+// ---------------------------------------------------------------------------
+
+void PreviewRenderer::writePal32(uint32_t* palAddr, const uint32_t data)
+{
+    uint32_t adr = *palAddr & 0x1fff;
+
+    palette[adr]   = (data >> 24) & 0xFF;
+    palette[adr+1] = (data >> 16) & 0xFF;
+    palette[adr+2] = (data >> 8) & 0xFF;
+    palette[adr+3] = data & 0xFF;
+
+    refresh_palette(adr);
+    refresh_palette(adr+2);
+
+    *palAddr += 4;
+}
+
+uint16_t PreviewRenderer::readPal16(uint32_t palAddr)
+{
+    uint32_t adr = palAddr & 0x1fff;
+    return (palette[adr] << 8) | palette[adr+1];
+}
+
+void PreviewRenderer::writePal32(uint32_t adr, const uint32_t data)
+{
+    adr &= 0x1fff;
+
+    palette[adr]   = (data >> 24) & 0xFF;
+    palette[adr+1] = (data >> 16) & 0xFF;
+    palette[adr+2] = (data >> 8) & 0xFF;
+    palette[adr+3] = data & 0xFF;
+    refresh_palette(adr);
+    refresh_palette(adr+2);
+}
+
+void PreviewRenderer::refresh_palette(uint32_t palAddr)
+{
+    palAddr &= ~1;
+    uint32_t rgbAddr = palAddr >> 1;
+    uint16_t a = (palette[palAddr] << 8) | palette[palAddr + 1];
+
+    rgb[rgbAddr] = s16Rgb(a);
+
+    // Create shadow / highlight colours at end of RGB array
+    rgb[rgbAddr + S16_PALETTE_ENTRIES] =
+    rgb[rgbAddr + (S16_PALETTE_ENTRIES * 2)] = s16RgbShadow(a);
+}
+
+// ------------------------------------------------------------------------------------------------
+// PALETTE CODE FOR SPRITES AND ROAD
+// ------------------------------------------------------------------------------------------------
+
+// Palette Data. Stored in blocks of 32 bytes.
+const uint32_t PAL_DATA = 0x14ED8;
+
+// Palette Ram: Sprite Entries Start Here
+static const uint32_t PAL_SPRITES = 0x121000;
+
+// Copy Sprite Palette Data To Palette RAM On Vertical Interrupt
+//
+// Source Address: 0x858E
+// Input:          Source address in rom of data format
+// Output:         None
+
+//
+// Blocks are converted from ROM once, and only copied if the palette RAM holds a different block.
+
+void PreviewRenderer::copySpritePalData()
+{
+    // Return if no palette entries to copy
+    if (osprites->pal_copy_count <= 0) return;
+
+    for (int16_t i = 0; i < osprites->pal_copy_count; i++)
+    {
+        uint8_t src = osprites->pal_addresses[(i * 2) + 0];
+        uint8_t dst = osprites->pal_addresses[(i * 2) + 1];
+
+        if (spritePalDst[dst] == src)
+            continue;
+
+        const SpritePalBlock* block = getSpritePalBlock(src);
+
+        // Move 28 Bytes to palette RAM
+        uint32_t adr     = (2 + PAL_SPRITES + (dst << 5)) & 0x1fff;
+        uint32_t rgbAddr = adr >> 1;
+
+        memcpy(&palette[adr], block->data, SPR_PAL_BYTES);
+        memcpy(&rgb[rgbAddr], block->rgb, sizeof(block->rgb));
+        memcpy(&rgb[rgbAddr + S16_PALETTE_ENTRIES], block->shadow, sizeof(block->shadow));
+        memcpy(&rgb[rgbAddr + (S16_PALETTE_ENTRIES * 2)], block->shadow, sizeof(block->shadow));
+
+        spritePalDst[dst] = src;
+    }
+    osprites->pal_copy_count = 0; // All entries copied
+}
+
+// Sprite palette block from ROM, converted on first use
+const PreviewRenderer::SpritePalBlock* PreviewRenderer::getSpritePalBlock(uint8_t src)
+{
+    SpritePalBlock* block = &spritePals[src];
+
+    if (!block->loaded)
+    {
+        // Palette Data Source Offset (aligned to start of 32 byte boundry, * 5)
+        uint32_t src_addr = 2 + PAL_DATA + (src << 5); // Source address in ROM
+
+        for (int i = 0; i < SPR_PAL_BYTES; i += 2)
+        {
+            uint16_t value = rom0->read16(src_addr + i);
+            block->data[i]     = value >> 8;
+            block->data[i + 1] = value & 0xFF;
+            block->rgb[i >> 1]    = s16Rgb(value);
+            block->shadow[i >> 1] = s16RgbShadow(value);
+        }
+        block->loaded = true;
+    }
+
+    return block;
+}
+
+void PreviewRenderer::setupRoadPalettes()
+{
+    setupSkyPalette();
+    setupGroundColor();
+    setupRoadCentre();
+    setupRoadStripes();
+    setupRoadSides();
+    setupRoadColour();
+}
+
+// Setup sky palette. Can be a shaded effect of 1F entries.
+// Source: 8CA4
+void PreviewRenderer::setupSkyPalette()
+{
+    // Address of sky palette information
+    uint32_t dst = 0x120F00; // palette ram
+    for (int16_t i = 0; i < LevelPalette::SKY_LENGTH; i++)
+        writePal32(&dst, scene.pal.sky[scene.skyPal][i]);
+}
+
+// Initalise Colour Of Road Sides
+// Source: 8ED2
+void PreviewRenderer::setupGroundColor()
+{
+    // Address of ground palette information
+    uint32_t dst_pal_ground1 = 0x120840; // palette ram: ground 1
+    uint32_t dst_pal_ground2 = 0x120860; // palette ram: ground 2
+
+    for (int16_t i = 0; i < LevelPalette::GND_LENGTH; i++)
+    {
+        uint32_t data = scene.pal.gnd[scene.gndPal][i];
+        writePal32(&dst_pal_ground1, data);
+        writePal32(&dst_pal_ground2, data);
+    }
+}
+
+void PreviewRenderer::setupRoadCentre()
+{
+    writePal32(0x12080C, scene.pal.road[scene.roadPal][LevelPalette::CENTRE1]); // Road 1 Colours
+    writePal32(0x12081C, scene.pal.road[scene.roadPal][LevelPalette::CENTRE2]); // Road 2 Colours
+}
+
+void PreviewRenderer::setupRoadStripes()
+{
+    writePal32(0x120804, scene.pal.road[scene.roadPal][LevelPalette::STRIPE1]); // Road 1 Colours
+    writePal32(0x120814, scene.pal.road[scene.roadPal][LevelPalette::STRIPE2]); // Road 2 Colours
+}
+
+void PreviewRenderer::setupRoadSides()
+{
+    writePal32(0x120808, scene.pal.road[scene.roadPal][LevelPalette::SIDE1]);  // Road 1 Colours
+    writePal32(0x120818, scene.pal.road[scene.roadPal][LevelPalette::SIDE2]);  // Road 2 Colours
+}
+
+void PreviewRenderer::setupRoadColour()
+{
+    writePal32(0x120800, scene.pal.road[scene.roadPal][LevelPalette::ROAD1]);  // Road 1 Colours
+    writePal32(0x120810, scene.pal.road[scene.roadPal][LevelPalette::ROAD2]);  // Road 2 Colours
+}
@@ -0,0 +1,284 @@
+/***************************************************************************
+    Preview Renderer.
+
+    Runs the OutRun road and sprite engine for the S16 Preview.
+
+    This lives on a dedicated worker thread, so the editor never waits for
+    a frame to be drawn. Frames are rendered into a pair of buffers, so the
+    preview widget can present the last completed frame whilst the next
+    one is being rendered.
+
+    Each frame is composed as horizontal bands, which are rendered
+    concurrently.
+
+    Frames can instead show the overdraw of the scene: the number of times
+    each pixel is written by the road and sprite hardware.
+
+    Whilst driving, the engine is advanced from the previous frame as the
+    game does, rather than being replayed to the requested position.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <QVector>
+#include <QPoint>
+#include <QRect>
+#include <QSharedPointer>
+#include <QAtomicInt>
+
+#include "../globals.hpp"
+#include "../controlpoint.hpp"
+#include "../levels/levelpalette.hpp"
+#include "../height/heightformat.hpp"
+#include "../sprites/spriteformat.hpp"
+#include "spritepatterns.hpp"
+
+class HWRoad;
+class HWSprites;
+class ORoad;
+class OSprites;
+class RomLoader;
+
+// Snapshot of the level data used to render the preview.
+// Taken on the GUI thread, so the level can be edited whilst a frame renders.
+struct PreviewScene
+{
+    QVector<QPoint> path;                     // Road path (up to end_pos)
+    int end_pos;
+    int startWidth;
+    bool startLine;                           // Level contains the start line
+    QList<ControlPoint> widthP;
+    QList<ControlPoint> spriteP;
+    QList<ControlPoint> heightP;
+    QList<HeightSegment> heightSections;
+    QSharedPointer<const SpritePatterns> spritePatterns; // Shared until the patterns are edited
+    LevelPalette pal;
+    uint16_t skyPal;
+    uint16_t gndPal;
+    uint16_t roadPal;
+};
+
+// Identifies the contents of a frame.
+// The generations change whenever the level data or palette snapshot changes.
+struct PreviewKey
+{
+    int sceneGen;
+    int paletteGen;
+    int pos;
+    int cameraX;
+    int cameraY;
+    bool overdraw;            // Show overdraw, rather than the scene
+
+    PreviewKey() : sceneGen(0), paletteGen(0), pos(0), cameraX(0), cameraY(0), overdraw(false) {}
+
+    bool operator==(const PreviewKey& k) const
+    {
+        return pos == k.pos && cameraX == k.cameraX && cameraY == k.cameraY &&
+               sceneGen == k.sceneGen && paletteGen == k.paletteGen && overdraw == k.overdraw;
+    }
+};
+
+// Request to render a frame.
+// Pending requests are merged, so that only the latest state is ever rendered.
+struct PreviewRequest
+{
+    PreviewKey key;
+    int stages;                                // Pipeline stages to re-run
+    bool reset;                                // Reset road & sprite engine
+    bool drive;                                // Advance the engine from the previous frame
+    uint32_t roadPos;                          // Road position whilst driving (16.16)
+    QSharedPointer<const PreviewScene> scene;  // New level data, or NULL if unchanged
+
+    PreviewRequest() : stages(0), reset(false), drive(false), roadPos(0) {}
+};
+
+Q_DECLARE_METATYPE(PreviewRequest)
+
+// Hardware sprite load at a road position
+struct SpriteLoad
+{
+    uint8_t sprites;          // Sprite entries sent to the hardware
+    uint8_t shadows;          // Shadow entries sent to the hardware
+    uint8_t dropped;          // Sprites and shadows dropped as the tables were full
+};
+
+// Sprite drawn to a frame, and the pixels it wrote
+struct SpriteArea
+{
+    int area;
+    QRect bounds;             // Screen co-ordinates
+};
+
+// Pixels written by the hardware to compose a frame
+struct OverdrawReport
+{
+    int pixels;               // Writes by the road and sprites
+    int worstLine;            // Scanline with the most writes
+    int worstLinePixels;      // Writes to that scanline
+    QVector<SpriteArea> top;  // Sprites that wrote the most pixels, largest first
+
+    OverdrawReport() : pixels(0), worstLine(0), worstLinePixels(0) {}
+};
+
+// Completed Frame
+struct PreviewFrame
+{
+    PreviewKey key;           // Request this frame was rendered for
+    QImage image;             // Final RGB image
+    QVector<QRect> selected;  // Selected scenery (screen co-ordinates)
+    OverdrawReport overdraw;  // Only when the key requests overdraw
+    bool valid;               // Level contained road to render
+    bool driven;              // Advanced from the previous frame whilst driving
+    int renderTime;           // Time taken to render the frame (microseconds)
+};
+
+class PreviewRenderer;
+
+// Renderers for the preview, and for measuring the level in the background.
+// Each decodes the graphics ROMs when it is created, so they are created together
+// off the GUI thread when the ROMs are loaded.
+struct PreviewRenderers
+{
+    PreviewRenderer* preview;
+    PreviewRenderer* budget;
+    PreviewRenderer* profiler;
+
+    PreviewRenderers() : preview(NULL), budget(NULL), profiler(NULL) {}
+};
+
+class PreviewRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Preview pipeline stages.
+    // Only the stages whose inputs have changed need to be re-run.
+    //
+    // Path              -> road_x
+    // Heights + Horizon -> road_y
+    // Camera            -> hscroll
+    // Scenery           -> sprite list
+    // Palette           -> RGB
+    enum
+    {
+        STAGE_ROAD_X  = 0x01,
+        STAGE_ROAD_Y  = 0x02,
+        STAGE_CAMERA  = 0x04,
+        STAGE_SPRITES = 0x08,
+        STAGE_PALETTE = 0x10,
+        STAGE_ALL     = 0x1F
+    };
+
+    PreviewRenderer(RomLoader* rom0, RomLoader* sprites, RomLoader* rom1, RomLoader* roadRom);
+    ~PreviewRenderer();
+    const PreviewFrame* getFrame(int index) const;
+    QVector<SpriteLoad> measureSprites(const PreviewScene& scene, const QAtomicInt* cancel);
+    QVector<OverdrawReport> measureOverdraw(const PreviewScene& scene, const QAtomicInt* cancel, QAtomicInt* progress);
+
+signals:
+    void frameReady(int index);
+
+public slots:
+    void render(PreviewRequest request);
+
+private:
+    const static bool DEBUG = false;
+
+    const static int TOP_SPRITES = 5;          // Sprites listed by the overdraw report
+    const static int MAX_DRIVE_STEP = 64;      // Positions stepped in a frame before the drive is restarted
+
+    PreviewScene scene;
+
+    HWRoad* hwroad;
+    HWSprites* hwsprites;
+    ORoad*  oroad;
+    OSprites* osprites;
+    RomLoader* rom0;
+
+    PreviewFrame frames[2];
+    int backFrame;            // Frame currently being rendered
+
+    // Horizontal band of the frame
+    struct ComposeBand
+    {
+        int yStart, yEnd;       // Scanlines covered
+        QVector<int> widths;    // Sprite widths drawn within band
+        QVector<int> areas;     // Sprite pixels written within band (overdraw only)
+    };
+
+    const static int MAX_BANDS = 8;
+    QVector<ComposeBand> bands;
+
+    uint16_t* pixels;         // Palette indices of the last composed frame (13-bit, with shadow)
+    QVector<QRect> selected;  // Selected scenery of the last composed frame
+    bool composed;            // Palette indices are up to date
+
+    uint8_t* writes;          // Pixel writes of the last composed frame (overdraw only)
+    OverdrawReport overdraw;  // Report of the last composed frame (overdraw only)
+    bool composedOverdraw;    // Last frame was composed with writes counted
+    QRgb heat[0x100];         // Colour for each write count
+
+    int lastPos;
+    int horizonYOff;
+    bool driving;             // Engine state follows on from the last driven frame
+
+    int widthIndex;           // Next road width control point
+    int widthTarget;          // Road width being adjusted to
+    int widthChange;          // Road width adjustment speed
+    int spriteIndex;          // Next scenery control point
+
+    uint8_t palette[S16_PALETTE_ENTRIES * 2]; // 2 Bytes Per Palette Entry
+    QRgb rgb[S16_PALETTE_ENTRIES * 3];        // Extended to hold shadow/hilight colours
+
+    const static int SPR_PAL_BLOCKS = 0x100;  // Sprite palettes in ROM
+    const static int SPR_PAL_DST    = 0x80;   // Sprite palettes in palette RAM
+    const static int SPR_PAL_BYTES  = 28;     // Bytes copied per palette
+
+    // Sprite palette block, converted from ROM
+    struct SpritePalBlock
+    {
+        bool loaded;
+        uint8_t data[SPR_PAL_BYTES];
+        QRgb rgb[SPR_PAL_BYTES / 2];
+        QRgb shadow[SPR_PAL_BYTES / 2];
+    };
+
+    SpritePalBlock spritePals[SPR_PAL_BLOCKS];
+    int16_t spritePalDst[SPR_PAL_DST];        // Block held by each palette RAM entry (or -1)
+
+    void init();
+    void setScene(const PreviewScene& scene);
+    void simulate(int pos, int stages);
+    void drive(uint32_t roadPos, int stages);
+    void compose(bool profile = false);
+    void reportOverdraw();
+    void resolve(PreviewFrame* frame);
+    void resolveOverdraw(PreviewFrame* frame);
+    void setupHeatColours();
+    void updateSprites(int posEnd);
+    void stepSprites(int pos);
+    void updateRoadWidth(int);
+    void resetRoadWidth();
+    void stepRoadWidth(int pos);
+    void updateRoadHorizon(int);
+    void updateRoadHeight(int);
+    void copySpritePalData();
+    const SpritePalBlock* getSpritePalBlock(uint8_t src);
+    uint16_t readPal16(uint32_t);
+    void writePal32(uint32_t*, const uint32_t);
+    void writePal32(uint32_t, const uint32_t);
+    void refresh_palette(uint32_t);
+    void setupRoadPalettes();
+    void setupSkyPalette();
+    void setupGroundColor();
+    void setupRoadCentre();
+    void setupRoadStripes();
+    void setupRoadSides();
+    void setupRoadColour();
+};
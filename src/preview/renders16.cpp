@@ -8,98 +8,198 @@
 
     The original engine would have to iterate from position 0;
 
+    Frames are rendered by a PreviewRenderer on a worker thread. Requests
+    made whilst a frame is in progress are merged, and this widget simply
+    presents the latest completed frame.
+
+    Completed frames are cached. When the renderer is idle after scrubbing,
+    the neighbouring positions are rendered ahead of time in the direction
+    of travel.
+
+    In overdraw mode, frames show the pixels written by the hardware, with
+    a report of the worst scanline and the largest sprites.
+
+    In drive mode, a timer at the display refresh rate advances the road
+    position by the time elapsed, so the speed holds even when frames are
+    dropped. Each frame is advanced by the renderer from the last.
+
+    The presented frame is scaled to the widget once, and kept until the
+    frame or widget size changes. Overlays are drawn over it separately.
+
     Copyright Chris White.
     See license.txt for more details.
 ***************************************************************************/
 
-#include <iostream>
+#include <string.h>
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWindow>
 #include <QPainter>
+#include <QPaintEvent>
 #include <QMouseEvent>
 #include <QWheelEvent>
+#include <QThread>
+#include <QTimer>
 
-#include "../import/romloader.hpp"
 #include "../leveldata.hpp"
 #include "../levels/levels.hpp"
-#include "hwroad.hpp"
-#include "hwsprites.hpp"
-#include "oroad.hpp"
-#include "osprites.hpp"
+#include "spritebudget.hpp"
+#include "overdrawprofiler.hpp"
 #include "renders16.hpp"
 
-const static double POS_LENGTH = 10 * 12;  // Length of each segment
-
 RenderS16::RenderS16(QWidget *parent) :
-    QWidget(parent)
-{
-    rom0      = NULL;
-    screen    = new QImage(S16_WIDTH, S16_HEIGHT, QImage::Format_RGB32);
-    hwroad    = new HWRoad();
-    hwsprites = new HWSprites(this);
-    oroad     = NULL;
-    osprites  = NULL;
-    pixels    = new uint32_t[S16_WIDTH * S16_HEIGHT];
-
-    for (int i = 0; i < S16_WIDTH * S16_HEIGHT; i++)
-        pixels[i] = 0;
-
+    QWidget(parent),
+    cache(CACHE_FRAMES)
+{
+    levels         = NULL;
+    changes        = NULL;
+    heightSections = NULL;
+    spriteSections = NULL;
+    renderThread   = NULL;
+    renderer       = NULL;
+    rendering      = false;
+    presentedDirty = true;
+    sceneGen       = 0;
+    paletteGen     = 0;
+    scrubDir       = 0;
+    patternStages  = 0;
+    selectionStages = 0;
+
+    for (int i = 0; i < LevelChanges::ASPECTS; i++)
+        sceneChanges[i] = 0;
+
+    mousePress    = 0;
+    lastPos       = 0;
+    cameraX       = 0;
+    horizonYOff   = 0;
     guideLines    = GUIDES_OFF;
     sceneryGuides = false;
+    overdraw      = false;
+    driving       = false;
+    drivePos      = 0;
+    driveLast     = 0;
+    driveNext     = 0;
+    shownPeriod   = 0;
+
+    profiler    = new OverdrawProfiler(this);
+    budget      = new SpriteBudget(this);
+    budgetTimer = new QTimer(this);
+    budgetTimer->setSingleShot(true);
+    budgetTimer->setInterval(BUDGET_DELAY);
+    connect(budgetTimer, SIGNAL(timeout()), this, SLOT(analyseSprites()));
+
+    driveTimer = new QTimer(this);
+    driveTimer->setTimerType(Qt::PreciseTimer);
+    driveTimer->setSingleShot(true);
+    connect(driveTimer, SIGNAL(timeout()), this, SLOT(driveTick()));
+
+    qRegisterMetaType<PreviewRequest>("PreviewRequest");
 }
 
 RenderS16::~RenderS16()
 {
-    delete screen;
-    delete hwroad;
-    delete hwsprites;
-    if (oroad != NULL)
-        delete oroad;
-    if (osprites != NULL)
-        delete osprites;
+    // Waits for any measurement in progress
+    delete budget;
+    delete profiler;
+
+    if (renderThread != NULL)
+    {
+        renderThread->quit();
+        renderThread->wait();
+    }
 
-    delete pixels;
+    if (renderer != NULL)
+        delete renderer;
 }
 
+// Takes ownership of the renderers. The preview is blank if they are NULL, which releases
+// the ROMs used by the previous renderers.
 void RenderS16::setData(Levels *levels, QList<HeightSegment>* heightSections, QList<SpriteSectionEntry>* spriteSections,
-                        RomLoader* rom0, RomLoader *sprites, RomLoader *rom1, RomLoader *roadRom)
+                        PreviewRenderers renderers)
 {
     this->levels         = levels;
     this->heightSections = heightSections;
-    this->rom0           = rom0;
+    this->spriteSections = spriteSections;
+    this->changes        = levels != NULL ? levels->getChanges() : NULL;
+
+    if (changes != NULL)
+    {
+        connect(changes, SIGNAL(heightPatternChanged(int)),  this, SLOT(heightPatternChanged(int)),  Qt::UniqueConnection);
+        connect(changes, SIGNAL(sceneryPatternChanged(int)), this, SLOT(sceneryPatternChanged(int)), Qt::UniqueConnection);
+        connect(changes, SIGNAL(scenerySelectionChanged(int)), this, SLOT(scenerySelectionChanged(int)), Qt::UniqueConnection);
+    }
 
-    hwroad->init(roadRom->rom);
-    oroad  = new ORoad(heightSections, hwroad, rom1);
-    hwsprites->init(sprites->rom);
-    osprites = new OSprites(hwsprites, spriteSections, oroad, rom0);
+    // Shutdown existing renderer & discard any frames it has queued
+    if (renderThread != NULL)
+    {
+        renderThread->quit();
+        renderThread->wait();
+        delete renderer;
+        renderer = NULL;
+        QCoreApplication::removePostedEvents(this, QEvent::MetaCall);
+    }
+    else
+    {
+        renderThread = new QThread(this);
+    }
+
+    // New renderer needs a fresh snapshot. Cached frames may be from different roms.
+    setCurrent(CachedFrame());
+    rendering = false;
+    scene.clear();
+    cache.clear();
+    budget->setRenderer(renderers.budget);
+    profiler->setRenderer(renderers.profiler);
+    renderer  = renderers.preview;
+
+    if (renderer != NULL)
+    {
+        renderer->moveToThread(renderThread);
+
+        connect(this,     SIGNAL(requestFrame(PreviewRequest)), renderer, SLOT(render(PreviewRequest)));
+        connect(renderer, SIGNAL(frameReady(int)),              this,     SLOT(presentFrame(int)));
+
+        renderThread->start();
+    }
 
     init();
+    update();
 }
 
 void RenderS16::init()
 {
-    oroad->init();
-    oroad->road_width = levelData->startWidth << 16;
-    oroad->road_width_bak = oroad->road_width >> 16;
-
-    osprites->init();
+    setDrive(false);
 
     mousePress   = 0;
+    cameraX      = 0;
     horizonYOff  = 0;
     lastPos      = 0;
 
-    setCameraX();
-    setCameraY();
+    // The level may have been replaced entirely
+    scene.clear();
+    budget->clear();
+
+    pending.reset = true;
+    redraw(lastPos, PreviewRenderer::STAGE_ALL, true);
 }
 
 void RenderS16::setCameraX(int x)
 {
-    oroad->car_x_bak = x;
-    redrawPos();
+    if (x == cameraX)
+        return;
+
+    cameraX = x;
+    redraw(lastPos, PreviewRenderer::STAGE_CAMERA);
 }
 
 void RenderS16::setCameraY(int y)
 {
+    if (y == horizonYOff)
+        return;
+
     horizonYOff = y;
-    redrawPos();
+    redraw(lastPos, PreviewRenderer::STAGE_ROAD_Y);
 }
 
 void RenderS16::setGuidelines(int guideLines)
@@ -114,624 +214,667 @@ void RenderS16::setSceneryGuides(bool enabled)
     update();
 }
 
-void RenderS16::redrawPos()
+// The composed frame only needs to be resolved again, although the renderer composes it
+// again to count the pixel writes.
+void RenderS16::setOverdraw(bool enabled)
 {
-    setRoadPos(lastPos);
+    if (enabled == overdraw)
+        return;
+
+    overdraw = enabled;
+    redraw(lastPos, PreviewRenderer::STAGE_PALETTE);
 }
 
-void RenderS16::setRoadPos(int pos)
+// Drive through the level from the current position
+void RenderS16::setDrive(bool enabled)
 {
-    // Check valid position
-    if (pos != -1 && pos < levelData->end_pos)
+    // Nothing to drive until the roms and level are loaded
+    if (enabled && (renderer == NULL || levels == NULL))
+        enabled = false;
+
+    if (enabled == driving)
+    {
+        emit driveChanged(driving);
+        return;
+    }
+
+    driving = enabled;
+
+    if (driving)
+    {
+        drivePos    = lastPos << 16;
+        scrubDir    = 0;
+        driveStats  = DriveStats();
+        shownStats  = DriveStats();
+        shownPeriod = 0;
+        driveClock.start();
+        statsClock.start();
+        driveLast = 0;
+        driveNext = refreshPeriod() * 1000.0;
+        scheduleTick();
+    }
+    else
     {
-        if (levelData->end_pos > 0)
+        driveTimer->stop();
+
+        // The renderer is part way through a position, so the frame must be simulated again.
+        // A cached frame would leave the renderer in its driven state.
+        if (levels != NULL)
         {
-            if (DEBUG) std::cout << "tick road pos " << std::endl;
-            // Scroll road surface
-            if (pos > lastPos)
-                oroad->pos_fine += 10;
-            else if (pos < lastPos)
-                oroad->pos_fine -= 10;
-
-            lastPos = pos;
-
-            oroad->road_pos = pos << 16;
-            updateRoadWidth(pos);
-            updateRoadHorizon(pos);
-            updateRoadHeight(pos);
-            oroad->tick();
-            oroad->tick();
-            oroad->tick();
-            oroad->tick();
-            updateSprites(pos);
+            pending.stages |= PreviewRenderer::STAGE_ROAD_X | updateScene();
+            pending.key     = currentKey();
+            scrubDir        = 0;
+            dispatch();
         }
     }
 
-    update();
+    emit driveChanged(driving);
+}
+
+// Profile the whole level, using the latest level data
+void RenderS16::profileOverdraw()
+{
+    if (levels == NULL)
+        return;
+
+    redraw(lastPos, 0, true);
+    profiler->profile(scene);
+}
+
+void RenderS16::setupRoadPalettes()
+{
+    redraw(lastPos, 0, true);
 }
 
-// Swap Sprite RAM And Update Palette Data
-void RenderS16::updateSprites(int posEnd)
+void RenderS16::redrawPos()
 {
-    osprites->init(); // Clear all sprite entries
-    osprites->update_shadow_offset(oroad->tilemap_h_target);
+    setRoadPos(lastPos);
+}
 
-    // Find start Control Point to Iterate Back From
-    int startIndex = 0;
-    int posStart   = 0;
-    for (int i = levelData->spriteP.size() - 1; i >= 0; i--)
+// Only the stages affected by the position, or by edits to the level data, are re-run
+void RenderS16::setRoadPos(int pos)
+{
+    // Positions reported whilst driving are ignored. Others move the car.
+    if (driving)
     {
-        ControlPoint cp = levelData->spriteP.at(i);
-        if (cp.pos < posEnd - 64)
-        {
-            startIndex = i;
-            break;
-        }
+        if (pos != lastPos)
+            drivePos = pos << 16;
+        return;
     }
 
-    // Then iterate from the previous point to that
-    startIndex -= 2;
-    if (startIndex < 0) startIndex = 0;
+    redraw(pos, 0, true);
+}
 
-    // If level is mapped to Stage 0, we need to render the startline
-    if (levels->levelContainsStartLine() && posEnd < 42)
+// ------------------------------------------------------------------------------------------------
+// Render Scheduling
+// ------------------------------------------------------------------------------------------------
+
+// Request the renderer re-runs the specified pipeline stages.
+// If a frame is already in progress, this is merged with any other pending requests.
+void RenderS16::redraw(int pos, int stages, bool newScene)
+{
+    if (levels == NULL)
+        return;
+
+    // Check valid position
+    if (pos != -1 && pos < levels->getActiveLevelP()->end_pos && pos != lastPos)
     {
-        osprites->init_startline_sprites();
-        posStart = 0;
+        scrubDir = pos > lastPos ? 1 : -1;
+        lastPos  = pos;
+        stages  |= PreviewRenderer::STAGE_ROAD_X;
     }
-    else if (startIndex < levelData->spriteP.size())
+    // Only prefetch whilst scrubbing. Otherwise the renderer would lose the camera state.
+    else
     {
-        posStart = levelData->spriteP.at(startIndex).pos;
+        scrubDir = 0;
     }
 
-    osprites->sprite_scroll_speed = 0;
-    for (int i = posStart; i <= posEnd; i++)
-    {
-        const ControlPoint* cp = startIndex < levelData->spriteP.size() ? &levelData->spriteP.at(startIndex) : NULL;
-        osprites->tick(i, cp);
-        osprites->sprite_copy();
+    if (newScene)
+        stages |= updateScene();
 
-        if (cp != NULL && cp->pos <= i)
-        {
-            startIndex++;
-        }
+    pending.key     = currentKey();
+    pending.stages |= stages;
+
+    // Frame already rendered. The renderer state is left alone, as the next request carries everything it needs.
+    // Whilst driving, the next drive frame is always rendered.
+    CachedFrame cached;
+    if (!driving && cache.find(pending.key, &cached))
+    {
+        pending.stages = 0;
+        setCurrent(cached);
+        reportStats("cached");
     }
-    copySpritePalData();
+
+    dispatch();
 }
 
-// To update the road width, we must iterate through the entire level until we get to the
-// relevant point.
-void RenderS16::updateRoadWidth(int pos)
+void RenderS16::dispatch()
 {
-    int cpIndex   = 0;
-    int width     = 0;                              // Segment road width
-    int change    = 0;                              // Segment adjustment speed
-    oroad->road_width = levelData->startWidth << 16; // Road Width at start of level
+    // Roms not loaded yet, or waiting on frame.
+    // Whilst driving, requests are sent with the next drive frame.
+    if (renderer == NULL || rendering || driving)
+        return;
 
-    // Iterate until current position
-    for (int i = 0; i <= pos; i++)
+    if (pending.stages == 0 && !pending.reset)
     {
-        if (cpIndex < levelData->widthP.size())
-        {
-            ControlPoint widthPoint = levelData->widthP.at(cpIndex);
-            if (i == widthPoint.pos)
-            {
-                width  = widthPoint.value1 << 16;
-                change = widthPoint.value2;
-
-                if (width <= oroad->road_width)
-                    change = -change;
+        prefetch();
+        return;
+    }
 
-                cpIndex++;
-            }
-        }
+    rendering = true;
+    emit requestFrame(pending);
 
-        if (change)
-        {
-            oroad->road_width += (0xD0 * change) << 4;
-            if (change > 0)
-            {
-                if (oroad->road_width > width)
-                {
-                    oroad->road_width = width;
-                    change = 0;
-                }
-            }
-            else if (change < 0)
-            {
-                if (oroad->road_width < width)
-                {
-                    oroad->road_width = width;
-                    change = 0;
-                }
-            }
-        }
-    }
-    oroad->road_width_bak = oroad->road_width >> 16;
+    pending.stages = 0;
+    pending.reset  = false;
+    pending.scene.clear();
 }
 
-// To set the correct horizon height we must parse all horizon heights until the current position.
-void RenderS16::updateRoadHorizon(int pos)
+// Render the next neighbouring position that isn't already cached
+void RenderS16::prefetch()
 {
-    // Set Default Horizon Value at start of level
-    oroad->setHorizon(0x240 + horizonYOff);
+    if (scrubDir == 0 || !current.valid || scene.isNull())
+        return;
+
+    PreviewKey key = currentKey();
 
-    foreach (ControlPoint cp, levelData->heightP)
+    for (int i = 1; i <= PREFETCH_AHEAD + PREFETCH_BEHIND; i++)
     {
-        HeightSegment seg = heightSections->at(cp.value1);
+        const int offset = i <= PREFETCH_AHEAD ? i : PREFETCH_AHEAD - i;
+        key.pos = lastPos + (offset * scrubDir);
 
-        // Horizon Section
-        if (seg.type == 4)
-        {
-            // No need to process segments after the current position
-            // And if we're on a road horizon position at present, this needs
-            // to be updated by updateRoadHeight which is more granular
-            const double segLength = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
+        if (key.pos < 0 || key.pos >= scene->end_pos || cache.contains(key))
+            continue;
 
-            if (cp.pos + segLength > pos)
-                return;
+        PreviewRequest request;
+        request.key    = key;
+        request.stages = PreviewRenderer::STAGE_ROAD_X;
 
-            oroad->setHorizon(seg.value1 + horizonYOff);
-        }
+        rendering = true;
+        emit requestFrame(request);
+        return;
     }
 }
 
-void RenderS16::updateRoadHeight(int pos)
+void RenderS16::presentFrame(int index)
 {
-    // Find closest height segment
-    int index = -1;
-    foreach (ControlPoint cp, levelData->heightP)
+    const PreviewFrame* frame = renderer->getFrame(index);
+    rendering = false;
+
+    CachedFrame completed;
+    completed.key      = frame->key;
+    completed.image    = frame->image;
+    completed.selected = frame->selected;
+    completed.overdraw = frame->overdraw;
+    completed.valid    = frame->valid;
+
+    if (frame->driven)
     {
-        if (cp.pos <= pos)
-            index++;
-        else
-            break;
+        driveStats.frames++;
+        driveStats.renderTotal += frame->renderTime;
+        driveStats.renderMax    = qMax(driveStats.renderMax, frame->renderTime);
     }
-
-    // Closest Height Segment Found
-    if (index != -1)
+    // Driven frames are part way through a position
+    else
     {
-        ControlPoint cp   = levelData->heightP.at(index);
-        HeightSegment seg = heightSections->at(cp.value1);
+        if (completed.valid)
+            cache.insert(completed);
 
-        const int posInSeg = pos - cp.pos;         // Distance into height section
+        reportStats(QString("%1 ms").arg(frame->renderTime / 1000.0, 0, 'f', 1));
+    }
 
-        switch (seg.type)
-        {
-        // ----------------------------------------------------------------------------------------
-        // HEIGHTMAP TYPE 0: STANDARD ELEVATION
-        // ----------------------------------------------------------------------------------------
-        case 0:
-        {
-            double heightPos = 0;
-            int segmentIndex = 0;
+    // Prefetched frames, or frames that have since been superseded, are only cached
+    if (completed.key == currentKey())
+        setCurrent(completed);
 
-            // Store the position at which each height section actually starts
-            QList<double> heightLengths;
-            heightLengths.push_back(0);
+    dispatch();
+}
 
-            // Iterate height map to calculate which segment we've reached
-            // segmentIndex will contain the correct segment within the heightmap
-            for (int i = segmentIndex; i < seg.data.size(); i++)
-            {
-                int16_t v = seg.data.at(i);
+// Show the time taken for the last frame, and how well the frame cache is doing
+void RenderS16::reportStats(const QString& frameTime)
+{
+    emit statsChanged(QString("Preview: %1 | Cache: %2/%3 frames, %4 hits, %5 misses, %6 evictions")
+                          .arg(frameTime)
+                          .arg(cache.size())
+                          .arg(CACHE_FRAMES)
+                          .arg(cache.getHits())
+                          .arg(cache.getMisses())
+                          .arg(cache.getEvictions()));
+}
 
-                double segLength = 0;
+// Advance the road position by the time elapsed, and request the next frame
+void RenderS16::driveTick()
+{
+    const qint64 now     = driveClock.nsecsElapsed();
+    const qint64 elapsed = now - driveLast;
+    driveLast = now;
 
-                if (v == 0)     segLength = POS_LENGTH / seg.step;
-                else if (v < 0) segLength = POS_LENGTH / (seg.step * seg.value1); // could be wrong way around
-                else if (v > 0) segLength = POS_LENGTH / (seg.step * seg.value2); // could be wrong way around
+    // Target the next refresh. Refreshes missed entirely are skipped, rather than caught up.
+    const double period = refreshPeriod() * 1000.0;
+    driveNext += period;
+    if (driveNext < now)
+        driveNext = now + period;
+    scheduleTick();
 
-                double increment = HEIGHT_LENGTH / segLength;
+    // Measure the statistics shown over the last period
+    if (statsClock.elapsed() >= DRIVE_STATS)
+    {
+        shownStats  = driveStats;
+        shownPeriod = statsClock.restart();
+        driveStats  = DriveStats();
+        update();
+    }
 
-                if (heightPos + increment <= posInSeg)
-                {
-                    segmentIndex++;
-                }
-                heightPos += increment;
-                heightLengths.push_back(heightPos);
-            }
+    drivePos += (uint32_t) ((elapsed * DRIVE_FINE_STEP * DRIVE_GAME_FPS * 0x10000) / (FINE_PER_POS * 1000000000LL));
 
+    // Stop at the end of the level
+    const int pos = drivePos >> 16;
+    if (pos >= levels->getActiveLevelP()->end_pos)
+    {
+        setDrive(false);
+        return;
+    }
 
-            if (segmentIndex < seg.data.size() - 5)
-            {
-                double currentLength = heightLengths.at(segmentIndex);
+    // Previous frame still rendering
+    if (rendering)
+    {
+        driveStats.dropped++;
+        return;
+    }
 
-                // Calculate length of segment we're in.
-                double segmentLength = heightLengths.at(segmentIndex + 1) - currentLength;
+    if (pos != lastPos)
+    {
+        lastPos = pos;
+        emit sendNewPosition(pos);
+    }
 
-                // Calculate distance into segment
-                double percentageIntoSegment = (posInSeg - heightLengths.at(segmentIndex)) / segmentLength;
-                int heightStart = (HEIGHT_LENGTH * percentageIntoSegment);
+    pending.stages |= updateScene();
+    pending.key     = currentKey();
+    pending.drive   = true;
+    pending.roadPos = drivePos;
 
-                oroad->setHeightMap(cp.value1, segmentIndex, 0x100 + heightStart);
-            }
-            else
-            {
-                oroad->setHeightMap(0, 0, 0x100);
-            }
-        }
-        break;
-        // ----------------------------------------------------------------------------------------
-        // HEIGHTMAP TYPE 1: HOLD SECTION
-        // ----------------------------------------------------------------------------------------
-        case 1:
-        case 2:
-        {
-            const int delay = seg.value1;
-
-            // Position length of parts 1 and 2 of height section
-            const double segLength = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
-
-            // Position length of part 2 (the delayed section)
-            // Approximation only sadly, due to a bug in the OutRun code.
-            const double delayLength = delay / (POS_LENGTH / seg.step);
-            const double segLength2 = segLength + delayLength;
-
-            const double segLength3 = (segLength * 2) + delayLength;
-
-            // Part 1: This scales height start from 256 to 512
-            if (posInSeg < segLength)
-            {
-                double percentageIntoSegment = (segLength - posInSeg) / segLength;
-                int heightStart = HEIGHT_LENGTH - (HEIGHT_LENGTH * percentageIntoSegment);
-                oroad->setHeightMap(cp.value1, 0, 0x100 + heightStart, 0x100);
-            }
-            // Part 2: This scales delay down to zero
-            else if (posInSeg < segLength2)
-            {
-                double percentageIntoSegment = (segLength2 - posInSeg) / delayLength;
-                int newDelay = (delay * percentageIntoSegment);
-                oroad->setHeightMap(cp.value1, 1, 0x1FF, 0x100);
-                oroad->setDelay(newDelay);
-            }
-            // Part 3: This scales height start from 512 to 256
-            else if (posInSeg < segLength3)
-            {
-                double percentageIntoSegment = (segLength3 - posInSeg) / segLength;
-                int heightStart = (HEIGHT_LENGTH * percentageIntoSegment);
-                oroad->setHeightMap(cp.value1, 1, 0x100 + heightStart, 0x100);
-            }
-            else
-            {
-                oroad->setHeightMap(0, 0, 0x100);
-            }
-        }
-        break;
-        // ----------------------------------------------------------------------------------------
-        // HEIGHTMAP TYPE 3: MIXED HOLD SECTION
-        // ----------------------------------------------------------------------------------------
-        case 3:
-        {
-            const int delay = seg.value1;
-            const double delayLength = delay / (POS_LENGTH / seg.step);
-            const double endLength   = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
-
-            const double segLength  = HEIGHT_LENGTH / (POS_LENGTH / 4); // step is hard-coded to 4
-            const double segLength2 = (segLength * 6) + delayLength;
-            const double segLength3 = segLength2 + endLength;
-
-            // Part 1: Positions 1 to 5. This scales height start from 256 to 511
-            if (posInSeg < segLength * 6)
-            {
-                const int segmentIndex = posInSeg / segLength;
-                const int finePos = (segLength * (segmentIndex + 1)) - posInSeg;
-                const double percentageIntoSegment = (segLength - finePos) / segLength;
-                const int heightStart = (HEIGHT_LENGTH * percentageIntoSegment);
-                oroad->setHeightMap(cp.value1, segmentIndex, 0x100 + heightStart);
-            }
-            // Part 2: Hold on Entry 6
-            else if (posInSeg < segLength2)
-            {
-                double percentageIntoSegment = (segLength2 - posInSeg) / delayLength;
-                int newDelay = (delay * percentageIntoSegment);
-                oroad->setHeightMap(cp.value1, 6, 0x1FF, 0x100);
-                oroad->setDelay(newDelay);
-            }
-            // Part 3: This scales height start from 512 to 256
-            else if (posInSeg < segLength3)
-            {
-                double percentageIntoSegment = (segLength3 - posInSeg) / endLength;
-                int heightStart = (HEIGHT_LENGTH * percentageIntoSegment);
-                oroad->setHeightMap(cp.value1, 6, 0x100 + heightStart, 0x100);
-            }
-            else
-            {
-                oroad->setHeightMap(0, 0, 0x100);
-            }
-        }
-        break;
-        // ----------------------------------------------------------------------------------------
-        // CHANGE HORIZON
-        // ----------------------------------------------------------------------------------------
-        case 4:
-        {
-            const double segLength = HEIGHT_LENGTH / (POS_LENGTH / seg.step);
-            int heightStart;
-            if (posInSeg < segLength)
-            {
-                double percentageIntoSegment = (segLength - posInSeg) / segLength;
-                heightStart = HEIGHT_LENGTH - (HEIGHT_LENGTH * percentageIntoSegment);
-            }
-            else
-            {
-                heightStart = 0xFF;
-            }
-            oroad->setHeightMap(cp.value1, 0, 0x100 + heightStart);
-            oroad->removeUserOffset(horizonYOff);
-            oroad->setHorizonMod(seg.value1 + horizonYOff);
-        }
-        break;
+    rendering = true;
+    emit requestFrame(pending);
+
+    pending = PreviewRequest();
+}
 
-        } // end switch
+// Start the timer for the next drive frame. Timers only have millisecond resolution, so the
+// fractional target accumulated on the drive clock keeps the average rate at the display's.
+void RenderS16::scheduleTick()
+{
+    const qint64 remaining = (qint64) driveNext - driveClock.nsecsElapsed();
+    driveTimer->start((int) qMax(remaining / 1000000, (qint64) 0));
+}
+
+// Period between refreshes of the display showing the preview (microseconds)
+qreal RenderS16::refreshPeriod() const
+{
+    const QWindow* window = this->window()->windowHandle();
+    const QScreen* screen = window != NULL ? window->screen() : QGuiApplication::primaryScreen();
+    const qreal rate      = screen != NULL ? screen->refreshRate() : 0;
 
+    return 1e6 / (rate > 0 ? rate : 60.0);
+}
+
+PreviewKey RenderS16::currentKey() const
+{
+    PreviewKey key;
+    key.sceneGen   = sceneGen;
+    key.paletteGen = paletteGen;
+    key.pos        = lastPos;
+    key.cameraX    = cameraX;
+    key.cameraY    = horizonYOff;
+    key.overdraw   = overdraw;
+    return key;
+}
+
+// Bring the snapshot of the level data up to date, and only send it to the renderer if the
+// changes affect the frame. Returns the pipeline stages affected by the changes.
+int RenderS16::updateScene()
+{
+    int stages = 0;
+
+    if (scene.isNull() || changes == NULL)
+    {
+        stages = PreviewRenderer::STAGE_ALL;
     }
-    // No Height Segment Found
     else
     {
-        oroad->setHeightMap(0, 0, 0x100);
+        if (isChanged(LevelChanges::PATH) || isChanged(LevelChanges::WIDTH))
+            stages |= PreviewRenderer::STAGE_ROAD_X;
+
+        if (isChanged(LevelChanges::HEIGHT_POINTS))
+            stages |= PreviewRenderer::STAGE_ROAD_Y;
+
+        if (isChanged(LevelChanges::SCENERY_POINTS))
+            stages |= PreviewRenderer::STAGE_SPRITES;
+
+        if (isChanged(LevelChanges::PALETTE))
+            stages |= PreviewRenderer::STAGE_PALETTE;
+
+        stages |= patternStages;
+
+        // Nothing held by the snapshot has changed
+        if (stages == 0 && selectionStages == 0 && !isChanged(LevelChanges::HEIGHT_PATTERNS) &&
+            !isChanged(LevelChanges::SCENERY_PATTERNS) && !isChanged(LevelChanges::SCENERY_SELECTION))
+            return 0;
     }
-}
 
-// ------------------------------------------------------------------------------------------------
-// Rendering
-// ------------------------------------------------------------------------------------------------
+    // Selection only changes the highlighted sprites
+    const int edited = stages;
+    stages |= selectionStages;
 
-void RenderS16::paintEvent(QPaintEvent*)
-{
-    // Roms not loaded yet
-    if (rom0 == NULL)
-        return;
+    scene = createScene();
+    patternStages   = 0;
+    selectionStages = 0;
 
-    screen->fill(0);
+    // Only patterns unused by this level have changed. The renderer receives them with the next snapshot it needs.
+    if (stages == 0)
+        return 0;
 
-    if (levelData->end_pos > 0)
-        drawS16Frame();
+    if (stages & ~PreviewRenderer::STAGE_PALETTE) sceneGen++;
+    if (stages &  PreviewRenderer::STAGE_PALETTE) paletteGen++;
 
-    if (sceneryGuides)
-        drawSelectedSprites();
+    // Cached frames can never be presented again
+    cache.clear();
 
-    if (guideLines != GUIDES_OFF)
-        drawGuidelines();
+    // Palette, camera and selection changes don't affect the sprite load
+    if (edited & (PreviewRenderer::STAGE_ROAD_X | PreviewRenderer::STAGE_ROAD_Y | PreviewRenderer::STAGE_SPRITES))
+        budgetTimer->start();
 
-    // Stretches image to target
-    QRect target(0, 0, width(), height());
-    QPainter painter(this);
-    painter.drawImage(target, *screen);
+    pending.scene = scene;
+    return stages;
 }
 
-void RenderS16::drawS16Frame()
+bool RenderS16::isChanged(int aspect) const
 {
-    if (DEBUG) std::cout << "drawS16Frame() " << std::endl;
-    hwroad->render_background(pixels);
-    hwroad->render_foreground(pixels);
-    hwsprites->render(8, osprites->sprite_entries, osprites->sprite_count);
-
-    uint32_t* pix  = pixels;
+    return changes == NULL || changes->getGeneration(aspect) != sceneChanges[aspect];
+}
 
-    // Lookup real RGB value from rgb array for backbuffer
-    int x = 0;
-    int y = 0;
+// Snapshot the level data used by the renderer.
+// Data that hasn't changed since the last snapshot is shared with it.
+QSharedPointer<const PreviewScene> RenderS16::createScene()
+{
+    const LevelData* level = levels->getActiveLevelP();
+    PreviewScene* next     = scene.isNull() ? new PreviewScene() : new PreviewScene(*scene);
+    const bool full        = scene.isNull();
 
-    for (int i = 0; i < (S16_WIDTH * S16_HEIGHT); i++)
+    if (full || isChanged(LevelChanges::PATH))
     {
-        screen->setPixel(x, y, rgb[*(pix++) & ((S16_PALETTE_ENTRIES * 3) - 1)]);
+        next->end_pos = level->end_pos;
+        next->path.resize(qMax(level->end_pos, 0));
+        for (int i = 0; i < next->path.size(); i++)
+            next->path[i] = level->path[i];
+    }
 
-        if (++x == S16_WIDTH)
-        {
-            x = 0;
-            y++;
-        }
+    if (full || isChanged(LevelChanges::WIDTH))
+    {
+        next->startWidth = level->startWidth;
+        next->widthP     = level->widthP;
     }
-}
 
-void RenderS16::drawGuidelines()
-{
-    int x = 0, y = 0, w = 0, h = 0;
+    if (full || isChanged(LevelChanges::HEIGHT_POINTS))
+        next->heightP = level->heightP;
 
-    if (guideLines == GUIDES_43)
+    if (full || isChanged(LevelChanges::SCENERY_POINTS))
     {
-        w = 320;
-        h = 224;
+        next->startLine = levels->levelContainsStartLine();
+        next->spriteP   = level->spriteP;
     }
-    else if (guideLines == GUIDES_169)
+
+    if (full || isChanged(LevelChanges::PALETTE))
     {
-        w = 398;
-        h = 224;
+        next->pal     = *level->pal;
+        next->skyPal  = level->skyPal;
+        next->gndPal  = level->gndPal;
+        next->roadPal = level->roadPal;
     }
 
-    x = (S16_WIDTH  - w) / 2;
-    y = (S16_HEIGHT - h) / 2;
+    if ((full || isChanged(LevelChanges::HEIGHT_PATTERNS)) && heightSections != NULL)
+        next->heightSections = *heightSections;
 
-    QPainter painter(screen);
-    painter.fillRect(0,   y, x, h, QColor(0,0,0,128)); // Left  Border
-    painter.fillRect(x+w, y, x, h, QColor(0,0,0,128)); // Right Border
+    if ((full || isChanged(LevelChanges::SCENERY_PATTERNS) || isChanged(LevelChanges::SCENERY_SELECTION)) && spriteSections != NULL)
+        next->spritePatterns = QSharedPointer<const SpritePatterns>(new SpritePatterns(*spriteSections));
+
+    if (changes != NULL)
+    {
+        for (int i = 0; i < LevelChanges::ASPECTS; i++)
+            sceneChanges[i] = changes->getGeneration(i);
+    }
+
+    return QSharedPointer<const PreviewScene>(next);
 }
 
-void RenderS16::drawSelectedSprites()
+void RenderS16::analyseSprites()
 {
-    QPainter painter(screen);
+    budget->analyse(scene);
+}
 
-    for (int i = 0; i < osprites->sprite_count; i++)
-    {
-        osprite* spr = &osprites->sprite_entries[i];
+// Edits to a height pattern only affect the frame if the level uses it
+void RenderS16::heightPatternChanged(int index)
+{
+    const LevelData* level = levels->getActiveLevelP();
 
-        if (!spr->is_hidden() && spr->selected)
+    for (int i = 0; i < level->heightP.size(); i++)
+    {
+        if (index == LevelChanges::ALL_PATTERNS || level->heightP.at(i).value1 == index)
         {
-            int x = std::min(spr->get_screen_x1(), spr->get_screen_x2());
-            int y = std::min(spr->get_screen_y1(), spr->get_screen_y2());
-            painter.fillRect(x + S16_X_OFF, y, spr->get_screen_width(), spr->get_screen_height(), QColor(255,255,255,96));
+            patternStages |= PreviewRenderer::STAGE_ROAD_Y;
+            return;
         }
     }
 }
 
-// ---------------------------------------------------------------------------
-// Palette Handling Code
-// ---------------------------------------------------------------------------
-
-void RenderS16::writePal32(uint32_t* palAddr, const uint32_t data)
+// Edits to a scenery pattern only affect the frame if the level uses it
+void RenderS16::sceneryPatternChanged(int index)
 {
-    uint32_t adr = *palAddr & 0x1fff;
+    const LevelData* level = levels->getActiveLevelP();
 
-    palette[adr]   = (data >> 24) & 0xFF;
-    palette[adr+1] = (data >> 16) & 0xFF;
-    palette[adr+2] = (data >> 8) & 0xFF;
-    palette[adr+3] = data & 0xFF;
+    for (int i = 0; i < level->spriteP.size(); i++)
+    {
+        if (index == LevelChanges::ALL_PATTERNS || level->spriteP.at(i).value2 == index)
+        {
+            patternStages |= PreviewRenderer::STAGE_SPRITES;
+            return;
+        }
+    }
+}
 
-    refresh_palette(adr);
-    refresh_palette(adr+2);
+// Selecting a scenery pattern only affects the frame if the level uses it
+void RenderS16::scenerySelectionChanged(int index)
+{
+    const LevelData* level = levels->getActiveLevelP();
 
-    *palAddr += 4;
+    for (int i = 0; i < level->spriteP.size(); i++)
+    {
+        if (level->spriteP.at(i).value2 == index)
+        {
+            selectionStages |= PreviewRenderer::STAGE_SPRITES;
+            return;
+        }
+    }
 }
 
-uint16_t RenderS16::readPal16(uint32_t palAddr)
+// ------------------------------------------------------------------------------------------------
+// Rendering
+// ------------------------------------------------------------------------------------------------
+
+void RenderS16::setCurrent(const CachedFrame& frame)
 {
-    uint32_t adr = palAddr & 0x1fff;
-    return (palette[adr] << 8) | palette[adr+1];
+    current = frame;
+    presentedDirty = true;
+    update();
 }
 
-void RenderS16::writePal32(uint32_t adr, const uint32_t data)
+// Scale the current frame to the widget.
+// Whole multiples of the S16 resolution are scaled directly, as the preview is usually shown at 1x or 2x.
+void RenderS16::updatePresentation()
 {
-    adr &= 0x1fff;
+    presentedDirty = false;
 
-    palette[adr]   = (data >> 24) & 0xFF;
-    palette[adr+1] = (data >> 16) & 0xFF;
-    palette[adr+2] = (data >> 8) & 0xFF;
-    palette[adr+3] = data & 0xFF;
-    refresh_palette(adr);
-    refresh_palette(adr+2);
+    if (!current.valid)
+    {
+        presented = QPixmap();
+        return;
+    }
+
+    const int sx = width()  / S16_WIDTH;
+    const int sy = height() / S16_HEIGHT;
+
+    if (sx > 0 && sy > 0 && width() == sx * S16_WIDTH && height() == sy * S16_HEIGHT)
+        presented = QPixmap::fromImage(scaleInteger(current.image, sx, sy));
+    else
+        presented = QPixmap::fromImage(current.image.scaled(size(), Qt::IgnoreAspectRatio, Qt::FastTransformation));
 }
 
-void RenderS16::refresh_palette(uint32_t palAddr)
+// Nearest neighbour scale by whole multiples. Each scaled line is built once, then copied.
+QImage RenderS16::scaleInteger(const QImage& image, int sx, int sy)
 {
-    palAddr &= ~1;
-    uint32_t rgbAddr = palAddr >> 1;
-    uint32_t a = (palette[palAddr] << 8) | palette[palAddr + 1];
-    uint32_t r = (a & 0x000f) << 1; // r rrr0
-    uint32_t g = (a & 0x00f0) >> 3; // g ggg0
-    uint32_t b = (a & 0x0f00) >> 7; // b bbb0
-    if ((a & 0x1000) != 0)
-        r |= 1; // r rrrr
-    if ((a & 0x2000) != 0)
-        g |= 1; // g gggg
-    if ((a & 0x4000) != 0)
-        b |= 1; // b bbbb
+    if (sx == 1 && sy == 1)
+        return image;
+
+    QImage src = image.convertToFormat(QImage::Format_RGB32);
+    QImage dst(src.width() * sx, src.height() * sy, QImage::Format_RGB32);
 
-    r = r * 255 / 31;
-    g = g * 255 / 31;
-    b = b * 255 / 31;
+    for (int y = 0; y < src.height(); y++)
+    {
+        const QRgb* in = (const QRgb*) src.constScanLine(y);
+        QRgb* out      = (QRgb*) dst.scanLine(y * sy);
 
-    rgb[rgbAddr] = qRgb(r, g, b);
+        for (int x = 0; x < src.width(); x++)
+        {
+            for (int i = 0; i < sx; i++)
+                *(out++) = in[x];
+        }
 
-    // Create shadow / highlight colours at end of RGB array
-    // The resultant values are the same as MAME
-    r = r * 202 / 256;
-    g = g * 202 / 256;
-    b = b * 202 / 256;
+        for (int i = 1; i < sy; i++)
+            memcpy(dst.scanLine((y * sy) + i), dst.constScanLine(y * sy), dst.bytesPerLine());
+    }
 
-    rgb[rgbAddr + S16_PALETTE_ENTRIES] =
-    rgb[rgbAddr + (S16_PALETTE_ENTRIES * 2)] = qRgb(r, g, b);
+    return dst;
 }
 
-// ------------------------------------------------------------------------------------------------
-// PALETTE CODE FOR SPRITES AND ROAD
-// ------------------------------------------------------------------------------------------------
+// Only the overlays are drawn each time. The scaled frame is kept until it changes.
+void RenderS16::paintEvent(QPaintEvent* event)
+{
+    // Roms not loaded yet
+    if (renderer == NULL)
+        return;
 
-// Palette Data. Stored in blocks of 32 bytes.
-const uint32_t PAL_DATA = 0x14ED8;
+    if (presentedDirty || (current.valid && presented.size() != size()))
+        updatePresentation();
 
-// Palette Ram: Sprite Entries Start Here
-static const uint32_t PAL_SPRITES = 0x121000;
+    QPainter painter(this);
+    const QRect dirty = event->rect();
 
-// Copy Sprite Palette Data To Palette RAM On Vertical Interrupt
-//
-// Source Address: 0x858E
-// Input:          Source address in rom of data format
-// Output:         None
+    if (!presented.isNull())
+        painter.drawPixmap(dirty, presented, dirty);
+    else
+        painter.fillRect(dirty, Qt::black);
 
-void RenderS16::copySpritePalData()
-{
-    // Return if no palette entries to copy
-    if (osprites->pal_copy_count <= 0) return;
+    // Overlays are drawn using S16 screen co-ordinates
+    painter.scale((qreal) width() / S16_WIDTH, (qreal) height() / S16_HEIGHT);
 
-    for (int16_t i = 0; i < osprites->pal_copy_count; i++)
-    {
-        // Palette Data Source Offset (aligned to start of 32 byte boundry, * 5)
-        uint16_t src_offset = osprites->pal_addresses[(i * 2) + 0] << 5;
-        uint32_t src_addr = 2 + PAL_DATA + src_offset; // Source address in ROM
+    if (sceneryGuides)
+        drawSelectedSprites(painter);
 
-        uint16_t dst_offset = osprites->pal_addresses[(i * 2) + 1] << 5;
-        uint32_t dst_addr = 2 + PAL_SPRITES + dst_offset;
+    if (guideLines != GUIDES_OFF)
+        drawGuidelines(painter);
 
-        // Move 28 Bytes from ROM to palette RAM
-        for (uint16_t j = 0; j < 7; j++)
-        {
-            writePal32(&dst_addr, rom0->read32(&src_addr));
-        }
-    }
-    osprites->pal_copy_count = 0; // All entries copied
+    if (current.valid && current.key.overdraw)
+        drawOverdraw(painter);
+
+    if (driving)
+        drawDriveStats(painter);
 }
 
-void RenderS16::setupRoadPalettes()
+void RenderS16::drawGuidelines(QPainter& painter)
 {
-    setupSkyPalette();
-    setupGroundColor();
-    setupRoadCentre();
-    setupRoadStripes();
-    setupRoadSides();
-    setupRoadColour();
+    int x = 0, y = 0, w = 0, h = 0;
+
+    if (guideLines == GUIDES_43)
+    {
+        w = 320;
+        h = 224;
+    }
+    else if (guideLines == GUIDES_169)
+    {
+        w = 398;
+        h = 224;
+    }
+
+    x = (S16_WIDTH  - w) / 2;
+    y = (S16_HEIGHT - h) / 2;
+
+    painter.fillRect(0,   y, x, h, QColor(0,0,0,128)); // Left  Border
+    painter.fillRect(x+w, y, x, h, QColor(0,0,0,128)); // Right Border
 }
 
-// Setup sky palette. Can be a shaded effect of 1F entries.
-// Source: 8CA4
-void RenderS16::setupSkyPalette()
+void RenderS16::drawSelectedSprites(QPainter& painter)
 {
-    // Address of sky palette information
-    uint32_t dst = 0x120F00; // palette ram
-    for (int16_t i = 0; i < LevelPalette::SKY_LENGTH; i++)
-        writePal32(&dst, levelData->pal->sky[levelData->skyPal][i]);
+    foreach (QRect r, current.selected)
+        painter.fillRect(r, QColor(255,255,255,96));
 }
 
-// Initalise Colour Of Road Sides
-// Source: 8ED2
-void RenderS16::setupGroundColor()
+// Mark the worst scanline and the largest sprites, and report the pixels written
+void RenderS16::drawOverdraw(QPainter& painter)
 {
-    // Address of ground palette information
-    uint32_t dst_pal_ground1 = 0x120840; // palette ram: ground 1
-    uint32_t dst_pal_ground2 = 0x120860; // palette ram: ground 2
+    const OverdrawReport& report = current.overdraw;
+
+    painter.setPen(QColor(255, 255, 255, 160));
+    painter.drawLine(0, report.worstLine, S16_WIDTH, report.worstLine);
 
-    for (int16_t i = 0; i < LevelPalette::GND_LENGTH; i++)
+    painter.setBrush(Qt::NoBrush);
+    for (int i = 0; i < report.top.size(); i++)
     {
-        uint32_t data = levelData->pal->gnd[levelData->gndPal][i];
-        writePal32(&dst_pal_ground1, data);
-        writePal32(&dst_pal_ground2, data);
+        const QRect& r = report.top.at(i).bounds;
+        painter.setPen(QColor(255, 255, 255, 220));
+        painter.drawRect(r);
+        painter.drawText(r.topLeft() + QPoint(2, 10), QString::number(i + 1));
     }
-}
 
-void RenderS16::setupRoadCentre()
-{
-    writePal32(0x12080C, levelData->pal->road[levelData->roadPal][LevelPalette::CENTRE1]); // Road 1 Colours
-    writePal32(0x12081C, levelData->pal->road[levelData->roadPal][LevelPalette::CENTRE2]); // Road 2 Colours
-}
+    QString text = QString("Pixels written: %1 (%2x screen)\nWorst scanline: %3 (%4 pixels)")
+                       .arg(report.pixels)
+                       .arg((double) report.pixels / (S16_WIDTH * S16_HEIGHT), 0, 'f', 2)
+                       .arg(report.worstLine)
+                       .arg(report.worstLinePixels);
 
-void RenderS16::setupRoadStripes()
-{
-    writePal32(0x120804, levelData->pal->road[levelData->roadPal][LevelPalette::STRIPE1]); // Road 1 Colours
-    writePal32(0x120814, levelData->pal->road[levelData->roadPal][LevelPalette::STRIPE2]); // Road 2 Colours
-}
+    for (int i = 0; i < report.top.size(); i++)
+        text += QString("\n%1. Sprite: %2 pixels").arg(i + 1).arg(report.top.at(i).area);
 
-void RenderS16::setupRoadSides()
-{
-    writePal32(0x120808, levelData->pal->road[levelData->roadPal][LevelPalette::SIDE1]);  // Road 1 Colours
-    writePal32(0x120818, levelData->pal->road[levelData->roadPal][LevelPalette::SIDE2]);  // Road 2 Colours
+    // Report is drawn at the widget's own scale, so it stays legible
+    painter.resetTransform();
+    painter.setPen(Qt::white);
+    QRect bounds = painter.boundingRect(rect().adjusted(6, 6, -6, -6), Qt::AlignLeft | Qt::AlignTop, text);
+    painter.fillRect(bounds.adjusted(-4, -4, 4, 4), QColor(0, 0, 0, 160));
+    painter.drawText(bounds, Qt::AlignLeft | Qt::AlignTop, text);
 }
 
-void RenderS16::setupRoadColour()
+// Report the frame rate and render times whilst driving.
+// Frames that take longer than a display refresh are highlighted.
+void RenderS16::drawDriveStats(QPainter& painter)
 {
-    writePal32(0x120800, levelData->pal->road[levelData->roadPal][LevelPalette::ROAD1]);  // Road 1 Colours
-    writePal32(0x120810, levelData->pal->road[levelData->roadPal][LevelPalette::ROAD2]);  // Road 2 Colours
-}
+    QString text = "Measuring...";
+
+    if (shownPeriod > 0)
+    {
+        const int frames = qMax(shownStats.frames, 1);
+        text = QString("%1 fps\nRender: %2 ms avg, %3 ms max\nDropped: %4")
+                   .arg((shownStats.frames * 1000.0) / shownPeriod, 0, 'f', 1)
+                   .arg((shownStats.renderTotal / frames) / 1000.0, 0, 'f', 2)
+                   .arg(shownStats.renderMax / 1000.0, 0, 'f', 2)
+                   .arg(shownStats.dropped);
+    }
 
+    const bool slow = shownStats.dropped > 0 || shownStats.renderMax > refreshPeriod();
+
+    // Drawn at the widget's own scale, in the corner the overdraw report leaves free
+    painter.resetTransform();
+    painter.setPen(slow ? QColor(255, 96, 96) : Qt::white);
+    QRect bounds = painter.boundingRect(rect().adjusted(6, 6, -6, -6), Qt::AlignRight | Qt::AlignTop, text);
+    painter.fillRect(bounds.adjusted(-4, -4, 4, 4), QColor(0, 0, 0, 160));
+    painter.drawText(bounds, Qt::AlignRight | Qt::AlignTop, text);
+}
 
 // ------------------------------------------------------------------------------------------------
 // MOUSE PRESSES
@@ -785,17 +928,22 @@ void RenderS16::mouseMoveEvent(QMouseEvent *event)
         if (xDiff != 0)
         {
             oldX = event->x();
-            oroad->car_x_bak += xDiff;
-            if (oroad->car_x_bak > CAMERA_X_MAX)
-                oroad->car_x_bak = CAMERA_X_MAX;
-            else if (oroad->car_x_bak < CAMERA_X_MIN)
-                oroad->car_x_bak = CAMERA_X_MIN;
+            cameraX += xDiff;
+            if (cameraX > CAMERA_X_MAX)
+                cameraX = CAMERA_X_MAX;
+            else if (cameraX < CAMERA_X_MIN)
+                cameraX = CAMERA_X_MIN;
 
-            emit sendCameraX(oroad->car_x_bak);
+            emit sendCameraX(cameraX);
         }
 
-        if (xDiff || yDiff)
-            redrawPos();
+        // Only the camera dependent stages need to be re-run
+        int stages = 0;
+        if (yDiff) stages |= PreviewRenderer::STAGE_ROAD_Y;
+        if (xDiff) stages |= PreviewRenderer::STAGE_CAMERA;
+
+        if (stages)
+            redraw(lastPos, stages);
     }
 }
 
@@ -818,13 +966,14 @@ void RenderS16::wheelEvent(QWheelEvent *event)
                 change /= 5;
             else
                 change = change > 0 ? 1 : -1;
-            oroad->car_x_bak += change;
-            if (oroad->car_x_bak > CAMERA_X_MAX)
-                oroad->car_x_bak = CAMERA_X_MAX;
-            else if (oroad->car_x_bak < CAMERA_X_MIN)
-                oroad->car_x_bak = CAMERA_X_MIN;
-
-            emit sendCameraX(oroad->car_x_bak);
+            cameraX += change;
+            if (cameraX > CAMERA_X_MAX)
+                cameraX = CAMERA_X_MAX;
+            else if (cameraX < CAMERA_X_MIN)
+                cameraX = CAMERA_X_MIN;
+
+            emit sendCameraX(cameraX);
+            redraw(lastPos, PreviewRenderer::STAGE_CAMERA);
         }
         // Scroll Road Position
         else
@@ -835,7 +984,7 @@ void RenderS16::wheelEvent(QWheelEvent *event)
                 yChange = numDegrees.y() > 0 ? 1 : -1;
 
             const int newPos = lastPos + yChange;
-            if (newPos >= 0 && newPos < levelData->end_pos)
+            if (newPos >= 0 && newPos < levels->getActiveLevelP()->end_pos)
                 emit sendNewPosition(newPos);
         }
     }
@@ -8,6 +8,34 @@
 
     The original engine would have to iterate from position 0;
 
+    Frames are rendered by a PreviewRenderer on a worker thread. The
+    renderers are created whilst the ROMs load, and the preview is blank
+    until they are ready. Requests made whilst a frame is in progress are
+    merged, and this widget simply presents the latest completed frame.
+
+    Completed frames are cached. When the renderer is idle after scrubbing,
+    the neighbouring positions are rendered ahead of time in the direction
+    of travel.
+
+    Edits reported to LevelChanges determine which parts of the snapshot
+    are refreshed, and which pipeline stages are re-run. Edits to patterns
+    that the level does not use leave the cached frames alone.
+
+    Each new snapshot is also passed to the sprite budget, once editing
+    has paused, to measure the sprite load across the whole level.
+
+    In overdraw mode, frames show the pixels written by the hardware, with
+    a report of the worst scanline and the largest sprites. The whole level
+    can be profiled for overdraw on request.
+
+    In drive mode, the road position advances in real time and frames are
+    requested at the display refresh rate. Driven frames are not cached.
+    The frame rate and render times are shown, so heavy levels can be
+    spotted.
+
+    The presented frame is scaled to the widget once, and kept until the
+    frame or widget size changes. Overlays are drawn over it separately.
+
     Copyright Chris White.
     See license.txt for more details.
 ***************************************************************************/
@@ -16,13 +44,17 @@
 #define RENDERS16_HPP
 
 #include <QWidget>
+#include <QPixmap>
+#include <QElapsedTimer>
 #include "../globals.hpp"
-
-class HWRoad;
-class HWSprites;
-class ORoad;
-class OSprites;
-class RomLoader;
+#include "../levelchanges.hpp"
+#include "previewrenderer.hpp"
+#include "previewcache.hpp"
+
+class QThread;
+class QTimer;
+class SpriteBudget;
+class OverdrawProfiler;
 class Levels;
 struct HeightSegment;
 struct SpriteSectionEntry;
@@ -37,28 +69,53 @@ public:
     const static int    CAMERA_Y_MAX = 3000;
     const static int    CAMERA_Y_MIN = -600;
 
-    uint32_t* pixels; // Internal pixel array
+    const static int    CACHE_FRAMES    = 40; // Frames held in the cache
+    const static int    PREFETCH_AHEAD  = 8;  // Positions to prefetch in the scrub direction
+    const static int    PREFETCH_BEHIND = 2;  // Positions to prefetch behind
+    const static int    BUDGET_DELAY    = 500; // Milliseconds after an edit before measuring the sprite budget
+    // Driving speed. The sprite engine is calibrated for a scroll speed of 11 << 11: the road
+    // advancing 11 fine steps (of 10 per position) each frame, with the game logic at 30 fps.
+    const static int    DRIVE_FINE_STEP = 11;  // Fine steps per game frame
+    const static int    DRIVE_GAME_FPS  = 30;  // Game logic frames per second
+    const static int    FINE_PER_POS    = 10;  // Fine steps per road position
+    const static int    DRIVE_STATS     = 1000; // Milliseconds over which the drive statistics are measured
 
     explicit RenderS16(QWidget *parent = 0);
     ~RenderS16();
     void setData(Levels* levels, QList<HeightSegment> *heightSections, QList<SpriteSectionEntry> *spriteSections,
-                 RomLoader* rom0, RomLoader* sprites, RomLoader* rom1, RomLoader* roadRom);
+                 PreviewRenderers renderers);
     void init();
-    
+    SpriteBudget* getSpriteBudget() { return budget; }
+    OverdrawProfiler* getOverdrawProfiler() { return profiler; }
+
 signals:
     void sendNewPosition(int);
     void sendCameraX(int);
     void sendCameraY(int);
-    
+    void requestFrame(PreviewRequest);
+    void driveChanged(bool);
+    void statsChanged(QString);
+
 public slots:
     void setupRoadPalettes();
     void redrawPos();
     void setRoadPos(int);
     void setGuidelines(int);
     void setSceneryGuides(bool);
+    void setOverdraw(bool);
+    void setDrive(bool);
+    void profileOverdraw();
     void setCameraX(int x = 0);
     void setCameraY(int y = 0);
 
+private slots:
+    void presentFrame(int index);
+    void heightPatternChanged(int index);
+    void sceneryPatternChanged(int index);
+    void scenerySelectionChanged(int index);
+    void analyseSprites();
+    void driveTick();
+
 protected:
     void mousePressEvent(QMouseEvent *event);
     void mouseMoveEvent(QMouseEvent *event);
@@ -67,26 +124,66 @@ protected:
     void paintEvent(QPaintEvent *event);
 
 private:
-    const static bool   DEBUG = false;
-
     Levels* levels;
+    LevelChanges* changes;
 
     QList<HeightSegment>* heightSections;
+    QList<SpriteSectionEntry>* spriteSections;
+
+    QThread* renderThread;
+    PreviewRenderer* renderer;
+
+    CachedFrame current;       // Frame being presented
+    QPixmap presented;         // Current frame scaled to the widget
+    bool presentedDirty;       // Current frame has changed since it was scaled
+    PreviewRequest pending;    // Merged requests not yet sent to the renderer
+    bool rendering;            // Frame in progress
+
+    SpriteBudget* budget;
+    QTimer* budgetTimer;       // Delays the sprite budget whilst editing
+
+    OverdrawProfiler* profiler;
 
-    QImage* screen;   // Screen image
+    PreviewCache cache;
+    QSharedPointer<const PreviewScene> scene; // Latest level data snapshot
+    int sceneGen;              // Incremented when the level data changes
+    int paletteGen;            // Incremented when the palette changes
+    int scrubDir;              // Direction of last position change (or 0)
 
-    HWRoad* hwroad;   // Road Code
-    HWSprites* hwsprites;
-    ORoad*  oroad;
-    OSprites* osprites;
-    RomLoader* rom0;
+    uint32_t sceneChanges[LevelChanges::ASPECTS]; // Change generations held by the snapshot
+    int patternStages;         // Stages affected by pattern edits since the last snapshot
+    int selectionStages;       // Stages affected by scenery selection since the last snapshot
 
     int lastPos;
     int mousePress;
+    int cameraX;
     int horizonYOff;
     int oldX, oldY;
     int guideLines;
     bool sceneryGuides;
+    bool overdraw;             // Show overdraw, rather than the scene
+
+    // Frame times whilst driving
+    struct DriveStats
+    {
+        int frames;            // Frames presented
+        int dropped;           // Refreshes skipped as a frame was still rendering
+        qint64 renderTotal;    // Render time of the presented frames (microseconds)
+        int renderMax;         // Slowest frame (microseconds)
+
+        DriveStats() : frames(0), dropped(0), renderTotal(0), renderMax(0) {}
+    };
+
+    bool driving;              // Drive through the level in real time
+    uint32_t drivePos;         // Road position whilst driving (16.16)
+    QTimer* driveTimer;        // Requests a frame each display refresh
+    QElapsedTimer driveClock;  // Time since driving started
+    qint64 driveLast;          // Time of the last drive frame (nanoseconds)
+    double driveNext;          // Time the next drive frame is due (nanoseconds)
+    QElapsedTimer statsClock;  // Time since the statistics were last measured
+    DriveStats driveStats;     // Statistics being gathered
+    DriveStats shownStats;     // Statistics measured over the last period
+    int shownPeriod;           // Length of that period (milliseconds)
 
     enum
     {
@@ -95,27 +192,23 @@ private:
         GUIDES_169
     };
 
-    uint8_t palette[S16_PALETTE_ENTRIES * 2]; // 2 Bytes Per Palette Entry
-    QRgb rgb[S16_PALETTE_ENTRIES * 3];        // Extended to hold shadow/hilight colours
-
-    void drawS16Frame();
-    void drawGuidelines();
-    void drawSelectedSprites();
-    void updateSprites(int posEnd);
-    void copySpritePalData();
-    uint16_t readPal16(uint32_t);
-    void writePal32(uint32_t*, const uint32_t);
-    void writePal32(uint32_t, const uint32_t);
-    void refresh_palette(uint32_t);
-    void updateRoadWidth(int);
-    void updateRoadHorizon(int);
-    void updateRoadHeight(int);
-    void setupSkyPalette();
-    void setupGroundColor();
-    void setupRoadCentre();
-    void setupRoadStripes();
-    void setupRoadSides();
-    void setupRoadColour();  
+    void redraw(int pos, int stages, bool newScene = false);
+    void dispatch();
+    void prefetch();
+    PreviewKey currentKey() const;
+    int updateScene();
+    bool isChanged(int aspect) const;
+    QSharedPointer<const PreviewScene> createScene();
+    void setCurrent(const CachedFrame& frame);
+    void reportStats(const QString& frameTime);
+    void updatePresentation();
+    static QImage scaleInteger(const QImage& image, int sx, int sy);
+    void drawGuidelines(QPainter& painter);
+    void drawSelectedSprites(QPainter& painter);
+    void drawOverdraw(QPainter& painter);
+    void drawDriveStats(QPainter& painter);
+    void scheduleTick();
+    qreal refreshPeriod() const;
 };
 
 #endif // RENDERS16_HPP
@@ -0,0 +1,122 @@
+/***************************************************************************
+    Road Y Kernels
+
+    Straight-line loops from the road height code in ORoad, rewritten so
+    that every entry can be calculated independently of the last. This
+    allows the compiler to vectorise them.
+
+    The results are bit-exact with the original 68000 code. The original
+    loops are kept as a reference, and can be checked against by enabling
+    VERIFY.
+
+    All kernels write to descending addresses, as the original code does.
+    The destination points to the entry after the last one written.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <iostream>
+#include "roadkernels.hpp"
+
+// Entry n (counting from 1) is the running total after n steps: total + (step * n).
+// Only bits 12 to 27 of the total are stored, which is (total << 4) >> 16 on a 32-bit register.
+uint32_t RoadKernels::height_ramp(int16_t* dst, int count, uint32_t total, uint32_t step)
+{
+    if (count <= 0)
+        return total;
+
+    int16_t* out = dst - count; // Lowest address written
+
+    for (int i = 0; i < count; i++)
+    {
+        const uint32_t n = count - i;
+        out[i] = (int16_t) (((total + (step * n)) << 4) >> 16);
+    }
+
+    if (VERIFY && count <= MAX_COUNT)
+    {
+        int16_t ref[MAX_COUNT + 1];
+        height_ramp_ref(ref + count, count, total, step);
+        verify("height_ramp", out, ref, count);
+    }
+
+    return total + (step * count);
+}
+
+void RoadKernels::fill(int16_t* dst, int count, int16_t value)
+{
+    if (count <= 0)
+        return;
+
+    int16_t* out = dst - count;
+
+    for (int i = 0; i < count; i++)
+        out[i] = value;
+}
+
+// Entry n (counting from 0) is colour + (n / 2)
+void RoadKernels::colour_ramp(int16_t* dst, int count, int16_t colour)
+{
+    if (count <= 0)
+        return;
+
+    int16_t* out = dst - count;
+
+    for (int i = 0; i < count; i++)
+        out[i] = colour + ((count - 1 - i) >> 1);
+
+    if (VERIFY && count <= MAX_COUNT)
+    {
+        int16_t ref[MAX_COUNT + 1];
+        colour_ramp_ref(ref + count, count, colour);
+        verify("colour_ramp", out, ref, count);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Reference versions. As per the original code.
+// ------------------------------------------------------------------------------------------------
+
+// Source: 0x2080: write_y
+uint32_t RoadKernels::height_ramp_ref(int16_t* dst, int count, uint32_t total, uint32_t step)
+{
+    for (int i = 0; i < count; i++)
+    {
+        total += step;
+        *(--dst) = (total << 4) >> 16;
+    }
+    return total;
+}
+
+void RoadKernels::fill_ref(int16_t* dst, int count, int16_t value)
+{
+    while (count-- > 0)
+        *(--dst) = value;
+}
+
+// Source: 0x1392
+void RoadKernels::colour_ramp_ref(int16_t* dst, int count, int16_t colour)
+{
+    while (count > 0)
+    {
+        *(--dst) = colour;
+        if (--count == 0) break;
+        *(--dst) = colour;
+        --count;
+        colour++;
+    }
+}
+
+void RoadKernels::verify(const char* kernel, const int16_t* dst, const int16_t* ref, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (dst[i] != ref[i])
+        {
+            std::cout << "RoadKernels::" << kernel << " mismatch at " << i
+                      << " (" << dst[i] << " != " << ref[i] << ")" << std::endl;
+            return;
+        }
+    }
+}
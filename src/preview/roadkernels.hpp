@@ -0,0 +1,49 @@
+/***************************************************************************
+    Road Y Kernels
+
+    Straight-line loops from the road height code in ORoad, rewritten so
+    that every entry can be calculated independently of the last. This
+    allows the compiler to vectorise them.
+
+    The results are bit-exact with the original 68000 code. The original
+    loops are kept as a reference, and can be checked against by enabling
+    VERIFY.
+
+    All kernels write to descending addresses, as the original code does.
+    The destination points to the entry after the last one written.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include "../stdint.hpp"
+
+class RoadKernels
+{
+public:
+    // Height ramp. Each entry adds step to the running total.
+    // Returns the final total.
+    static uint32_t height_ramp(int16_t* dst, int count, uint32_t total, uint32_t step);
+
+    // Fill with a single value
+    static void fill(int16_t* dst, int count, int16_t value);
+
+    // Colour ramp. Each colour is written to two entries.
+    static void colour_ramp(int16_t* dst, int count, int16_t colour);
+
+    // Reference versions of the above
+    static uint32_t height_ramp_ref(int16_t* dst, int count, uint32_t total, uint32_t step);
+    static void fill_ref(int16_t* dst, int count, int16_t value);
+    static void colour_ramp_ref(int16_t* dst, int count, int16_t colour);
+
+private:
+    // Check each kernel against the reference version
+    const static bool VERIFY = false;
+
+    // Largest run written by the road code
+    const static int MAX_COUNT = 0x200;
+
+    static void verify(const char* kernel, const int16_t* dst, const int16_t* ref, int count);
+};
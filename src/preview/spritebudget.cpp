@@ -0,0 +1,117 @@
+/***************************************************************************
+    Sprite Budget.
+
+    Measures the load on the sprite hardware at every position of a level.
+
+    The sprite pipeline of the preview is run across the whole level on a
+    worker thread, recording the sprites and shadows sent to the hardware
+    and those dropped because the tables were full.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <iostream>
+#include <QtConcurrent>
+
+#include "spritebudget.hpp"
+
+SpriteBudget::SpriteBudget(QObject *parent) :
+    QObject(parent)
+{
+    renderer = NULL;
+    connect(&watcher, SIGNAL(finished()), this, SLOT(done()));
+}
+
+SpriteBudget::~SpriteBudget()
+{
+    stop();
+    delete renderer;
+}
+
+// Takes ownership of the renderer, which may be NULL when the ROMs are unloaded
+void SpriteBudget::setRenderer(PreviewRenderer* renderer)
+{
+    stop();
+    next.clear();
+    load.clear();
+
+    delete this->renderer;
+    this->renderer = renderer;
+}
+
+// Analyse a new snapshot of the level. A job already running is cancelled, and the
+// snapshot is analysed once it has stopped.
+void SpriteBudget::analyse(QSharedPointer<const PreviewScene> scene)
+{
+    if (renderer == NULL || scene.isNull())
+        return;
+
+    if (watcher.isRunning())
+    {
+        next = scene;
+        cancelled.storeRelease(1);
+    }
+    else
+        start(scene);
+}
+
+// Forget the load measured, and any job in progress, when the level is replaced
+void SpriteBudget::clear()
+{
+    stop();
+    next.clear();
+    load.clear();
+
+    emit loadChanged();
+}
+
+void SpriteBudget::start(QSharedPointer<const PreviewScene> scene)
+{
+    cancelled.storeRelease(0);
+
+    PreviewRenderer* renderer = this->renderer;
+    const QAtomicInt* cancel  = &cancelled;
+
+    // The snapshot is held by the job until it completes
+    watcher.setFuture(QtConcurrent::run([=]()
+    {
+        return renderer->measureSprites(*scene, cancel);
+    }));
+}
+
+void SpriteBudget::stop()
+{
+    cancelled.storeRelease(1);
+    watcher.waitForFinished();
+}
+
+void SpriteBudget::done()
+{
+    // Superseded by a newer snapshot
+    if (!next.isNull())
+    {
+        QSharedPointer<const PreviewScene> scene = next;
+        next.clear();
+        start(scene);
+        return;
+    }
+
+    if (cancelled.loadAcquire() != 0)
+        return;
+
+    load = watcher.result();
+
+    if (DEBUG)
+    {
+        int peak = 0, dropped = 0;
+        foreach (SpriteLoad l, load)
+        {
+            peak     = std::max(peak, l.sprites + l.shadows);
+            dropped += l.dropped;
+        }
+        std::cout << "SpriteBudget: peak " << peak << "/" << LIMIT << " dropped " << dropped << std::endl;
+    }
+
+    emit loadChanged();
+}
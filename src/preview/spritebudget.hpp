@@ -0,0 +1,64 @@
+/***************************************************************************
+    Sprite Budget.
+
+    Measures the load on the sprite hardware at every position of a level.
+
+    The sprite pipeline of the preview is run across the whole level on a
+    worker thread, recording the sprites and shadows sent to the hardware
+    and those dropped because the tables were full.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QVector>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QFutureWatcher>
+
+#include "previewrenderer.hpp"
+#include "osprites.hpp"
+
+class SpriteBudget : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Sprite and shadow entries available before sprites are dropped
+    const static int LIMIT = OSprites::JUMP_ENTRIES_TOTAL;
+
+    explicit SpriteBudget(QObject *parent = 0);
+    ~SpriteBudget();
+
+    void setRenderer(PreviewRenderer* renderer);
+    void analyse(QSharedPointer<const PreviewScene> scene);
+    void clear();
+    const QVector<SpriteLoad>& getLoad() const { return load; }
+
+signals:
+    void loadChanged();
+
+private slots:
+    void done();
+
+private:
+    const static bool DEBUG = false;
+
+    // Renderer used for measurement only. Never used by more than one job at a time.
+    PreviewRenderer* renderer;
+
+    // Scene waiting for the current job to finish
+    QSharedPointer<const PreviewScene> next;
+
+    QAtomicInt cancelled;
+    QFutureWatcher<QVector<SpriteLoad> > watcher;
+
+    // Result of the last completed analysis
+    QVector<SpriteLoad> load;
+
+    void start(QSharedPointer<const PreviewScene> scene);
+    void stop();
+};
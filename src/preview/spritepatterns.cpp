@@ -0,0 +1,33 @@
+/***************************************************************************
+    Sprite Patterns.
+
+    Immutable, flattened copy of the editor's scenery patterns, as used by
+    the sprite engine.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include "spritepatterns.hpp"
+
+SpritePatterns::SpritePatterns(const QList<SpriteSectionEntry>& sections)
+{
+    int total = 0;
+    foreach (const SpriteSectionEntry& section, sections)
+        total += section.sprites.size();
+
+    patterns.reserve(sections.size());
+    entries.reserve(total);
+
+    foreach (const SpriteSectionEntry& section, sections)
+    {
+        Pattern p;
+        p.start     = entries.size();
+        p.last      = (int16_t) section.sprites.size() - 1;
+        p.frequency = section.frequency;
+        patterns.append(p);
+
+        foreach (const SpriteEntry& sprite, section.sprites)
+            entries.append(sprite);
+    }
+}
@@ -0,0 +1,49 @@
+/***************************************************************************
+    Sprite Patterns.
+
+    Immutable, flattened copy of the editor's scenery patterns, as used by
+    the sprite engine.
+
+    The sprites of every pattern are held in a single contiguous array.
+    The table is built when the patterns are edited and shared between
+    snapshots of the level, so segments can be replayed without copying
+    or allocating.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <QList>
+#include <QVector>
+
+#include "../sprites/spriteformat.hpp"
+
+class SpritePatterns
+{
+public:
+    struct Pattern
+    {
+        int start;              // Index of first sprite in table
+        int16_t last;           // Offset of last sprite (reload value), or -1 if empty
+        uint16_t frequency;     // Sprite Frequency Value Bitmask
+    };
+
+    SpritePatterns(const QList<SpriteSectionEntry>& sections);
+
+    // Pattern at index, or NULL if the index is no longer valid
+    inline const Pattern* pattern(int index) const
+    {
+        return index >= 0 && index < patterns.size() ? &patterns.at(index) : NULL;
+    }
+
+    inline const SpriteEntry* sprites(const Pattern* p) const
+    {
+        return entries.constData() + p->start;
+    }
+
+private:
+    QVector<Pattern> patterns;
+    QVector<SpriteEntry> entries;
+};
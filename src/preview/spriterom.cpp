@@ -0,0 +1,133 @@
+/***************************************************************************
+    Sprite ROM Tables.
+
+    The lookup tables used by the sprite routines, decoded from the
+    big-endian program ROM into native structures once, when the ROMs are
+    loaded.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <string.h>
+
+#include "../globals.hpp"
+#include "../import/romloader.hpp"
+#include "spriterom.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// OutRun ROM Addresses
+// ------------------------------------------------------------------------------------------------
+
+// Shadow frames
+const uint32_t SPRITE_SHDW_FRAMES = 0x7862;
+const uint32_t SPRITE_SHDW_SMALL  = 0x1193C;
+
+// Sprite Zoom Lookup Table: Table Of Longs that represent X & Y Zoom Value
+const uint32_t SPRITE_ZOOM_LOOKUP = 0x28000;
+
+// Cloud frame to use at each y position.
+//
+// Format:
+// +0: Offset into frame table
+// +1: Entry In Zoom Lookup Table
+const uint32_t MOVEMENT_LOOKUP_Z = 0x30900;
+
+// Table to alter sprite based on its y position. Format as above.
+const uint32_t MAP_Y_TO_FRAME = 0x30A00;
+
+// Tables of frame addresses
+const uint32_t SPRITE_CLOUD_FRAMES    = 0x4246;
+const uint32_t SPRITE_MINITREE_FRAMES = 0x435C;
+const uint32_t SPRITE_GRASS_FRAMES    = 0x4548;
+const uint32_t SPRITE_SAND_FRAMES     = 0x4588;
+const uint32_t SPRITE_STONE_FRAMES    = 0x45C8;
+const uint32_t SPRITE_WATER_FRAMES    = 0x4608;
+
+// ------------------------------------------------------------------------------------------------
+
+SpriteRom::SpriteRom(RomLoader* rom)
+{
+    this->rom  = rom;
+    frames     = (SpriteFrames*) qMallocAligned(MAX_FRAMES * sizeof(SpriteFrames), sizeof(SpriteFrames));
+    framesUsed = 0;
+
+    for (int i = 0; i < SPRITE_TYPES; i++)
+        spriteList[i] = decodeFrames(rom->read32(SPRITELIST_ADR + (i << 2)));
+
+    decodeTable(thicknessFrames[GRASS], SPRITE_GRASS_FRAMES);
+    decodeTable(thicknessFrames[SAND],  SPRITE_SAND_FRAMES);
+    decodeTable(thicknessFrames[STONE], SPRITE_STONE_FRAMES);
+    decodeTable(thicknessFrames[WATER], SPRITE_WATER_FRAMES);
+
+    decodeZoomFrames(minitreeFrames, MAP_Y_TO_FRAME, SPRITE_MINITREE_FRAMES);
+    decodeZoomFrames(cloudFrames, MOVEMENT_LOOKUP_Z, SPRITE_CLOUD_FRAMES);
+    minitreeLarge = decodeFrames(rom->read32(SPRITE_MINITREE_FRAMES));
+    cloudLarge    = decodeFrames(rom->read32(SPRITE_CLOUD_FRAMES));
+
+    shadow      = decodeFrames(rom->read32(SPRITE_SHDW_FRAMES + 0x3C));
+    shadowSmall = decodeFrames(SPRITE_SHDW_SMALL);
+
+    wh = rom->rom + WH_TABLE;
+
+    for (uint32_t i = 0; i < ZOOM_STEPS; i++)
+        zoomSteps[i] = readZoomStep(i << 2);
+
+    decoded.clear();
+}
+
+SpriteRom::~SpriteRom()
+{
+    qFreeAligned(frames);
+}
+
+// Decode the frame records at a ROM address. Sprites that share frames share a block.
+const SpriteFrames* SpriteRom::decodeFrames(uint32_t addr)
+{
+    const SpriteFrames* existing = decoded.value(addr, NULL);
+    if (existing != NULL)
+        return existing;
+
+    SpriteFrames* f = &frames[framesUsed++];
+    memset(f, 0, sizeof(SpriteFrames));
+
+    // Addresses outside the ROM are left blank
+    if (addr + (SpriteFrames::FRAMES * FRAME_BYTES) <= rom->length)
+    {
+        for (int i = 0; i < SpriteFrames::FRAMES; i++)
+        {
+            uint32_t src = addr + (i * FRAME_BYTES);
+            f->frame[i].width       = rom->read8(src + 1);
+            f->frame[i].line_width  = rom->read16(src + 2);
+            f->frame[i].height      = rom->read8(src + 3);
+            f->frame[i].line_length = rom->read16(src + 4);
+            f->frame[i].pitch       = rom->read8(src + 5);
+            f->frame[i].bank        = rom->read8(src + 7);
+            f->frame[i].offset      = rom->read16(src + 8);
+        }
+    }
+
+    decoded.insert(addr, f);
+    return f;
+}
+
+void SpriteRom::decodeTable(const SpriteFrames** table, uint32_t adr)
+{
+    for (int i = 0; i < FRAME_TABLE; i++)
+        table[i] = decodeFrames(rom->read32(adr + (i << 2)));
+}
+
+void SpriteRom::decodeZoomFrames(SpriteZoomFrame* table, uint32_t lookup, uint32_t frameTable)
+{
+    for (int z = 0; z < ZOOM_FRAMES; z++)
+    {
+        uint8_t offset = rom->read8(lookup + (z << 1));
+        table[z].frames = decodeFrames(rom->read32(frameTable + offset));
+        table[z].zoom   = rom->read8(lookup + (z << 1) + 1);
+    }
+}
+
+uint32_t SpriteRom::readZoomStep(uint32_t offset) const
+{
+    return rom->read32(SPRITE_ZOOM_LOOKUP + offset);
+}
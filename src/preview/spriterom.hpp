@@ -0,0 +1,124 @@
+/***************************************************************************
+    Sprite ROM Tables.
+
+    The lookup tables used by the sprite routines, decoded from the
+    big-endian program ROM into native structures once, when the ROMs are
+    loaded.
+
+    - Each sprite's frame records are decoded into a SpriteFrames block.
+      Tables of frame addresses become tables of pointers to these blocks,
+      so the sprite routines never read the ROM whilst a frame is drawn.
+    - Blocks are 64 bytes and held in a cache line aligned array, so all
+      the frames of a sprite share a cache line.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include "../stdint.hpp"
+
+class RomLoader;
+
+// Sprite frame record, decoded from its 10 bytes of ROM
+struct SpriteFrame
+{
+    uint16_t line_width;     // +2 [Word] Width of line data
+    uint16_t line_length;    // +4 [Word] Length of line data
+    uint16_t offset;         // +8 [Word] Offset within sprite bank
+    uint8_t  width;          // +1 [Byte] Width lookup (WH_TABLE)
+    uint8_t  height;         // +3 [Byte] Height lookup (WH_TABLE)
+    uint8_t  pitch;          // +5 [Byte] Sprite pitch
+    uint8_t  bank;           // +7 [Byte] Sprite bank
+};
+
+// All frames of a sprite. The zoom lookup table selects one per size.
+struct SpriteFrames
+{
+    const static int FRAMES = 5;
+
+    SpriteFrame frame[FRAMES];
+    uint8_t pad[64 - (FRAMES * sizeof(SpriteFrame))];
+};
+
+static_assert(sizeof(SpriteFrames) == 64, "SpriteFrames must fill a cache line");
+
+// Sprite frames to use at a zoom level, for sprites that change frame as they approach
+struct SpriteZoomFrame
+{
+    const SpriteFrames* frames;
+    uint8_t zoom;            // Entry in zoom lookup table
+};
+
+class SpriteRom
+{
+public:
+    const static int SPRITE_TYPES = 0x100;  // Entries in the sprite list
+    const static int FRAME_TABLE  = 0x10;   // Entries in a table of frame addresses
+    const static int ZOOM_FRAMES  = 0x80;   // Zoom levels with their own frame
+    const static int FRAME_BYTES  = 10;     // Size of frame record in ROM
+
+    // Frame tables for thickness sprites
+    enum
+    {
+        GRASS,
+        SAND,
+        STONE,
+        WATER,
+        THICKNESS_TABLES
+    };
+
+    SpriteRom(RomLoader* rom);
+    ~SpriteRom();
+
+    // Frames for a sprite type (an offset into the sprite list)
+    inline const SpriteFrames* sprite(uint16_t type) const        { return spriteList[(type >> 2) & (SPRITE_TYPES - 1)]; }
+
+    // Frames from a table of frame addresses, using a byte offset into the table
+    inline const SpriteFrames* thickness(int table, uint8_t offset) const { return thicknessFrames[table][offset >> 2]; }
+
+    // Mini-tree and cloud frames to use at each zoom level, below ZOOM_FRAMES.
+    // Frames for the larger sizes are the first entry of their frame table.
+    inline const SpriteZoomFrame& minitree(uint16_t z) const       { return minitreeFrames[z]; }
+    inline const SpriteZoomFrame& cloud(uint16_t z) const          { return cloudFrames[z]; }
+
+    const SpriteFrames* minitreeLarge;
+    const SpriteFrames* cloudLarge;
+
+    // Shadows
+    const SpriteFrames* shadow;
+    const SpriteFrames* shadowSmall;
+
+    // Width & height lookup helper. Bytes, so read in place.
+    const uint8_t* wh;
+
+    // Distance to move a sprite, by byte offset into the table: (z << 2) | speed.
+    // Offsets outside the decoded range are read from the ROM.
+    inline uint32_t zoomStep(uint32_t offset) const
+    {
+        return (offset & 3) == 0 && offset < ZOOM_STEPS * 4 ? zoomSteps[offset >> 2] : readZoomStep(offset);
+    }
+
+private:
+    const static uint32_t ZOOM_STEPS = 0x2000;  // Covers scroll speeds up to 0x7800
+    const static int MAX_FRAMES = SPRITE_TYPES + (THICKNESS_TABLES * FRAME_TABLE) + (ZOOM_FRAMES * 2) + 4;
+
+    RomLoader* rom;
+
+    SpriteFrames* frames;    // Decoded frame blocks (cache line aligned)
+    int framesUsed;
+    QHash<uint32_t, const SpriteFrames*> decoded; // Blocks by ROM address, whilst decoding
+
+    const SpriteFrames* spriteList[SPRITE_TYPES];
+    const SpriteFrames* thicknessFrames[THICKNESS_TABLES][FRAME_TABLE];
+    SpriteZoomFrame minitreeFrames[ZOOM_FRAMES];
+    SpriteZoomFrame cloudFrames[ZOOM_FRAMES];
+    uint32_t zoomSteps[ZOOM_STEPS];
+
+    const SpriteFrames* decodeFrames(uint32_t addr);
+    void decodeTable(const SpriteFrames** table, uint32_t adr);
+    void decodeZoomFrames(SpriteZoomFrame* table, uint32_t lookup, uint32_t frameTable);
+    uint32_t readZoomStep(uint32_t offset) const;
+};
@@ -23,6 +23,7 @@ PreviewPalette::PreviewPalette(QWidget *parent) :
     image = new QImage(width(), height(), QImage::Format_RGB32);
     pal   = -1;
     rows  = columns = 0;
+    editEntry = -1;
 
     setSelection(false);
 }
@@ -130,17 +131,22 @@ void PreviewPalette::mousePressEvent(QMouseEvent *e)
         const Qt::MouseButton button = e->button();
         if (button == Qt::LeftButton)
         {
-            // Launch a colour picker for the palette entry
-            QColor color = QColorDialog::getColor(QColor(rgb[srcColor]), this);
+            // Launch a colour picker for the palette entry.
+            // The colour is sent as it changes, so the preview can be updated live.
+            const QColor original(rgb[srcColor]);
+            QColorDialog dialog(original, this);
+
+            editEntry = entry;
+            connect(&dialog, SIGNAL(currentColorChanged(QColor)), this, SLOT(setColor(QColor)));
 
             // Valid colour selected, output a signal for the new colour
-            if (color.isValid())
-            {
-                uint16_t s16Color = Utils::convertToS16(color);
-                rgb[srcColor] = color.rgb();
-                emit sendColor(entry, s16Color);
-                emit refreshPreview();
-            }
+            if (dialog.exec() == QDialog::Accepted && dialog.selectedColor().isValid())
+                setColor(dialog.selectedColor());
+            // Otherwise restore the original colour
+            else if (rgb[srcColor] != original.rgb())
+                setColor(original);
+
+            editEntry = -1;
         }
         else if (button == Qt::RightButton && selectionEnabled)
         {
@@ -163,6 +169,18 @@ void PreviewPalette::mousePressEvent(QMouseEvent *e)
     }
 }
 
+void PreviewPalette::setColor(const QColor& color)
+{
+    if (rgb == NULL || pal == -1 || editEntry == -1)
+        return;
+
+    uint16_t s16Color = Utils::convertToS16(color);
+    rgb[pal + editEntry] = color.rgb();
+    emit sendColor(editEntry, s16Color);
+    emit refreshPreview();
+    update();
+}
+
 void PreviewPalette::enterEvent(QEvent*)
 {
     setCursor(Qt::PointingHandCursor);
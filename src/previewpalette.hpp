@@ -35,6 +35,9 @@ signals:
 public slots:
     void setPalette(int);
 
+private slots:
+    void setColor(const QColor& color);
+
 protected:
     void mousePressEvent(QMouseEvent *event);
     void leaveEvent(QEvent *);
@@ -56,6 +59,9 @@ private:
 
     int pal;
 
+    // Palette entry being edited with the colour picker (or -1)
+    int editEntry;
+
     // Is user allowed to select palette entries?
     bool selectionEnabled;
 
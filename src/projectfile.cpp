@@ -0,0 +1,629 @@
+/***************************************************************************
+    Layout Project File.
+
+    Reads and writes the XML project format. Projects are read into, and
+    written from, a ProjectSnapshot rather than the editor's models, so
+    files can be handled on any thread, and without the editor.
+
+    Sections missing from a file leave the snapshot untouched.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <QFile>
+#include <QSaveFile>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "levels/levelconstants.hpp"
+#include "projectsnapshot.hpp"
+#include "projectfile.hpp"
+
+// ------------------------------------------------------------------------------------------------
+//                                               LOADING
+// ------------------------------------------------------------------------------------------------
+
+bool ProjectFile::read(const QString& filename, ProjectSnapshot& project, QString* error)
+{
+    QFile file(filename);
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        *error = "Unable to open XML file";
+        return false;
+    }
+
+    // Stages missing from the file are left unmapped (-1)
+    if (project.mapping.size() < LevelConstants::MAP_SLOTS)
+        project.mapping.fill(-1, LevelConstants::MAP_SLOTS);
+
+    QXmlStreamReader stream(&file);
+
+    while (!stream.atEnd() && !stream.hasError())
+    {
+        QXmlStreamReader::TokenType token = stream.readNext();
+
+        if (token == QXmlStreamReader::StartDocument)
+            continue;
+
+        if (token == QXmlStreamReader::StartElement)
+        {
+            if (stream.name()      == QString("settings"))        readSettings(stream, project);
+            else if (stream.name() == QString("levelList"))       readLevelList(stream, project);
+            else if (stream.name() == QString("levelMapping"))    readLevelMappingData(stream, project);
+            else if (stream.name() == QString("heightMaps"))      readHeightMapData(stream, project);
+            else if (stream.name() == QString("sceneryPatterns")) readSceneryPatternData(stream, project);
+            else if (stream.name() == QString("sharedPalettes"))  readSharedPalettes(stream, project);
+            else if (stream.name() == QString("journal"))
+                project.journalGeneration = getAttString(stream.attributes(), "generation").toUInt();
+        }
+    }
+
+    if (stream.hasError())
+    {
+        *error = stream.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+// The journal element is written before the rest of the project
+uint32_t ProjectFile::readJournalGeneration(const QString& filename)
+{
+    QFile file(filename);
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return 0;
+
+    QXmlStreamReader stream(&file);
+
+    while (!stream.atEnd() && !stream.hasError())
+    {
+        if (stream.readNext() != QXmlStreamReader::StartElement || stream.name() == QString("LayOut"))
+            continue;
+
+        if (stream.name() == QString("journal"))
+            return getAttString(stream.attributes(), "generation").toUInt();
+
+        break;
+    }
+
+    return 0;
+}
+
+void ProjectFile::readSettings(QXmlStreamReader& stream, ProjectSnapshot& project)
+{
+    while (stream.readNext() && !stream.atEnd() && !stream.hasError())
+    {
+        if (stream.isStartElement() && stream.name() == QString("startLine"))
+        {
+            QXmlStreamAttributes att = stream.attributes();
+            project.startLine = getAttInt(att, "enabled") != 0;
+        }
+        else if (stream.isEndElement() && stream.name() == QString("settings"))
+            return;
+    }
+}
+
+void ProjectFile::readLevelMappingData(QXmlStreamReader &stream, ProjectSnapshot& project)
+{
+    while (stream.readNext() && !stream.atEnd() && !stream.hasError())
+    {
+        if (stream.isStartElement() && stream.name() == QString("stage"))
+        {
+            QXmlStreamAttributes att = stream.attributes();
+            int stage = getAttInt(att, "id");
+            int map   = getAttInt(att, "mapping");
+
+            if (stage >= 0 && stage < project.mapping.size())
+                project.mapping[stage] = map;
+        }
+        else if (stream.isEndElement() && stream.name() == QString("levelMapping"))
+            return;
+    }
+}
+
+// End sections share a single path, which is stored with the first end section
+void ProjectFile::readLevelList(QXmlStreamReader &stream, ProjectSnapshot& project)
+{
+    project.levels.clear();
+
+    int current  = -1;
+    int firstEnd = -1;
+
+    while (stream.readNext() && !stream.atEnd() && !stream.hasError())
+    {
+        if (stream.isStartElement() && stream.name() == QString("level"))
+        {
+            QXmlStreamAttributes att = stream.attributes();
+
+            ProjectLevel level;
+            level.name = getAttString(att, "name");
+            level.type = getAttInt(att, "type");
+
+            if (level.type == LevelConstants::END)
+            {
+                if (firstEnd == -1)
+                    firstEnd = project.levels.size();
+                else
+                    level.points = project.levels.at(firstEnd).points;
+            }
+
+            project.levels.push_back(level);
+            current = project.levels.size() - 1;
+        }
+
+        // We're done inserting levels
+        else if (stream.isEndElement() && stream.name() == QString("levelList"))
+            return;
+
+        else if (current == -1)
+            continue;
+
+        else if (stream.isStartElement() && stream.name() == QString("roadPalette"))
+        {
+            QXmlStreamAttributes att = stream.attributes();
+            ProjectLevel& level = project.levels[current];
+            level.gndPal  = getAttInt(att, "ground");
+            level.roadPal = getAttInt(att, "road");
+            level.skyPal  = getAttInt(att, "sky");
+        }
+        else if (stream.isStartElement() && stream.name() == QString("pathData"))
+        {
+            if (project.levels.at(current).type != LevelConstants::END || current == firstEnd)
+                readPathData(stream, project.levels[current]);
+        }
+        else if (stream.isStartElement() && stream.name() == QString("widthData"))   readWidthData(stream, project.levels[current]);
+        else if (stream.isStartElement() && stream.name() == QString("heightData"))  readHeightData(stream, project.levels[current]);
+        else if (stream.isStartElement() && stream.name() == QString("sceneryData")) readSceneryData(stream, project.levels[current]);
+    }
+}
+
+void ProjectFile::readPathData(QXmlStreamReader& stream, ProjectLevel& level)
+{
+    while (stream.readNext() && !stream.atEnd() && !stream.hasError())
+    {
+        if (stream.isStartElement() && stream.name() == QString("point"))
+        {
+            int index = 0;
+            PathPoint rp;
+
+            QXmlStreamAttributes att = stream.attributes();
+            index        = getAttInt(att, "index");
+            rp.pos       = 0;
+            rp.length    = getAttInt(att, "length");
+            rp.angle_inc = getAttInt(att, "angle");
+
+            level.points.insert(index, rp);
+        }
+
+        if (stream.isEndElement() && stream.name() == QString("pathData"))
+            return;
+    }
+}
+
+void ProjectFile::readWidthData(QXmlStreamReader& stream, ProjectLevel& level)
+{
+    while (stream.readNext() && !stream.atEnd() && !stream.hasError())
+    {
+        if (stream.isStartElement() && stream.name() == QString("point"))
+        {
+            int index = 0;
+            ControlPoint cp;
+
+            QXmlStreamAttributes att = stream.attributes();
+            index     = getAttInt(att, "index");
+            cp.pos    = getAttInt(att, "pos");
+            cp.value1 = getAttInt(att, "width");
+            cp.value2 = getAttInt(att, "change");
+
+            level.widthP.insert(index, cp);
+        }
+
+        if (stream.isEndElement() && stream.name() == QString("widthData"))
+            return;
+    }
+}
+
+void ProjectFile::readHeightData(QXmlStreamReader& stream, ProjectLevel& level)
+{
+    while (stream.readNext() && !stream.atEnd() && !stream.hasError())
+    {
+        if (stream.isStartElement() && stream.name() == QString("point"))
+        {
+            int index = 0;
+            ControlPoint cp;
+
+            QXmlStreamAttributes att = stream.attributes();
+            index     = getAttInt(att, "index");
+            cp.pos    = getAttInt(att, "pos");
+            cp.value1 = getAttInt(att, "map");
+            cp.value2 = getAttInt(att, "spinindex");
+
+            level.heightP.insert(index, cp);
+        }
+
+        if (stream.isEndElement() && stream.name() == QString("heightData"))
+            return;
+    }
+}
+
+void ProjectFile::readSceneryData(QXmlStreamReader& stream, ProjectLevel& level)
+{
+    while (stream.readNext() && !stream.atEnd() && !stream.hasError())
+    {
+        if (stream.isStartElement() && stream.name() == QString("point"))
+        {
+            ControlPoint cp;
+
+            QXmlStreamAttributes att = stream.attributes();
+            cp.pos    = getAttInt(att, "pos");
+            cp.value1 = getAttInt(att, "length");
+            cp.value2 = getAttInt(att, "index");
+
+            level.spriteP.push_back(cp);
+        }
+
+        if (stream.isEndElement() && stream.name() == QString("sceneryData"))
+            return;
+    }
+}
+
+void ProjectFile::readHeightMapData(QXmlStreamReader &stream, ProjectSnapshot& project)
+{
+    project.heightMaps.clear();
+
+    HeightSegment seg;
+
+    while (stream.readNext() && !stream.atEnd() && !stream.hasError())
+    {
+        if (stream.isStartElement() && stream.name() == QString("entry"))
+        {
+            seg.data.clear();
+
+            QXmlStreamAttributes att = stream.attributes();
+            seg.name   = getAttString(att, "name");
+            seg.type   = getAttInt   (att, "type");
+            seg.step   = getAttInt   (att, "step");
+            seg.value1 = getAttInt   (att, "value1");
+            seg.value2 = getAttInt   (att, "value2");
+        }
+        else if (stream.isStartElement() && stream.name() == QString("data"))
+        {
+            QXmlStreamAttributes att = stream.attributes();
+            QString values = getAttString(att, "value");
+            QStringList split = values.split(",", Qt::SkipEmptyParts);
+
+            foreach(QString s, split)
+                seg.data.push_back((int16_t) s.toInt());
+        }
+
+        else if (stream.isEndElement() && stream.name() == QString("entry"))
+        {
+            project.heightMaps.push_back(seg);
+        }
+
+        else if (stream.isEndElement() && stream.name() == QString("heightMaps"))
+        {
+            return;
+        }
+    }
+}
+
+void ProjectFile::readSceneryPatternData(QXmlStreamReader &stream, ProjectSnapshot& project)
+{
+    project.spriteMaps.clear();
+    project.spriteNames.clear();
+
+    SpriteSectionEntry section;
+    QStringList spriteNames;
+
+    while (stream.readNext() && !stream.atEnd() && !stream.hasError())
+    {
+        // Start Pattern
+        if (stream.isStartElement() && stream.name() == QString("pattern"))
+        {
+            section.sprites.clear();
+            spriteNames.clear();
+            QXmlStreamAttributes att = stream.attributes();
+            section.name      = getAttString(att, "name");
+            section.selected  = false;
+            section.frequency = getAttInt(att, "freq");
+            section.density   = 0;
+        }
+        // End Pattern
+        else if (stream.isEndElement() && stream.name() == QString("pattern"))
+        {
+            project.spriteMaps.push_back(section);
+            project.spriteNames.push_back(spriteNames);
+        }
+        // Sprite Entry Within Pattern
+        else if (stream.isStartElement() && stream.name() == QString("sprite"))
+        {
+            SpriteEntry sprite;
+            QXmlStreamAttributes att = stream.attributes();
+            spriteNames.push_back(getAttString(att, "name"));
+            sprite.selected = false;
+            sprite.type     = getAttInt(att, "type");
+            sprite.x        = getAttInt(att, "x");
+            sprite.y        = getAttInt(att, "y");
+            sprite.pal      = getAttInt(att, "pal");
+            sprite.props    = getAttInt(att, "props");
+            section.sprites.push_back(sprite);
+        }
+        // End
+        else if (stream.isEndElement() && stream.name() == QString("sceneryPatterns"))
+        {
+            return;
+        }
+    }
+}
+
+void ProjectFile::readSharedPalettes(QXmlStreamReader &stream, ProjectSnapshot& project)
+{
+    while (stream.readNext() && !stream.atEnd() && !stream.hasError())
+    {
+        if (stream.isStartElement() && stream.name() == QString("road"))
+            readPalette(stream, &project.pal.road[0][0], LevelPalette::ROAD_PALS, LevelPalette::ROAD_LENGTH);
+        else if (stream.isStartElement() && stream.name() == QString("ground"))
+            readPalette(stream, &project.pal.gnd[0][0],  LevelPalette::GND_PALS,  LevelPalette::GND_LENGTH);
+        else if (stream.isStartElement() && stream.name() == QString("sky"))
+            readPalette(stream, &project.pal.sky[0][0],  LevelPalette::SKY_PALS,  LevelPalette::SKY_LENGTH);
+        else if (stream.isEndElement() && stream.name() == QString("sharedPalettes"))
+            return;
+    }
+}
+
+// Palettes that are short of entries are left untouched
+void ProjectFile::readPalette(QXmlStreamReader& stream, uint32_t* data, const int pals, const int length)
+{
+    QXmlStreamAttributes att = stream.attributes();
+    QString values = getAttString(att, "value");
+    QStringList split = values.split(",", Qt::SkipEmptyParts);
+
+    if (split.size() < pals * length)
+        return;
+
+    for (int i = 0; i < pals; i++)
+        for (int j = 0; j < length; j++)
+            data[i*length+j] = (uint32_t) split.at(i*length+j).toInt();
+}
+
+// ------------------------------------------------------------------------------------------------
+//                                               SAVING
+// ------------------------------------------------------------------------------------------------
+
+// The existing file is only replaced once the project has been written in full
+bool ProjectFile::write(const QString& filename, const ProjectSnapshot& project, QString* error)
+{
+    QSaveFile file(filename);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        *error = "Unable to write " + filename + ": " + file.errorString();
+        return false;
+    }
+
+    QXmlStreamWriter stream(&file);
+    stream.setAutoFormatting(true);
+    stream.setAutoFormattingIndent(4);
+
+    // Writes a document start with the XML version number version.
+    stream.writeStartDocument();
+    stream.writeStartElement("LayOut");
+        stream.writeAttribute("version", QString::number(SAVE_VERSION));
+
+    // Recovery snapshots only
+    if (project.journalGeneration != 0)
+    {
+        stream.writeStartElement("journal");
+            stream.writeAttribute("generation", QString::number(project.journalGeneration));
+        stream.writeEndElement();
+    }
+
+    // --------------------------------------------------------------------------------------------
+    //                                          LEVELS
+    // --------------------------------------------------------------------------------------------
+    stream.writeStartElement("settings");
+        stream.writeStartElement("startLine");
+            stream.writeAttribute("enabled", QString::number(project.startLine ? 1 : 0));
+        stream.writeEndElement();
+    stream.writeEndElement();
+
+    stream.writeStartElement("levelList");
+        const int numberOfLevels = project.levels.size();
+        stream.writeAttribute("numberOfLevels", QString::number(numberOfLevels));
+        foreach (const ProjectLevel& level, project.levels)
+            writeLevel(stream, level);
+    stream.writeEndElement();
+
+    stream.writeStartElement("levelMapping");
+        for (int i = 0; i < project.mapping.size(); i++)
+        {
+            stream.writeStartElement("stage");
+                stream.writeAttribute("id",      QString::number(i));
+                stream.writeAttribute("mapping", QString::number(project.mapping.at(i)));
+            stream.writeEndElement();
+        }
+
+    stream.writeEndElement();
+
+    // --------------------------------------------------------------------------------------------
+    //                                        SHARED DATA
+    // --------------------------------------------------------------------------------------------
+
+    // Write HeightMaps
+    stream.writeStartElement("heightMaps");
+    foreach (const HeightSegment& seg, project.heightMaps)
+    {
+        stream.writeStartElement("entry");
+            stream.writeAttribute("name",   seg.name);
+            stream.writeAttribute("type",   QString::number(seg.type));
+            stream.writeAttribute("step",   QString::number(seg.step));
+            stream.writeAttribute("value1", QString::number(seg.value1));
+            stream.writeAttribute("value2", QString::number(seg.value2));
+
+            stream.writeStartElement("data");
+                QString values;
+                foreach (int16_t d, seg.data)
+                {
+                    values.append(QString::number(d));
+                    values.append(",");
+                }
+                stream.writeAttribute("value", values);
+            stream.writeEndElement();
+        stream.writeEndElement();
+    }
+    stream.writeEndElement();
+
+    // Write Scenery Patterns
+    stream.writeStartElement("sceneryPatterns");
+    int sectionIndex = 0;
+    int spriteIndex  = 0;
+    foreach (const SpriteSectionEntry& section, project.spriteMaps)
+    {
+        stream.writeStartElement("pattern");
+            stream.writeAttribute("name", section.name);
+            stream.writeAttribute("freq", QString::number(section.frequency));
+            //stream.writeAttribute("noSprites", QString::number(section.sprites.size()));
+
+            spriteIndex = 0;
+            foreach (const SpriteEntry& sprite, section.sprites)
+            {
+                stream.writeStartElement("sprite");
+                    stream.writeAttribute("name",  project.spriteNames.at(sectionIndex).at(spriteIndex++));
+                    stream.writeAttribute("type",  QString::number(sprite.type));
+                    stream.writeAttribute("x",     QString::number(sprite.x));
+                    stream.writeAttribute("y",     QString::number(sprite.y));
+                    stream.writeAttribute("pal",   QString::number(sprite.pal));
+                    stream.writeAttribute("props", QString::number(sprite.props));
+                stream.writeEndElement();
+            }
+            sectionIndex++;
+        stream.writeEndElement(); // end pattern
+    }
+    stream.writeEndElement(); // end sceneryPattern
+
+    // Write Shared Palettes
+    stream.writeStartElement("sharedPalettes");
+        writePalette(stream, "road",   &project.pal.road[0][0], LevelPalette::ROAD_PALS, LevelPalette::ROAD_LENGTH);
+        writePalette(stream, "ground", &project.pal.gnd[0][0],  LevelPalette::GND_PALS,  LevelPalette::GND_LENGTH);
+        writePalette(stream, "sky",    &project.pal.sky[0][0],  LevelPalette::SKY_PALS,  LevelPalette::SKY_LENGTH);
+    stream.writeEndElement(); // end sharedPalettes
+
+    stream.writeEndDocument();
+
+    if (stream.hasError() || !file.commit())
+    {
+        *error = "Unable to write " + filename + ": " + file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void ProjectFile::writeLevel(QXmlStreamWriter& stream, const ProjectLevel& level)
+{
+    stream.writeStartElement("level");
+    stream.writeAttribute("name", level.name);
+    stream.writeAttribute("type", QString::number(level.type));
+
+        // Write Level Palette Data
+        stream.writeStartElement("roadPalette");
+            stream.writeAttribute("ground", QString::number(level.gndPal));
+            stream.writeAttribute("road",   QString::number(level.roadPal));
+            stream.writeAttribute("sky",    QString::number(level.skyPal));
+        stream.writeEndElement();
+
+        // Create tag <pathData> - Subsequent calls to writeAttribute() will add attributes to this element.
+        // Write Path Points
+        stream.writeStartElement("pathData");
+        for (int i = 0; i < level.points.size(); i++)
+        {
+            PathPoint rp = level.points.at(i);
+            stream.writeStartElement("point");
+                stream.writeAttribute("index",  QString::number(i));
+                stream.writeAttribute("length", QString::number(rp.length));
+                stream.writeAttribute("angle",  QString::number(rp.angle_inc));
+            stream.writeEndElement();
+        }
+        stream.writeEndElement();
+
+        // Write Widths
+        stream.writeStartElement("widthData");
+        for (int i = 0; i < level.widthP.size(); i++)
+        {
+            ControlPoint wp = level.widthP.at(i);
+            stream.writeStartElement("point");
+                stream.writeAttribute("index",  QString::number(i));
+                stream.writeAttribute("pos",    QString::number(wp.pos));
+                stream.writeAttribute("width",  QString::number(wp.value1));
+                stream.writeAttribute("change", QString::number(wp.value2));
+            stream.writeEndElement();
+        }
+        stream.writeEndElement();
+
+        // Write Heights
+        stream.writeStartElement("heightData");
+        for (int i = 0; i < level.heightP.size(); i++)
+        {
+            ControlPoint cp = level.heightP.at(i);
+            stream.writeStartElement("point");
+                stream.writeAttribute("index",     QString::number(i));
+                stream.writeAttribute("pos",       QString::number(cp.pos));
+                stream.writeAttribute("map",       QString::number(cp.value1));
+                stream.writeAttribute("spinindex", QString::number(cp.value2));
+            stream.writeEndElement();
+        }
+        stream.writeEndElement();
+
+        // Write Scenery Placements
+        stream.writeStartElement("sceneryData");
+        foreach (ControlPoint cp, level.spriteP)
+        {
+            stream.writeStartElement("point");
+                stream.writeAttribute("pos",       QString::number(cp.pos));
+                stream.writeAttribute("length",    QString::number(cp.value1));
+                stream.writeAttribute("index",     QString::number(cp.value2));
+            stream.writeEndElement();
+        }
+        stream.writeEndElement();
+
+    stream.writeEndElement();
+}
+
+void ProjectFile::writePalette(QXmlStreamWriter& stream, const QString& name, const uint32_t *data, const int pals, const int length)
+{
+    stream.writeStartElement(name);
+        stream.writeAttribute("pals",   QString::number(pals));
+        stream.writeAttribute("length", QString::number(length));
+        QString values;
+        for (int i = 0; i < pals; i++)
+        {
+            for (int j = 0; j < length; j++)
+            {
+                values.append(QString::number(data[i*length+j]));
+                values.append(",");
+            }
+        }
+        stream.writeAttribute("value", values);
+    stream.writeEndElement();
+}
+
+int ProjectFile::getAttInt(const QXmlStreamAttributes& att, const QString& s)
+{
+    if (att.hasAttribute(s))
+        return att.value(s).toString().toInt();
+    else
+        return 0;
+}
+
+QString ProjectFile::getAttString(const QXmlStreamAttributes& att, const QString& s)
+{
+    if (att.hasAttribute(s))
+        return att.value(s).toString();
+    else
+        return NULL;
+}
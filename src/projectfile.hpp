@@ -0,0 +1,59 @@
+/***************************************************************************
+    Layout Project File.
+
+    Reads and writes the XML project format. Projects are read into, and
+    written from, a ProjectSnapshot rather than the editor's models, so
+    files can be handled on any thread, and without the editor.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifndef PROJECTFILE_HPP
+#define PROJECTFILE_HPP
+
+#include "stdint.hpp"
+
+class QString;
+class QXmlStreamAttributes;
+class QXmlStreamReader;
+class QXmlStreamWriter;
+struct ProjectSnapshot;
+struct ProjectLevel;
+
+class ProjectFile
+{
+public:
+    // Read a project over a snapshot. Sections missing from the file are left untouched.
+    static bool read(const QString& filename, ProjectSnapshot& project, QString* error);
+
+    // Write a project. The existing file is only replaced once it has been written in full.
+    static bool write(const QString& filename, const ProjectSnapshot& project, QString* error);
+
+    // Journal generation of a recovery snapshot, without reading the rest of the project. 0 if none.
+    static uint32_t readJournalGeneration(const QString& filename);
+
+private:
+    // Internal LayOut Save Format
+    const static int SAVE_VERSION = 1;
+
+    static void readSettings(QXmlStreamReader& stream, ProjectSnapshot& project);
+    static void readLevelMappingData(QXmlStreamReader& stream, ProjectSnapshot& project);
+    static void readLevelList(QXmlStreamReader& stream, ProjectSnapshot& project);
+    static void readPathData(QXmlStreamReader& stream, ProjectLevel& level);
+    static void readWidthData(QXmlStreamReader& stream, ProjectLevel& level);
+    static void readHeightData(QXmlStreamReader& stream, ProjectLevel& level);
+    static void readSceneryData(QXmlStreamReader& stream, ProjectLevel& level);
+    static void readHeightMapData(QXmlStreamReader& stream, ProjectSnapshot& project);
+    static void readSceneryPatternData(QXmlStreamReader& stream, ProjectSnapshot& project);
+    static void readSharedPalettes(QXmlStreamReader& stream, ProjectSnapshot& project);
+    static void readPalette(QXmlStreamReader& stream, uint32_t* data, const int pals, const int length);
+
+    static void writeLevel(QXmlStreamWriter& stream, const ProjectLevel& level);
+    static void writePalette(QXmlStreamWriter& stream, const QString& name, const uint32_t *data, const int pals, const int length);
+
+    static int getAttInt(const QXmlStreamAttributes& att, const QString& s);
+    static QString getAttString(const QXmlStreamAttributes& att, const QString& s);
+};
+
+#endif // PROJECTFILE_HPP
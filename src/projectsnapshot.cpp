@@ -0,0 +1,59 @@
+/***************************************************************************
+    Project Snapshot.
+
+    A frozen copy of everything saved in a LayOut project, including the
+    names held by the editor's models. Taken on the GUI thread, so the
+    project can be written in the background whilst it is edited.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include "projectsnapshot.hpp"
+#include "levels/levels.hpp"
+#include "height/heightsection.hpp"
+#include "sprites/spritesection.hpp"
+
+ProjectLevel::ProjectLevel(const QString& name, const LevelData* level)
+{
+    this->name = name;
+    type    = level->type;
+    points  = *level->points;
+    widthP  = level->widthP;
+    heightP = level->heightP;
+    spriteP = level->spriteP;
+    skyPal  = level->skyPal;
+    gndPal  = level->gndPal;
+    roadPal = level->roadPal;
+}
+
+ProjectSnapshot::ProjectSnapshot(Levels* levels, HeightSection* heightSection, SpriteSection* spriteSection)
+{
+    startLine = levels->displayStartLine();
+    journalGeneration = 0;
+
+    const QList<LevelData*>* list = levels->getLevels();
+    for (int i = 0; i < list->size(); i++)
+        this->levels.push_back(ProjectLevel(levels->getLevelName(i), list->at(i)));
+
+    mapping.resize(Levels::MAP_SLOTS);
+    for (int i = 0; i < Levels::MAP_SLOTS; i++)
+        mapping[i] = levels->getMappedLevel(i);
+
+    heightMaps = *heightSection->getSectionList();
+    for (int i = 0; i < heightMaps.size(); i++)
+        heightMaps[i].name = heightSection->getSectionName(i);
+
+    spriteMaps = *spriteSection->getSectionList();
+    for (int i = 0; i < spriteMaps.size(); i++)
+    {
+        spriteMaps[i].name = spriteSection->getSectionName(i);
+
+        QStringList names;
+        for (int j = 0; j < spriteMaps.at(i).sprites.size(); j++)
+            names.push_back(spriteSection->getSpriteName(i, j));
+        spriteNames.push_back(names);
+    }
+
+    pal = *levels->getPalette();
+}
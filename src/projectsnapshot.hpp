@@ -0,0 +1,66 @@
+/***************************************************************************
+    Project Snapshot.
+
+    A frozen copy of everything saved in a LayOut project, including the
+    names held by the editor's models. Taken on the GUI thread, so the
+    project can be written in the background whilst it is edited.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifndef PROJECTSNAPSHOT_HPP
+#define PROJECTSNAPSHOT_HPP
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QMetaType>
+#include <QSharedPointer>
+
+#include "controlpoint.hpp"
+#include "leveldata.hpp"
+#include "levels/levelpalette.hpp"
+#include "height/heightformat.hpp"
+#include "sprites/spriteformat.hpp"
+
+class Levels;
+class HeightSection;
+class SpriteSection;
+
+// Copy of a single level, as saved
+struct ProjectLevel
+{
+    QString name;
+    int type;
+    QList<PathPoint> points;
+    QList<ControlPoint> widthP;
+    QList<ControlPoint> heightP;
+    QList<ControlPoint> spriteP;
+    uint16_t skyPal;
+    uint16_t gndPal;
+    uint16_t roadPal;
+
+    ProjectLevel() : type(0), skyPal(0), gndPal(0), roadPal(0) {}
+    ProjectLevel(const QString& name, const LevelData* level);
+};
+
+struct ProjectSnapshot
+{
+    bool startLine;                          // Display start line
+    QList<ProjectLevel> levels;
+    QVector<int> mapping;                    // Level in each map slot
+    QList<HeightSegment> heightMaps;         // Named as in the height pattern list
+    QList<SpriteSectionEntry> spriteMaps;    // Named as in the scenery pattern list
+    QList<QStringList> spriteNames;          // Names of the sprites in each scenery pattern
+    LevelPalette pal;                        // Palettes shared by all levels
+    uint32_t journalGeneration;              // Journal the recovery snapshot belongs to (or 0)
+
+    ProjectSnapshot() : startLine(false), pal(), journalGeneration(0) {}
+    ProjectSnapshot(Levels* levels, HeightSection* heightSection, SpriteSection* spriteSection);
+};
+
+Q_DECLARE_METATYPE(QSharedPointer<const ProjectSnapshot>)
+
+#endif // PROJECTSNAPSHOT_HPP
@@ -14,12 +14,14 @@
 #include "roadpathwidget.hpp"
 #include "leveldata.hpp"
 #include "utils.hpp"
+#include "preview/spritebudget.hpp"
 #include "roadpathscene.hpp"
 
 RoadPathScene::RoadPathScene(RoadPathWidget *parent) :
     QGraphicsScene((QObject*) parent)
 {
     this->parent = parent;
+    level        = NULL;
 }
 
 int RoadPathScene::getCPSize()
@@ -49,7 +51,7 @@ void RoadPathScene::drawBackground(QPainter *painter, const QRectF &rect)
 
             for (int i = 0; i <= currentCP; i++)
             {
-                PathPoint rp = levelData->points->at(i);
+                PathPoint rp = level->points->at(i);
 
                 if (i == currentCP)
                 {
@@ -93,6 +95,8 @@ void RoadPathScene::drawBackground(QPainter *painter, const QRectF &rect)
         case STATE_HEIGHT:
         case STATE_SCENERY:
             drawWidth(painter, highlightStart, highlightEnd);
+            if (state == STATE_SCENERY)
+                drawSpriteLoad(painter);
             drawPath(painter, highlightStart, highlightEnd);
             drawControlPoints(painter, state == STATE_SCENERY ? SCENERY_SIZE : CP_SIZE);
             drawTooltip(painter);
@@ -105,9 +109,9 @@ void RoadPathScene::drawForeground(QPainter *painter, const QRectF &rect)
     const int roadPos = parent->getRoadPos();
 
     // Draw Road Position Marker
-    if (roadPos != -1 && levelData->end_pos > 0)
+    if (roadPos != -1 && level->end_pos > 0)
     {
-        WidthRender *wr = &levelData->width_render[roadPos];
+        const WidthRender *wr = &level->width_render[roadPos];
         QPen pen;
         pen.setWidth(3);
         pen.setColor(QColor(0, 0, 255, 255));
@@ -118,10 +122,10 @@ void RoadPathScene::drawForeground(QPainter *painter, const QRectF &rect)
         painter->setPen(pen);
 
         int pointTip = parent->getRoadPos() + 8;
-        if (pointTip < levelData->end_pos)
+        if (pointTip < level->end_pos)
         {
-            painter->drawLine(wr->road1_rhs, levelData->posToPoint(pointTip));
-            painter->drawLine(wr->road2_rhs, levelData->posToPoint(pointTip));
+            painter->drawLine(wr->road1_rhs, level->posToPoint(pointTip));
+            painter->drawLine(wr->road2_rhs, level->posToPoint(pointTip));
         }
     }
 }
@@ -132,7 +136,7 @@ void RoadPathScene::drawPathPoints(QPainter* painter)
     pen.setWidth(2);
 
     // Draw the road path control points
-    for (int i = 0; i < levelData->points->size(); i++)
+    for (int i = 0; i < level->points->size(); i++)
     {
         if (i == parent->getCurrentCP())
         {
@@ -147,7 +151,7 @@ void RoadPathScene::drawPathPoints(QPainter* painter)
 
         painter->setPen(pen);
 
-        PathPoint rp = levelData->points->at(i);
+        PathPoint rp = level->points->at(i);
         painter->drawEllipse(QRectF(rp.p.x() - CP_SIZE,
                                     rp.p.y() - CP_SIZE,
                                     CP_SIZE*2, CP_SIZE*2));
@@ -176,7 +180,7 @@ void RoadPathScene::drawControlPoints(QPainter* painter, const int size)
         painter->setPen(pen);
 
         ControlPoint wp = cps->at(i);
-        QPoint p = levelData->posToPoint(wp.pos);
+        QPoint p = level->posToPoint(wp.pos);
         painter->drawEllipse(QRectF(p.x() - size,
                                     p.y() - size,
                                     size*2, size*2));
@@ -191,7 +195,7 @@ void RoadPathScene::drawPath(QPainter* painter, int highlightStart, int highligh
     painter->setPen(pen);
 
     // Paint road path including highlighted section
-    for (int i = 0; i < levelData->end_pos; i += LINE_OFFSET)
+    for (int i = 0; i < level->end_pos; i += LINE_OFFSET)
     {
         if (i == highlightStart)
         {
@@ -204,8 +208,8 @@ void RoadPathScene::drawPath(QPainter* painter, int highlightStart, int highligh
             painter->setPen(pen);
         }
 
-        QPoint p1 = levelData->posToPoint(i);
-        QPoint p2 = levelData->posToPoint(qMin(i+LINE_OFFSET, levelData->end_pos-1));
+        QPoint p1 = level->posToPoint(i);
+        QPoint p2 = level->posToPoint(qMin(i+LINE_OFFSET, level->end_pos-1));
         painter->drawLine(p1, p2);
     }
 }
@@ -217,13 +221,13 @@ void RoadPathScene::drawWidth(QPainter *painter, int highlightStart, int highlig
     bool colorToggle = false;
 
     // Paint Both Roads
-    for (int i = 0; i < levelData->end_pos; i += LINE_OFFSET)
+    for (int i = 0; i < level->end_pos; i += LINE_OFFSET)
     {
-        WidthRender* wr1 = &levelData->width_render[i];
-        WidthRender* wr2 = &levelData->width_render[qMin(i+LINE_OFFSET, levelData->end_pos-1)];
+        const WidthRender* wr1 = &level->width_render[i];
+        const WidthRender* wr2 = &level->width_render[qMin(i+LINE_OFFSET, level->end_pos-1)];
 
-        uint32_t color1 = levelData->pal->road[levelData->roadPal][LevelPalette::ROAD1];
-        uint32_t color2 = levelData->pal->road[levelData->roadPal][LevelPalette::ROAD2];
+        uint32_t color1 = level->pal->road[level->roadPal][LevelPalette::ROAD1];
+        uint32_t color2 = level->pal->road[level->roadPal][LevelPalette::ROAD2];
         if (colorToggle)
         {
             color1 &= 0xFFFFF;
@@ -287,6 +291,44 @@ void RoadPathScene::drawWidth(QPainter *painter, int highlightStart, int highlig
     }
 }
 
+// Heatmap of the sprite hardware load along the path.
+// Green is empty, red is full and magenta is where sprites are dropped.
+void RoadPathScene::drawSpriteLoad(QPainter *painter)
+{
+    // Measured for a different version of the level
+    if (spriteLoad.size() != level->end_pos)
+        return;
+
+    QPen pen;
+    pen.setWidth(CP_SIZE);
+    pen.setCapStyle(Qt::FlatCap);
+
+    for (int i = 0; i < level->end_pos; i += LINE_OFFSET)
+    {
+        const int end = qMin(i + LINE_OFFSET, level->end_pos - 1);
+
+        // Use the busiest position of each line
+        int load    = 0;
+        int dropped = 0;
+        for (int pos = i; pos <= end; pos++)
+        {
+            load    = qMax(load, spriteLoad.at(pos).sprites + spriteLoad.at(pos).shadows);
+            dropped = qMax(dropped, (int) spriteLoad.at(pos).dropped);
+        }
+
+        if (dropped > 0)
+            pen.setColor(QColor(255, 0, 255, 200));
+        else
+        {
+            const int heat = qMin((load * 510) / SpriteBudget::LIMIT, 510);
+            pen.setColor(QColor(qMin(heat, 255), qMin(510 - heat, 255), 0, 160));
+        }
+
+        painter->setPen(pen);
+        painter->drawLine(level->posToPoint(i), level->posToPoint(end));
+    }
+}
+
 // ------------------------------------------------------------------------------------------------
 // Tooltips
 // ------------------------------------------------------------------------------------------------
@@ -12,8 +12,11 @@
 #define ROADPATHSCENE_HPP
 
 #include <QGraphicsScene>
+#include <QVector>
+#include "preview/previewrenderer.hpp"
 
 class RoadPathWidget;
+class LevelData;
 struct ControlPoint;
 
 class RoadPathScene : public QGraphicsScene
@@ -36,6 +39,12 @@ public:
     // Control Points (These Change Depending On The Viewing State)
     QList<ControlPoint> *cps;
 
+    // Level being drawn. Set by the owning RoadPathWidget.
+    const LevelData* level;
+
+    // Sprite hardware load at each position of the level (if measured)
+    QVector<SpriteLoad> spriteLoad;
+
     explicit RoadPathScene(RoadPathWidget *parent = 0);
     bool isWidthHeightSceneMode();
     void createTooltip(QString text, QPoint p);
@@ -65,6 +74,7 @@ private:
     void drawPathPoints(QPainter* painter);
     void drawPath(QPainter *painter, int highlightStart = -1, int highlightEnd = -1);
     void drawWidth(QPainter *painter, int highlightStart = -1, int highlightEnd = -1);
+    void drawSpriteLoad(QPainter *painter);
     void drawTooltip(QPainter* painter);  
 };
 
@@ -12,13 +12,16 @@
 #include "globals.hpp"
 #include "roadpathwidget.hpp"
 #include "leveldata.hpp"
+#include "preview/spritebudget.hpp"
 
 RoadPathWidget::RoadPathWidget(QWidget *parent)
     : QGraphicsView(parent)
 { 
     setMouseTracking(true); // Receive mouse events even when button not pressed
 
-    scene = new RoadPathScene(this);
+    scene  = new RoadPathScene(this);
+    level  = NULL;
+    budget = NULL;
     this->setOptimizationFlag(QGraphicsView::DontSavePainterState);
     this->setOptimizationFlag(QGraphicsView::DontAdjustForAntialiasing);
     //this->setRenderHint(QPainter::Antialiasing);
@@ -49,8 +52,8 @@ void RoadPathWidget::init()
     this->setAlignment(Qt::AlignCenter);
 
     roadLengthChanged();
-    scene->setSceneRect(levelData->getPathRect());
-    this->centerOn(levelData->posToPoint(0));
+    scene->setSceneRect(level->getPathRect());
+    this->centerOn(level->posToPoint(0));
     this->setDragMode(QGraphicsView::ScrollHandDrag);
     this->show();
 }
@@ -65,6 +68,36 @@ void RoadPathWidget::setSpriteSection(SpriteSection* section)
     spriteSection = section;
 }
 
+void RoadPathWidget::setChanges(LevelChanges* changes)
+{
+    this->changes = changes;
+}
+
+// Level to edit. Call init() afterwards to reset the view.
+void RoadPathWidget::setLevel(LevelData* level)
+{
+    this->level  = level;
+    scene->level = level;
+
+    // Measured for the previous level
+    scene->spriteLoad.clear();
+}
+
+// Sprite load of the level, shown when editing scenery
+void RoadPathWidget::setSpriteBudget(SpriteBudget* budget)
+{
+    this->budget = budget;
+    connect(budget, SIGNAL(loadChanged()), this, SLOT(spriteLoadChanged()));
+}
+
+void RoadPathWidget::spriteLoadChanged()
+{
+    scene->spriteLoad = budget->getLoad();
+
+    if (scene->state == RoadPathScene::STATE_SCENERY)
+        scene->update();
+}
+
 // ------------------------------------------------------------------------------------------------
 // RoadPathScene::STATEs
 // ------------------------------------------------------------------------------------------------
@@ -87,8 +120,8 @@ void RoadPathWidget::setStateWidth()
 {
     scene->state = RoadPathScene::STATE_WIDTH;
     activePoint = &activeWidthPoint;
-    scene->cps = &levelData->widthP;
-    levelData->updateWidthData();
+    scene->cps = &level->widthP;
+    level->updateWidthData();
     updateControls();
     updateScene();
 }
@@ -97,7 +130,7 @@ void RoadPathWidget::setStateHeight()
 {
     scene->state = RoadPathScene::STATE_HEIGHT;
     activePoint = &activeHeightPoint;
-    scene->cps = &levelData->heightP;
+    scene->cps = &level->heightP;
     updateControls();
     updateScene();
 }
@@ -106,7 +139,7 @@ void RoadPathWidget::setStateScenery()
 {
     scene->state = RoadPathScene::STATE_SCENERY;
     activePoint = &activeSceneryPoint;
-    scene->cps = &levelData->spriteP;
+    scene->cps = &level->spriteP;
     updateControls();
     updateScene();
 }
@@ -145,12 +178,12 @@ void RoadPathWidget::setView(int view)
 
 void RoadPathWidget::setRoadPos(int value)
 {
-    if (value < levelData->end_pos)
+    if (value < level->end_pos)
         roadPos = value;
 
     if (centreViewPoint)
     {
-        this->centerOn(levelData->posToPoint(roadPos));
+        this->centerOn(level->posToPoint(roadPos));
 
         // Rotate To Angle
         /*if (roadPos != -1 && roaddata->end_pos > 0)
@@ -179,15 +212,16 @@ void RoadPathWidget::setLength(int value)
 {
     if (*activePoint != -1)
     {
-        PathPoint* rp = &(*levelData->points)[*activePoint];
+        PathPoint* rp = &(*level->points)[*activePoint];
 
         // Update Length
         if (value != rp->length)
         {
-            levelData->changePathLength(*activePoint, value);
-            levelData->updatePathData();
-            scene->setSceneRect(levelData->getPathRect());
+            level->changePathLength(*activePoint, value);
+            level->updatePathData();
+            scene->setSceneRect(level->getPathRect());
             roadLengthChanged();
+            pathChanged(rp->pos, true);
             emit refreshPreview(roadPos);
             updateScene();
         }
@@ -204,7 +238,8 @@ void RoadPathWidget::setWidth(int value)
         {
             cp.value1 = value;
             scene->cps->replace(*activePoint, cp);
-            levelData->updateWidthData();
+            level->updateWidthData();
+            pointsChanged(cp.pos);
             emit refreshPreview(roadPos);
             updateScene();
         }
@@ -221,6 +256,7 @@ void RoadPathWidget::setPoint(int value)
         {
             cp.value1 = value;
             scene->cps->replace(*activePoint, cp);
+            pointsChanged(cp.pos);
             emit refreshPreview();
         }
     }
@@ -230,15 +266,16 @@ void RoadPathWidget::setAngle(int value)
 {
     if (*activePoint != -1)
     {
-        PathPoint rp = levelData->points->at(*activePoint);
+        PathPoint rp = level->points->at(*activePoint);
 
         // Update Angle
         if (value != rp.angle_inc)
         {
             rp.angle_inc = value;
-            levelData->points->replace(*activePoint, rp);
-            levelData->updatePathData();
-            scene->setSceneRect(levelData->getPathRect());
+            level->points->replace(*activePoint, rp);
+            level->updatePathData();
+            scene->setSceneRect(level->getPathRect());
+            pathChanged(rp.pos);
             emit refreshPreview(roadPos);
             updateScene();
         }
@@ -255,7 +292,8 @@ void RoadPathWidget::setWidthChange(int value)
         {
             wp.value2 = value;
             scene->cps->replace(*activePoint, wp);
-            levelData->updateWidthData();
+            level->updateWidthData();
+            pointsChanged(wp.pos);
             emit refreshPreview(roadPos);
             updateScene();
         }
@@ -264,15 +302,16 @@ void RoadPathWidget::setWidthChange(int value)
 
 void RoadPathWidget::insertPointAfter()
 {
-    levelData->insertPathPoint((*activePoint) + 1);
+    level->insertPathPoint((*activePoint) + 1);
     (*activePoint)++;
-    levelData->updatePathData();
-    scene->setSceneRect(levelData->getPathRect());
+    level->updatePathData();
+    scene->setSceneRect(level->getPathRect());
 
-    PathPoint rp = levelData->points->at(*activePoint);
-    this->centerOn(levelData->posToPoint(rp.pos));
+    PathPoint rp = level->points->at(*activePoint);
+    this->centerOn(level->posToPoint(rp.pos));
 
     roadLengthChanged();
+    pathChanged(rp.pos, true);
 
     emit refreshPreview(roadPos);
     updateScene();
@@ -283,14 +322,15 @@ void RoadPathWidget::insertPointBefore()
 {
     if (*activePoint < 0)
         *activePoint = 0;
-    levelData->insertPathPoint(*activePoint);
-    levelData->updatePathData();
-    scene->setSceneRect(levelData->getPathRect());
+    level->insertPathPoint(*activePoint);
+    level->updatePathData();
+    scene->setSceneRect(level->getPathRect());
 
-    PathPoint rp = levelData->points->at(*activePoint);
-    this->centerOn(levelData->posToPoint(rp.pos));
+    PathPoint rp = level->points->at(*activePoint);
+    this->centerOn(level->posToPoint(rp.pos));
 
     roadLengthChanged();
+    pathChanged(rp.pos, true);
 
     emit refreshPreview(roadPos);
     updateScene();
@@ -304,17 +344,20 @@ void RoadPathWidget::manipulatePoint(int point, int pos)
         // Delete Existing Point
         if (point != -1)
         {
-            levelData->deletePathPoint(point);
+            const int deletePos = level->points->at(point).pos;
+            level->deletePathPoint(point);
             *activePoint = -1;
-            levelData->updatePathData();
-            scene->setSceneRect(levelData->getPathRect());
+            level->updatePathData();
+            scene->setSceneRect(level->getPathRect());
             roadLengthChanged();
+            pathChanged(deletePos, true);
             emit refreshPreview(roadPos);
         }
         // Split Existing Point
         else
         {
-            *activePoint = levelData->splitPathPoints(pos);
+            *activePoint = level->splitPathPoints(pos);
+            pathChanged(pos);
         }
         updateScene();
         updateControls();
@@ -323,12 +366,14 @@ void RoadPathWidget::manipulatePoint(int point, int pos)
     {
         if (point != -1)
         {
+            const int deletePos = scene->cps->at(point).pos;
             scene->cps->removeAt(point);
             *activePoint = -1;
 
             if (scene->state == RoadPathScene::STATE_WIDTH)
-                levelData->updateWidthData();
+                level->updateWidthData();
 
+            pointsChanged(deletePos);
             emit refreshPreview(roadPos);
             updateScene();
             updateControls();
@@ -354,7 +399,7 @@ void RoadPathWidget::updateControls()
         else
         {
             emit enableControls(true);
-            PathPoint rp = levelData->points->at(*activePoint);
+            PathPoint rp = level->points->at(*activePoint);
             updateStatus(rp.pos);
             emit changeLength(rp.length);
             emit changeAngle(rp.angle_inc);
@@ -404,7 +449,7 @@ void RoadPathWidget::updateControls()
         else
         {
             emit enableControls(true);
-            emit selectScenerySection(levelData->spriteP.at(*activePoint).value2);
+            emit selectScenerySection(level->spriteP.at(*activePoint).value2);
             ControlPoint cp = scene->cps->at(*activePoint);
             emit changePatternLength(cp.value1);
         }
@@ -430,9 +475,9 @@ int RoadPathWidget::getNearestRP(QPointF mousePos)
     qreal distance = -1;
     int point = -1;
 
-    for (int i = 0; i < levelData->points->size(); i++)
+    for (int i = 0; i < level->points->size(); i++)
     {
-        PathPoint rp = levelData->points->at(i);
+        PathPoint rp = level->points->at(i);
         qreal d = QLineF(mousePos, rp.p).length();
         if ((distance < 0 && d < RoadPathScene::CP_SIZE * 2) || d < distance)
         {
@@ -454,7 +499,7 @@ int RoadPathWidget::getNearestCP(QPointF mousePos)
     for (int i = 0; i < scene->cps->size(); i++)
     {
         ControlPoint wp = scene->cps->at(i);
-        QPoint p = levelData->posToPoint(wp.pos);
+        QPoint p = level->posToPoint(wp.pos);
         qreal d = QLineF(mousePos, p).length();
         if ((distance < 0 && d < scene->getCPSize() * 2) || d < distance)
         {
@@ -479,11 +524,11 @@ int RoadPathWidget::getPosInLevel(QPointF pos)
             int activePos = scene->cps->at(*activePoint).pos;
 
             int startPos = qMax(0, activePos - 20);
-            int endPos   = qMin(levelData->end_pos, activePos + 20);
+            int endPos   = qMin(level->end_pos, activePos + 20);
 
             for (int i = startPos; i < endPos; i++)
             {
-                QPoint p = levelData->posToPoint(i);
+                QPoint p = level->posToPoint(i);
                 qreal d = QLineF(pos, p).length();
                 if ((distance < 0 && d < RoadPathScene::CP_SIZE * 2) || d < distance)
                 {
@@ -498,9 +543,9 @@ int RoadPathWidget::getPosInLevel(QPointF pos)
     }
 
 
-    for (int i = 0; i < levelData->end_pos; i++)
+    for (int i = 0; i < level->end_pos; i++)
     {
-        QPoint p = levelData->posToPoint(i);
+        QPoint p = level->posToPoint(i);
 
         qreal d = QLineF(pos, p).length();
         if ((distance < 0 && d < RoadPathScene::CP_SIZE * 2) || d < distance)
@@ -524,11 +569,36 @@ void RoadPathWidget::updateStatus(int insert_pos)
 void RoadPathWidget::roadLengthChanged()
 {
     // Toggle insert button based on whether we have space for more road
-    emit enableInsert(levelData->end_pos < levelData->length);
+    emit enableInsert(level->end_pos < level->length);
 
-    int percentage = ((float) levelData->end_pos / (float) levelData->length) * 100.0f;
+    int percentage = ((float) level->end_pos / (float) level->length) * 100.0f;
     emit setPercentage(percentage);
-    emit setEndPos(levelData->end_pos);
+    emit setEndPos(level->end_pos);
+}
+
+// Report a change to the path from this position onwards.
+// Changing the length of the path also moves the control points that follow.
+void RoadPathWidget::pathChanged(int startPos, bool pointsMoved)
+{
+    changes->notifyPath(startPos, level->end_pos);
+
+    if (pointsMoved)
+    {
+        changes->notifyWidth(startPos);
+        changes->notifyHeightPoints();
+        changes->notifySceneryPoints();
+    }
+}
+
+// Report a change to the control points being edited
+void RoadPathWidget::pointsChanged(int startPos)
+{
+    switch (scene->state)
+    {
+        case RoadPathScene::STATE_WIDTH:   changes->notifyWidth(startPos);   break;
+        case RoadPathScene::STATE_HEIGHT:  changes->notifyHeightPoints();    break;
+        case RoadPathScene::STATE_SCENERY: changes->notifySceneryPoints();   break;
+    }
 }
 
 // Get length of a particular height section
@@ -537,7 +607,7 @@ int RoadPathWidget::getHeightSegLength(int index)
     // Length of each height segment
     const static double POS_LENGTH = 10 * 12;
 
-    ControlPoint cp   = levelData->heightP.at(index);
+    ControlPoint cp   = level->heightP.at(index);
     QList<HeightSegment>* heightMaps = heightSection->getSectionList();
     HeightSegment seg = heightMaps->at(cp.value1);
 
@@ -629,7 +699,7 @@ void RoadPathWidget::updateScene()
 {
     scene->clear();
 
-    if (levelData->end_pos < 1)
+    if (level->end_pos < 1)
         return;
 
     scene->update();
@@ -699,12 +769,14 @@ void RoadPathWidget::mousePressEvent(QMouseEvent *e)
                     switch (scene->state)
                     {
                     case RoadPathScene::STATE_WIDTH:
-                        *activePoint = levelData->insertWidthPoint(insertPos);
+                        *activePoint = level->insertWidthPoint(insertPos);
+                        pointsChanged(insertPos);
                         updateScene();
                         break;
 
                     case RoadPathScene::STATE_HEIGHT:
-                        *activePoint = levelData->insertHeightPoint(insertPos);
+                        *activePoint = level->insertHeightPoint(insertPos);
+                        pointsChanged(insertPos);
                         emit refreshPreview();
                         updateScene();
                         break;
@@ -712,7 +784,8 @@ void RoadPathWidget::mousePressEvent(QMouseEvent *e)
                     case RoadPathScene::STATE_SCENERY:
                         if (spriteSection->getSectionList()->size() > 0)
                         {
-                            *activePoint = levelData->insertSceneryPoint(insertPos);
+                            *activePoint = level->insertSceneryPoint(insertPos);
+                            pointsChanged(insertPos);
                             emit refreshPreview();
                             updateScene();
                         }
@@ -814,7 +887,7 @@ void RoadPathWidget::mouseMoveEvent(QMouseEvent *e)
             int point = getNearestCP(mapToScene(e->pos()));
             if (point != -1)
             {
-                QPoint p = levelData->posToPoint(scene->cps->at(point).pos);
+                QPoint p = level->posToPoint(scene->cps->at(point).pos);
 
                 if (scene->state == RoadPathScene::STATE_WIDTH)
                 {
@@ -843,6 +916,7 @@ void RoadPathWidget::mouseMoveEvent(QMouseEvent *e)
             this->setDragMode(QGraphicsView::NoDrag);
 
             ControlPoint wp = scene->cps->at(*activePoint);
+            const int changePos = qMin(wp.pos, mousePos);
             wp.pos = mousePos;
 
             // Check whether to erase the upcoming point
@@ -864,7 +938,8 @@ void RoadPathWidget::mouseMoveEvent(QMouseEvent *e)
             scene->cps->replace(*activePoint, wp);
 
             if (scene->state == RoadPathScene::STATE_WIDTH)
-                levelData->updateWidthData();
+                level->updateWidthData();
+            pointsChanged(changePos);
             updateScene();
         }
     }
@@ -15,6 +15,10 @@
 #include "roadpathscene.hpp"
 #include "height/heightsection.hpp"
 #include "sprites/spritesection.hpp"
+#include "levelchanges.hpp"
+
+class LevelData;
+class SpriteBudget;
 
 class RoadPathWidget : public QGraphicsView
 {
@@ -33,6 +37,9 @@ public:
     void init();
     void setHeightSection(HeightSection* section);
     void setSpriteSection(SpriteSection* section);
+    void setChanges(LevelChanges* changes);
+    void setLevel(LevelData* level);
+    void setSpriteBudget(SpriteBudget* budget);
     void setStatePath();
     void setStateWidth();
     void setStateHeight();
@@ -74,6 +81,9 @@ public slots:
     void insertPointAfter();
     void insertPointBefore();
 
+private slots:
+    void spriteLoadChanged();
+
 protected:
     void mousePressEvent(QMouseEvent *event);
     void mouseDoubleClickEvent(QMouseEvent *event);
@@ -84,6 +94,9 @@ protected:
 private:
     HeightSection* heightSection;
     SpriteSection* spriteSection;
+    LevelChanges* changes;
+    LevelData* level;
+    SpriteBudget* budget;
 
     // Selected Points for each mode
     int* activePoint;
@@ -117,6 +130,8 @@ private:
     int getNearestRP(QPointF mousePos);
     int getNearestCP(QPointF mousePos);
     void roadLengthChanged();
+    void pathChanged(int startPos, bool pointsMoved = false);
+    void pointsChanged(int startPos);
     void manipulatePoint(int point, int pos);
 };
 
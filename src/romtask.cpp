@@ -0,0 +1,169 @@
+/***************************************************************************
+    ROM Task.
+
+    Loads the ROMs in the background, in stages, so the editor is usable
+    whilst they load. Everything is decoded into new objects, which are
+    handed to the GUI thread as each stage finishes. The ROMs currently
+    in use are left alone.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <QThread>
+#include <QtConcurrent>
+
+#include "import/importoutrun.hpp"
+#include "sprites/sprite.hpp"
+#include "utils.hpp"
+#include "romtask.hpp"
+
+RomTask::RomTask(QObject* parent, const QString& path) :
+    QObject(parent)
+{
+    this->path    = path;
+    guiThread     = QThread::currentThread();
+    roms          = NULL;
+    romsTaken     = false;
+    spriteData    = NULL;
+    spritePalette = NULL;
+
+    connect(this,     SIGNAL(workerStage(int)), this, SLOT(stageDone(int)), Qt::QueuedConnection);
+    connect(&watcher, SIGNAL(finished()),       this, SLOT(done()));
+}
+
+RomTask::~RomTask()
+{
+    cancel();
+    wait();
+
+    // Results that were never taken
+    delete renderers.preview;
+    delete renderers.budget;
+    delete renderers.profiler;
+    delete[] spriteData;
+    delete[] spritePalette;
+    if (!romsTaken)
+        delete roms;
+}
+
+void RomTask::start()
+{
+    cancelled.storeRelease(0);
+    watcher.setFuture(QtConcurrent::run(this, &RomTask::run));
+}
+
+void RomTask::wait()
+{
+    watcher.waitForFinished();
+}
+
+bool RomTask::isRunning() const
+{
+    return watcher.isRunning();
+}
+
+void RomTask::cancel()
+{
+    cancelled.storeRelease(1);
+}
+
+QString RomTask::getStageName(int stage)
+{
+    switch (stage)
+    {
+        case LOAD_ROMS:      return "Loading ROMs";
+        case DECODE_TABLES:  return "Decoding level data";
+        case DECODE_SPRITES: return "Decoding sprites";
+        case BUILD_PREVIEW:  return "Preparing preview";
+    }
+    return QString();
+}
+
+// ------------------------------------------------------------------------------------------------
+// Results
+// ------------------------------------------------------------------------------------------------
+
+ImportOutRun* RomTask::takeRoms()
+{
+    romsTaken = true;
+    return roms;
+}
+
+uint32_t* RomTask::takeSpriteData()
+{
+    uint32_t* data = spriteData;
+    spriteData = NULL;
+    return data;
+}
+
+QRgb* RomTask::takeSpritePalette()
+{
+    QRgb* pal = spritePalette;
+    spritePalette = NULL;
+    return pal;
+}
+
+PreviewRenderers RomTask::takeRenderers()
+{
+    PreviewRenderers r = renderers;
+    renderers = PreviewRenderers();
+    return r;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Worker
+// ------------------------------------------------------------------------------------------------
+
+// Results are only read by the GUI thread once their stage is reported. The ROMs are only
+// read from once they have been loaded, so can be shared with the GUI thread from then on.
+bool RomTask::run()
+{
+    roms = new ImportOutRun();
+    if (!roms->loadRevBRoms(path))
+        return false;
+    emit workerStage(LOAD_ROMS);
+
+    if (cancelled.loadAcquire())
+        return false;
+
+    roms->loadSpriteList(); // Decodes and caches every table
+    emit workerStage(DECODE_TABLES);
+
+    if (cancelled.loadAcquire())
+        return false;
+
+    QRgb* pal  = Utils::convertEntirePaletteToQT(roms->getPaletteData());
+    spriteData = Sprite::decodeSpriteRom(roms->sprites.rom, roms->sprites.length);
+    spritePalette = pal;
+    emit workerStage(DECODE_SPRITES);
+
+    if (cancelled.loadAcquire())
+        return false;
+
+    PreviewRenderers r;
+    r.preview  = new PreviewRenderer(&roms->rom0, &roms->sprites, &roms->rom1, &roms->road);
+    r.budget   = new PreviewRenderer(&roms->rom0, &roms->sprites, &roms->rom1, &roms->road);
+    r.profiler = new PreviewRenderer(&roms->rom0, &roms->sprites, &roms->rom1, &roms->road);
+
+    // Created on this thread, so must be pushed to the GUI thread before they can be moved on
+    r.preview->moveToThread(guiThread);
+    r.budget->moveToThread(guiThread);
+    r.profiler->moveToThread(guiThread);
+
+    renderers = r;
+    emit workerStage(BUILD_PREVIEW);
+
+    return true;
+}
+
+void RomTask::stageDone(int stage)
+{
+    emit stageFinished(stage);
+}
+
+void RomTask::done()
+{
+    if (cancelled.loadAcquire() == 0)
+        emit finished(watcher.result());
+}
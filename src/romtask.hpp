@@ -0,0 +1,85 @@
+/***************************************************************************
+    ROM Task.
+
+    Loads the ROMs in the background, in stages, so the editor is usable
+    whilst they load. Everything is decoded into new objects, which are
+    handed to the GUI thread as each stage finishes. The ROMs currently
+    in use are left alone.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifndef ROMTASK_HPP
+#define ROMTASK_HPP
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QRgb>
+
+#include "preview/previewrenderer.hpp"
+
+class QThread;
+class ImportOutRun;
+
+class RomTask : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Stages, in the order they are run
+    enum
+    {
+        LOAD_ROMS,      // Load and interleave the ROM files
+        DECODE_TABLES,  // Level, pattern and sprite tables from the program ROMs
+        DECODE_SPRITES, // Sprite palette and sprite ROM, used by the editor
+        BUILD_PREVIEW,  // Road and sprite graphics, decoded by the preview renderers
+        STAGES
+    };
+
+    RomTask(QObject* parent, const QString& path);
+    ~RomTask();
+
+    void start();
+    void wait();
+    bool isRunning() const;
+    static QString getStageName(int stage);
+
+    // Results are valid once their stage has finished. Ownership passes to the caller.
+    ImportOutRun* takeRoms();           // After DECODE_TABLES
+    uint32_t* takeSpriteData();         // After DECODE_SPRITES
+    QRgb* takeSpritePalette();          // After DECODE_SPRITES
+    PreviewRenderers takeRenderers();   // After BUILD_PREVIEW
+
+signals:
+    void stageFinished(int stage);
+    void finished(bool success);
+
+    // From the worker thread. Queued to this object, so nothing is delivered once it is deleted.
+    void workerStage(int stage);
+
+public slots:
+    void cancel();
+
+private slots:
+    void stageDone(int stage);
+    void done();
+
+private:
+    QString path;
+    QThread* guiThread;
+
+    ImportOutRun* roms;
+    bool romsTaken;
+    uint32_t* spriteData;
+    QRgb* spritePalette;
+    PreviewRenderers renderers;
+
+    QAtomicInt cancelled;
+    QFutureWatcher<bool> watcher;
+
+    bool run();
+};
+
+#endif // ROMTASK_HPP
@@ -0,0 +1,21 @@
+/***************************************************************************
+    System 16 Colour Conversion.
+
+    Lookup tables to convert System 16 palette entries to RGB.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include "s16colour.hpp"
+
+// Filled during static initialisation. Evaluating 32768 entries at compile time would
+// exceed the constant evaluation limits of some compilers.
+S16ColourTable::S16ColourTable(bool shadow)
+{
+    for (int i = 0; i < ENTRIES; i++)
+        rgb[i] = s16ToRgb(i, shadow);
+}
+
+const S16ColourTable S16_RGB(false);
+const S16ColourTable S16_RGB_SHADOW(true);
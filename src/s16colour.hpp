@@ -0,0 +1,62 @@
+/***************************************************************************
+    System 16 Colour Conversion.
+
+    Lookup tables to convert System 16 palette entries to RGB.
+
+    Both tables are generated once at startup and shared by the preview,
+    the palette widgets and the utility functions, so that every colour
+    shown by the editor is converted identically.
+
+    The values are the same as MAME.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <QRgb>
+#include "stdint.hpp"
+
+// S16 Palette Format:
+//
+//  D15 : Shade hi/lo (unused)
+//  D14 : Blue bit 0
+//  D13 : Green bit 0
+//  D12 : Red bit 0
+//  D11 - D8 : Blue bits 4 - 1
+//  D7  - D4 : Green bits 4 - 1
+//  D3  - D0 : Red bits 4 - 1
+
+// Expand a 5-bit component to 8-bits
+constexpr uint32_t s16Level(uint32_t c, bool shadow)
+{
+    return shadow ? ((c * 255 / 31) * 202 / 256) : (c * 255 / 31);
+}
+
+constexpr uint32_t s16Red(uint32_t value)   { return ((value & 0x000f) << 1) | ((value >> 12) & 1); }
+constexpr uint32_t s16Green(uint32_t value) { return ((value & 0x00f0) >> 3) | ((value >> 13) & 1); }
+constexpr uint32_t s16Blue(uint32_t value)  { return ((value & 0x0f00) >> 7) | ((value >> 14) & 1); }
+
+constexpr QRgb s16ToRgb(uint32_t value, bool shadow)
+{
+    return qRgb(s16Level(s16Red(value),   shadow),
+                s16Level(s16Green(value), shadow),
+                s16Level(s16Blue(value),  shadow));
+}
+
+struct S16ColourTable
+{
+    // One entry per 15-bit colour
+    const static int ENTRIES = 0x8000;
+
+    QRgb rgb[ENTRIES];
+
+    explicit S16ColourTable(bool shadow);
+};
+
+extern const S16ColourTable S16_RGB;        // Normal colours
+extern const S16ColourTable S16_RGB_SHADOW; // Shadow / Hilight colours
+
+inline QRgb s16Rgb(uint16_t value)       { return S16_RGB.rgb[value & (S16ColourTable::ENTRIES - 1)]; }
+inline QRgb s16RgbShadow(uint16_t value) { return S16_RGB_SHADOW.rgb[value & (S16ColourTable::ENTRIES - 1)]; }
@@ -0,0 +1,57 @@
+/***************************************************************************
+    Save Task.
+
+    Saves the project in the background. The project is copied when the
+    task is created, so it can continue to be edited whilst the file is
+    written.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <QtConcurrent>
+#include "projectfile.hpp"
+#include "savetask.hpp"
+
+SaveTask::SaveTask(QObject* parent,
+                   const QString& filename,
+                   Levels* levels,
+                   HeightSection* heightSection,
+                   SpriteSection* spriteSection) :
+    QObject(parent),
+    snapshot(levels, heightSection, spriteSection)
+{
+    this->filename = filename;
+
+    connect(&watcher, SIGNAL(finished()), this, SLOT(done()));
+}
+
+SaveTask::~SaveTask()
+{
+    wait();
+}
+
+void SaveTask::start()
+{
+    watcher.setFuture(QtConcurrent::run(this, &SaveTask::run));
+}
+
+void SaveTask::wait()
+{
+    watcher.waitForFinished();
+}
+
+bool SaveTask::isRunning() const
+{
+    return watcher.isRunning();
+}
+
+bool SaveTask::run()
+{
+    return ProjectFile::write(filename, snapshot, &error);
+}
+
+void SaveTask::done()
+{
+    emit finished(watcher.result());
+}
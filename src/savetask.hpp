@@ -0,0 +1,54 @@
+/***************************************************************************
+    Save Task.
+
+    Saves the project in the background. The project is copied when the
+    task is created, so it can continue to be edited whilst the file is
+    written.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifndef SAVETASK_HPP
+#define SAVETASK_HPP
+
+#include <QObject>
+#include <QFutureWatcher>
+
+#include "projectsnapshot.hpp"
+
+class SaveTask : public QObject
+{
+    Q_OBJECT
+
+public:
+    SaveTask(QObject* parent,
+             const QString& filename,
+             Levels* levels,
+             HeightSection* heightSection,
+             SpriteSection* spriteSection);
+    ~SaveTask();
+
+    void start();
+    void wait();
+    bool isRunning() const;
+    QString getFilename() const { return filename; }
+    QString getError() const    { return error; }
+
+signals:
+    void finished(bool success);
+
+private slots:
+    void done();
+
+private:
+    QString filename;
+    const ProjectSnapshot snapshot;
+    QString error;
+
+    QFutureWatcher<bool> watcher;
+
+    bool run();
+};
+
+#endif // SAVETASK_HPP
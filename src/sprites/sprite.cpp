@@ -27,14 +27,12 @@ Sprite::~Sprite()
         delete image;
 }
 
-// Setup Sprite Data
-void Sprite::convertSpriteRom(uint8_t* rom, int length, QRgb* p)
+// Convert Sprite ROM to 32-bit words. Does not touch the sprite data in use, so can be run on any thread.
+uint32_t* Sprite::decodeSpriteRom(const uint8_t* rom, int length)
 {
-    pal = p;
-
     const uint8_t* spr = rom;
     int romLength = length >> 2;
-    data = new uint32_t[romLength];
+    uint32_t* words = new uint32_t[romLength];
 
     for (int i = 0; i < romLength; i++)
     {
@@ -43,8 +41,19 @@ void Sprite::convertSpriteRom(uint8_t* rom, int length, QRgb* p)
         uint8_t d1 = *spr++;
         uint8_t d0 = *spr++;
 
-        data[i] = (d0 << 24) | (d1 << 16) | (d2 << 8) | d3;
+        words[i] = (d0 << 24) | (d1 << 16) | (d2 << 8) | d3;
     }
+
+    return words;
+}
+
+// Setup Sprite Data. Takes ownership of the decoded ROM.
+// Nothing can be drawing a sprite whilst this is called.
+void Sprite::setSpriteData(uint32_t* d, QRgb* p)
+{
+    delete[] data;
+    data = d;
+    pal  = p;
 }
 
 
@@ -23,7 +23,8 @@ public:
 
     Sprite();
     ~Sprite();
-    static void convertSpriteRom(uint8_t*, int length, QRgb *p);
+    static uint32_t* decodeSpriteRom(const uint8_t*, int length);
+    static void setSpriteData(uint32_t* data, QRgb* p);
 
     void setSprite(const int bank, const int offset, const int width, const int height, const int pal);
     void setSprite(const int bank, const int offset, const int width, const int height, const bool flip, const int pal = -1);
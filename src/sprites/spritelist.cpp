@@ -44,6 +44,10 @@ void SpriteList::setList(QList<SpriteFormat> list)
 // Get Name of Sprite At Index
 QString SpriteList::getName(int index)
 {
+    // List is empty until the ROMs are loaded
+    if (index < 0 || index >= list.size())
+        return QString();
+
     return list.at(index).name;
 }
 
@@ -12,6 +12,8 @@
 #include "../previewpalette.hpp"
 #include "../levels/levels.hpp"
 
+#include "../thumbnailcache.hpp"
+
 #include "spritesection.hpp"
 #include "spritelist.hpp"
 
@@ -22,6 +24,7 @@ SpriteSection::SpriteSection(QObject *parent, QList<SpriteSectionEntry>* section
     this->spriteList  = spriteList;  // Sprite Manager
     this->view        = view;        // UI: The Tree view visualizing the sprites that the user can select them from
     this->levels      = levels;
+    this->thumbnails  = NULL;
 
     disableUpdates = false;
 
@@ -62,6 +65,7 @@ void SpriteSection::generateEntries()
     }
 
     view->resizeColumnToContents(0);
+    levels->getChanges()->notifySceneryPattern();
     emit setInsertSecBut(sectionList->size() < 255);
     clearSelection();
 }
@@ -86,10 +90,37 @@ void SpriteSection::generateEntries(QList<QString> sectionNames, QList<QString>
 
         parentItem->appendRow(item);
     }
+    levels->getChanges()->notifySceneryPattern();
     emit setInsertSecBut(sectionList->size() < 255);
     clearSelection();
 }
 
+void SpriteSection::setThumbnails(ThumbnailCache* thumbnails)
+{
+    this->thumbnails = thumbnails;
+    view->setIconSize(QSize(ThumbnailCache::PATTERN_WIDTH, ThumbnailCache::PATTERN_HEIGHT));
+    connect(levels->getChanges(), SIGNAL(sceneryPatternChanged(int)), this, SLOT(updateThumbnails(int)));
+    updateThumbnails(LevelChanges::ALL_PATTERNS);
+}
+
+void SpriteSection::updateThumbnails(int index)
+{
+    if (thumbnails == NULL)
+        return;
+
+    QStandardItemModel* model = (QStandardItemModel*) view->model();
+    const int rows = qMin(model->rowCount(), sectionList->size());
+    const QList<SpriteFormat>& sprites = *spriteList->getList();
+
+    if (index == LevelChanges::ALL_PATTERNS)
+    {
+        for (int i = 0; i < rows; i++)
+            thumbnails->setSceneryThumbnail(model->item(i), sectionList->at(i), sprites);
+    }
+    else if (index < rows)
+        thumbnails->setSceneryThumbnail(model->item(index), sectionList->at(index), sprites);
+}
+
 void SpriteSection::clearSelection()
 {
     view->selectionModel()->clear();
@@ -162,11 +193,13 @@ void SpriteSection::itemSelected()
     disableUpdates = true;
 
     // Deselect any previous selections
+    int previousIndex = -1;
     for (int i = 0; i < sectionList->length(); i++)
     {
         if ((*sectionList)[i].selected)
         {
            (*sectionList)[i].selected = false;
+           previousIndex = i;
 
             QList<SpriteEntry>* se = &(*sectionList)[i].sprites;
 
@@ -217,6 +250,14 @@ void SpriteSection::itemSelected()
         emit updateDensityL(false);
     }
 
+    // Selected scenery is highlighted in the preview. Selection isn't an edit of the patterns.
+    const int currentIndex = currentSection != NULL ? getCurrentSectionID() : -1;
+
+    if (previousIndex != -1 && previousIndex != currentIndex)
+        levels->getChanges()->notifyScenerySelection(previousIndex);
+    if (currentIndex != -1)
+        levels->getChanges()->notifyScenerySelection(currentIndex);
+
     emit refreshPreview();
     disableUpdates = false;
 }
@@ -265,6 +306,15 @@ void SpriteSection::recalculateDensity(SpriteSectionEntry *currentSection)
     emit updateDensityL(currentSection->density > SpriteSectionEntry::DENSITY_MAX);
 }
 
+// Report an edit to the selected section
+void SpriteSection::sectionChanged()
+{
+    if (isSectionSelected())
+        levels->getChanges()->notifySceneryPattern(getCurrentSectionID());
+
+    emit refreshPreview();
+}
+
 bool SpriteSection::isSectionSelected()
 {
     QModelIndex index = view->selectionModel()->currentIndex();
@@ -369,6 +419,8 @@ void SpriteSection::newEntry()
         QModelIndex mi = view->model()->index(irow+1, 0);
         view->setCurrentIndex(mi);
     }
+
+    levels->getChanges()->notifySceneryPattern(parent.isValid() ? prow : LevelChanges::ALL_PATTERNS);
 }
 
 // Delete either a sprite entry or a complete section depending on what was selected
@@ -401,6 +453,7 @@ void SpriteSection::deleteEntry()
         emit setInsertSecBut(sectionList->size() < 255);
     }
 
+    levels->getChanges()->notifySceneryPattern(parent.isValid() ? prow : LevelChanges::ALL_PATTERNS);
     emit refreshPreview();
 }
 
@@ -444,6 +497,8 @@ void SpriteSection::duplicateEntry()
         levels->remapScenerySections(irow+1, 1);
         emit setInsertSecBut(sectionList->size() < 255);
     }
+
+    levels->getChanges()->notifySceneryPattern(parent.isValid() ? prow : LevelChanges::ALL_PATTERNS);
 }
 
 void SpriteSection::moveUp()
@@ -486,6 +541,8 @@ void SpriteSection::moveUp()
         levels->swapScenerySections(irow, irow-1);
         view->selectionModel()->setCurrentIndex(swap1->index(), QItemSelectionModel::ClearAndSelect);
     }
+
+    levels->getChanges()->notifySceneryPattern(parent.isValid() ? prow : LevelChanges::ALL_PATTERNS);
 }
 
 void SpriteSection::moveDown()
@@ -530,6 +587,8 @@ void SpriteSection::moveDown()
             view->selectionModel()->setCurrentIndex(swap1->index(), QItemSelectionModel::ClearAndSelect);
         }
     }
+
+    levels->getChanges()->notifySceneryPattern(parent.isValid() ? prow : LevelChanges::ALL_PATTERNS);
 }
 
 void SpriteSection::setFrequency(int freq)
@@ -542,6 +601,7 @@ void SpriteSection::setFrequency(int freq)
     {
         currentSection->frequency = freq;
         recalculateDensity(getCurrentSection());
+        levels->getChanges()->notifySceneryPattern(getCurrentSectionID());
     }
 }
 
@@ -555,7 +615,7 @@ void SpriteSection::setShadow(bool enabled)
     {
         currentSprite->props = (currentSprite->props & 0xFD) + (enabled ? 2 : 0);
         recalculateDensity(getCurrentSection());
-        emit refreshPreview();
+        sectionChanged();
     }
 }
 
@@ -569,7 +629,7 @@ void SpriteSection::setHFlip(bool enabled)
     {
         currentSprite->props = (currentSprite->props & 0xFE) + (enabled ? 1 : 0);
         spriteList->setEntry(currentSprite->type, currentSprite->props & 1, currentSprite->pal);
-        emit refreshPreview();
+        sectionChanged();
     }
 }
 
@@ -596,7 +656,7 @@ void SpriteSection::setSprite(QString name, int type)
         recalculateDensity(getCurrentSection());
 
         emit updateSprProps(currentSprite);
-        emit refreshPreview();
+        sectionChanged();
     }
 
     disableUpdates = false;
@@ -611,7 +671,7 @@ void SpriteSection::setSpriteX(int x)
     if (currentSprite != NULL)
     {
         currentSprite->x = (int8_t) x;
-        emit refreshPreview();
+        sectionChanged();
     }
 }
 
@@ -624,7 +684,7 @@ void SpriteSection::setSpriteY(int y)
     if (currentSprite != NULL)
     {
         currentSprite->y = (int16_t) y;
-        emit refreshPreview();
+        sectionChanged();
     }
 }
 
@@ -638,7 +698,7 @@ void SpriteSection::setSpriteP(int pal)
     {
         currentSprite->pal = pal;
         spriteList->setEntry(currentSprite->type, currentSprite->props & 1, currentSprite->pal);
-        emit refreshPreview();
+        sectionChanged();
     }
 }
 
@@ -659,6 +719,6 @@ void SpriteSection::setDrawRoutine(int routine)
             spriteList->setEntry(currentSprite->type, currentSprite->props & 1, currentSprite->pal);
         }
 
-        emit refreshPreview();
+        sectionChanged();
     }
 }
@@ -12,6 +12,7 @@ class QStandardItemModel;
 class QItemSelectionModel;
 class PreviewPalette;
 class Levels;
+class ThumbnailCache;
 
 class SpriteSection : public QObject
 {
@@ -29,6 +30,7 @@ public:
     QString getSpriteName(int, int);
     void setSpriteName(int, int, QString);
     bool isSectionSelected();
+    void setThumbnails(ThumbnailCache* thumbnails);
     
 signals:
     void updateDensity(int);
@@ -56,6 +58,7 @@ public slots:
     
 private slots:
     void itemSelected();
+    void updateThumbnails(int index);
 
 private:
     QList<SpriteSectionEntry>* sectionList;
@@ -63,6 +66,9 @@ private:
 
     Levels* levels;
 
+    // Sprites in each section
+    ThumbnailCache* thumbnails;
+
     // Used to disable updates when changing between sprite entries as otherwise you
     // end up with a situation where:
     // Sprite Section Class Changes Sprite -> Change Control Values -> Send Signal Notifying Change -> Sprite Section Class Updates Sprite Data
@@ -79,6 +85,7 @@ private:
     int getCurrentSpriteID();
 
     void recalculateDensity(SpriteSectionEntry* currentSection);
+    void sectionChanged();
     void calculateDensity(SpriteSectionEntry* currentSection);
 
 };
@@ -0,0 +1,305 @@
+/***************************************************************************
+    Thumbnail Cache.
+
+    Small images shown alongside the levels, height patterns and scenery
+    patterns in their lists.
+
+    Thumbnails are drawn on worker threads from a copy of the data, and
+    cached by a hash of that data. An item that changes back to something
+    that has been seen before picks up its thumbnail straight away.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <iostream>
+#include <QPainter>
+#include <QPolygon>
+#include <QPixmap>
+#include <QStandardItem>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+#include "leveldata.hpp"
+#include "height/heightwidget.hpp"
+#include "sprites/sprite.hpp"
+#include "thumbnailcache.hpp"
+
+// FNV-1a hash of the data a thumbnail is drawn from
+class ThumbnailHash
+{
+public:
+    quint64 value;
+
+    // Salt the hash, so different types of thumbnail never share a key
+    explicit ThumbnailHash(int type) : value(14695981039346656037ULL) { add(type); }
+
+    void add(int v)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            value ^= (v >> (i * 8)) & 0xFF;
+            value *= 1099511628211ULL;
+        }
+    }
+};
+
+ThumbnailCache::ThumbnailCache(QObject *parent) :
+    QObject(parent)
+{
+    icons.setMaxCost(CACHE_SIZE);
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    pool.waitForDone();
+}
+
+// ------------------------------------------------------------------------------------------------
+// Requests. The data is hashed and copied here, so it can be edited whilst thumbnails are drawn.
+// ------------------------------------------------------------------------------------------------
+
+void ThumbnailCache::setLevelThumbnail(QStandardItem* item, const LevelData* level)
+{
+    QVector<QPoint> path;
+    ThumbnailHash hash(0);
+
+    for (int i = 0; i < level->end_pos; i++)
+    {
+        const QPoint p = level->path_render[i];
+        path.push_back(p);
+        hash.add(p.x());
+        hash.add(p.y());
+    }
+
+    if (request(item, hash.value))
+        start(hash.value, QtConcurrent::run(&pool, drawLevel, path));
+}
+
+void ThumbnailCache::setHeightThumbnail(QStandardItem* item, const HeightSegment& segment)
+{
+    ThumbnailHash hash(1);
+    hash.add(segment.type);
+    hash.add(segment.step);
+    hash.add(segment.value1);
+    hash.add(segment.value2);
+
+    foreach (int16_t v, segment.data)
+        hash.add(v);
+
+    if (request(item, hash.value))
+        start(hash.value, QtConcurrent::run(&pool, drawHeight, segment));
+}
+
+void ThumbnailCache::setSceneryThumbnail(QStandardItem* item, const SpriteSectionEntry& section, const QList<SpriteFormat>& sprites)
+{
+    // Sprite ROMs not loaded
+    if (sprites.isEmpty())
+        return;
+
+    ThumbnailHash hash(2);
+
+    foreach (SpriteEntry entry, section.sprites)
+    {
+        hash.add(entry.type);
+        hash.add(entry.pal);
+        hash.add(entry.props & 1);
+    }
+
+    if (request(item, hash.value))
+        start(hash.value, QtConcurrent::run(&pool, drawScenery, section, sprites));
+}
+
+// Discard all thumbnails. For example, when the ROMs are reloaded.
+// Waits for thumbnails being drawn, as they read the sprite data.
+void ThumbnailCache::clear()
+{
+    pool.waitForDone();
+
+    foreach (QObject* watcher, jobs.keys())
+    {
+        disconnect(watcher, 0, this, 0);
+        watcher->deleteLater();
+    }
+
+    jobs.clear();
+    waiting.clear();
+    icons.clear();
+}
+
+// Set the thumbnail on the item if it's cached.
+// Returns true if the thumbnail needs to be drawn.
+bool ThumbnailCache::request(QStandardItem* item, quint64 key)
+{
+    item->setData(QVariant((qulonglong) key), KEY_ROLE);
+
+    QIcon* icon = icons.object(key);
+    if (icon != NULL)
+    {
+        item->setIcon(*icon);
+        return false;
+    }
+
+    // The previous thumbnail is shown until the new one is ready
+    const bool drawing = waiting.contains(key);
+    waiting[key].push_back(QPersistentModelIndex(item->index()));
+    return !drawing;
+}
+
+void ThumbnailCache::start(quint64 key, QFuture<QImage> future)
+{
+    QFutureWatcher<QImage>* watcher = new QFutureWatcher<QImage>(this);
+    jobs.insert(watcher, key);
+    connect(watcher, SIGNAL(finished()), this, SLOT(jobFinished()));
+    watcher->setFuture(future);
+}
+
+void ThumbnailCache::jobFinished()
+{
+    QFutureWatcher<QImage>* watcher = static_cast<QFutureWatcher<QImage>*>(sender());
+    const quint64 key = jobs.take(watcher);
+    const QIcon icon(QPixmap::fromImage(watcher->result()));
+    watcher->deleteLater();
+
+    // Only update items that still expect this thumbnail
+    foreach (QPersistentModelIndex index, waiting.take(key))
+    {
+        if (index.isValid() && index.data(KEY_ROLE).toULongLong() == key)
+            const_cast<QAbstractItemModel*>(index.model())->setData(index, icon, Qt::DecorationRole);
+    }
+
+    icons.insert(key, new QIcon(icon));
+
+    if (DEBUG)
+        std::cout << "ThumbnailCache: drawn " << std::hex << key << std::dec << " (" << icons.size() << " cached)" << std::endl;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Drawing. Called on worker threads.
+// ------------------------------------------------------------------------------------------------
+
+// Top down outline of the road path
+QImage ThumbnailCache::drawLevel(QVector<QPoint> path)
+{
+    QImage image(LEVEL_SIZE, LEVEL_SIZE, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    if (path.size() < 2)
+        return image;
+
+    const static int MARGIN = 2;
+    const QRect bounds = QPolygon(path).boundingRect();
+    const qreal scale  = qMin((LEVEL_SIZE - (MARGIN * 2)) / (qreal) qMax(bounds.width(), 1),
+                              (LEVEL_SIZE - (MARGIN * 2)) / (qreal) qMax(bounds.height(), 1));
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(LEVEL_SIZE / 2.0, LEVEL_SIZE / 2.0);
+    painter.scale(scale, scale);
+    painter.translate(-bounds.center());
+
+    QPen pen(QColor(80, 80, 80));
+    pen.setCosmetic(true);
+    pen.setWidthF(1.5);
+    painter.setPen(pen);
+    painter.drawPolyline(path.constData(), path.size());
+
+    // Mark the start of the level
+    pen.setColor(QColor(0, 160, 0));
+    pen.setWidthF(4);
+    painter.setPen(pen);
+    painter.drawPoint(path.first());
+
+    return image;
+}
+
+// Elevation curve of a height pattern
+QImage ThumbnailCache::drawHeight(HeightSegment segment)
+{
+    QImage image(PATTERN_WIDTH, PATTERN_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QColor(40, 90, 200));
+
+    // Heights in screen direction, as the height pattern editor draws them
+    QList<int> heights;
+
+    switch (segment.type)
+    {
+        case 0:
+        case 3:
+            heights = HeightWidget::accumulateHeights(segment);
+            break;
+
+        // Rise to the first height, hold it and then move to the second
+        case 1:
+        case 2:
+            if (segment.data.size() >= 2)
+                heights << 0 << -segment.data.at(0) << -segment.data.at(0) << -segment.data.at(1);
+            break;
+    }
+
+    // Horizon changes leave the road flat. Drawn dashed, as only the horizon moves.
+    if (heights.size() < 2)
+    {
+        if (segment.type == 4)
+            painter.setPen(QPen(QColor(40, 90, 200), 1, Qt::DashLine));
+
+        painter.drawLine(0, PATTERN_HEIGHT / 2, PATTERN_WIDTH - 1, PATTERN_HEIGHT / 2);
+        return image;
+    }
+
+    int min = heights.first();
+    int max = min;
+    for (int i = 0; i < heights.size(); i++)
+    {
+        min = qMin(min, heights.at(i));
+        max = qMax(max, heights.at(i));
+    }
+
+    const qreal xScale = (PATTERN_WIDTH - 1) / (qreal) (heights.size() - 1);
+    const qreal yScale = (PATTERN_HEIGHT - 3) / (qreal) qMax(max - min, 1);
+
+    QPolygonF curve;
+    for (int i = 0; i < heights.size(); i++)
+        curve << QPointF(i * xScale, 1 + ((heights.at(i) - min) * yScale));
+
+    painter.drawPolyline(curve);
+    return image;
+}
+
+// Sprites in a scenery pattern, side by side
+QImage ThumbnailCache::drawScenery(SpriteSectionEntry section, QList<SpriteFormat> sprites)
+{
+    QImage image(PATTERN_WIDTH, PATTERN_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    int x = 0;
+
+    foreach (SpriteEntry entry, section.sprites)
+    {
+        if (x >= PATTERN_WIDTH)
+            break;
+
+        if (entry.type >= sprites.size())
+            continue;
+
+        const SpriteFormat& format = sprites.at(entry.type);
+
+        Sprite sprite;
+        sprite.setSprite(format.bank, format.offset, format.width, format.height, entry.props & 1, entry.pal);
+
+        // Scale to the height of the strip
+        const int h = PATTERN_HEIGHT;
+        const int w = qMax(1, (sprite.image->width() * h) / qMax(sprite.image->height(), 1));
+
+        painter.drawImage(QRect(x, 0, w, h), *sprite.image);
+        x += w + 1;
+    }
+
+    return image;
+}
@@ -0,0 +1,83 @@
+/***************************************************************************
+    Thumbnail Cache.
+
+    Small images shown alongside the levels, height patterns and scenery
+    patterns in their lists.
+
+    Thumbnails are drawn on worker threads from a copy of the data, and
+    cached by a hash of that data. An item that changes back to something
+    that has been seen before picks up its thumbnail straight away.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QList>
+#include <QVector>
+#include <QPoint>
+#include <QFuture>
+#include <QThreadPool>
+#include <QPersistentModelIndex>
+
+#include "stdint.hpp"
+#include "height/heightformat.hpp"
+#include "sprites/spriteformat.hpp"
+
+class QStandardItem;
+class LevelData;
+
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Item data role used to store the hash of the thumbnail an item expects
+    const static int KEY_ROLE = Qt::UserRole + 16;
+
+    // Thumbnail sizes
+    const static int LEVEL_SIZE     = 32;
+    const static int PATTERN_WIDTH  = 48;
+    const static int PATTERN_HEIGHT = 16;
+
+    explicit ThumbnailCache(QObject *parent = 0);
+    ~ThumbnailCache();
+
+    void setLevelThumbnail(QStandardItem* item, const LevelData* level);
+    void setHeightThumbnail(QStandardItem* item, const HeightSegment& segment);
+    void setSceneryThumbnail(QStandardItem* item, const SpriteSectionEntry& section, const QList<SpriteFormat>& sprites);
+    void clear();
+
+private slots:
+    void jobFinished();
+
+private:
+    const static bool DEBUG = false;
+
+    // Number of thumbnails held
+    const static int CACHE_SIZE = 1024;
+
+    QCache<quint64, QIcon> icons;
+
+    // Items waiting for each thumbnail being drawn
+    QHash<quint64, QList<QPersistentModelIndex> > waiting;
+
+    // Thumbnail being drawn by each job
+    QHash<QObject*, quint64> jobs;
+
+    // Thumbnails use their own threads, so they don't hold up the preview
+    QThreadPool pool;
+
+    bool request(QStandardItem* item, quint64 key);
+    void start(quint64 key, QFuture<QImage> future);
+
+    static QImage drawLevel(QVector<QPoint> path);
+    static QImage drawHeight(HeightSegment segment);
+    static QImage drawScenery(SpriteSectionEntry section, QList<SpriteFormat> sprites);
+};
@@ -6,6 +6,7 @@
     See license.txt for more details.
 ***************************************************************************/
 
+#include "s16colour.hpp"
 #include "utils.hpp"
 
 // S16 Palette Format Reference
@@ -48,24 +49,10 @@ uint16_t Utils::convertToS16(QColor value)
 
 // Convert Single S16 Palette Entry to QT Format
 // S16: Each value ranges from 0 to 31
-// QT : Each value shoudl range from 0 to 255, but we scale from 0 to 248 to avoid data loss
+// QT : Each value ranges from 0 to 255. Converting back to S16 is lossless.
 QRgb Utils::convertToQT(uint16_t value)
 {
-    uint32_t r = (value & 0x000f) << 1; // r rrr0
-    uint32_t g = (value & 0x00f0) >> 3; // g ggg0
-    uint32_t b = (value & 0x0f00) >> 7; // b bbb0
-    if ((value & 0x1000) != 0)
-        r |= 1; // r rrrr
-    if ((value & 0x2000) != 0)
-        g |= 1; // g gggg
-    if ((value & 0x4000) != 0)
-        b |= 1; // b bbbb
-
-    r = r * 8;
-    g = g * 8;
-    b = b * 8;
-
-    return qRgb(r, g, b);
+    return s16Rgb(value);
 }
 
 // Convert S16 Sprite Palette to QT Format